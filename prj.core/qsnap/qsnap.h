@@ -191,6 +191,13 @@ QSNAP_API QError CheckNode
   bool bCheck                         // [in]  выделить/убрать выделение
 );
 
+// состояние вершины: обновляется библиотекой, читается вызывающим напрямую
+// (state->checked()) без вызова функций библиотеки; действительно, пока существует дерево
+QSNAP_API const SnapState* GetNodeState // [ret] состояние, NULL для пустого хэндла
+(
+  QSnapNode hNode                     // [in]  хэндл вершины
+);
+
 // получение вершины - родителя
 QSNAP_API QSnapNode GetParentNode     // [ret] хэндл родительской вершины
 (
@@ -255,7 +262,8 @@ QSNAP_API QError SetNodeProperty
   NodePropertyInfo* pNodeProperty    // [in]  свойство
 );
 
-// получение свойства вершины
+// получение свойства вершины: копия значения действительна в вызывающем потоке
+// до следующего запроса этого свойства вершины (изменение в окне ее не затрагивает)
 QSNAP_API const char* GetNodeValue   // [ret] значение свойства, NULL если свойство не существует
 (
   QSnapNode hNode,                   // [in]  хэндл вершины
@@ -309,6 +317,48 @@ QSNAP_API QError SaveNodeProperty
   const char* sKey                   // [in]  название свойства
 );
 
+// описание типа, диапазона и значения по умолчанию свойства вершины;
+// текущее значение приводится к типу, дальнейшие SetNodeValue проверяются
+QSNAP_API QError DefineNodeProperty
+(
+  QSnapNode hNode,                   // [in]  хэндл вершины
+  const PropertyDef* pDef            // [in]  описание свойства
+);
+
+// типизированное значение свойства: обновляется библиотекой, читается вызывающим
+// напрямую (value->toInt()) без разбора строки; действительно, пока существует вершина.
+// Значение создается при первом запросе: до добавления свойства оно нулевое (version = 0)
+QSNAP_API const PropValue* GetNodePropertyValue // [ret] значение, NULL при неверной вершине или названии
+(
+  QSnapNode hNode,                   // [in]  хэндл вершины
+  const char* sKey                   // [in]  название свойства
+);
+
+// счетчик изменений свойств вершины (увеличивается при любом изменении)
+QSNAP_API const std::atomic<unsigned>* GetNodePropertiesVersion // [ret] счетчик, NULL для пустого хэндла
+(
+  QSnapNode hNode                    // [in]  хэндл вершины
+);
+
+// связывание свойства вершины с переменной приложения: переменная сразу получает
+// значение свойства (свойство без значения создается из переменной), дальнейшие
+// изменения свойства записываются в std::atomic сразу, в обычные переменные -
+// в потоке приложения при ApplyNodeBindings и по завершении WaitUserInput.
+// Переменная должна существовать до отмены связи (pVar = NULL)
+QSNAP_API QError BindNodeProperty
+(
+  QSnapNode hNode,                   // [in]  хэндл вершины
+  const char* sKey,                  // [in]  название свойства
+  SnpBindType type,                  // [in]  тип переменной
+  void* pVar                         // [in]  адрес переменной (NULL - отмена связи)
+);
+
+// запись измененных значений свойств в связанные обычные переменные;
+// вызывается в потоке, читающем переменные (без изменений - одно атомарное чтение)
+QSNAP_API int ApplyNodeBindings     // [ret] количество записанных значений
+(
+);
+
 ////////////////////////////////////////////////////////
 //////    Работа с окном лога QTextView
 ////////////////////////////////////////////////////////
@@ -343,11 +393,43 @@ QSNAP_API QError LogLn
   ...                                // [in]  параметры шаблона
 );
 
-// вывод расширенного текстового сообщения
-QSNAP_API QError LogEx
+// отложенный вывод текстового сообщения: строка формата и аргументы сохраняются
+// без форматирования, сообщение форматируется в потоке окна при выводе
+QSNAP_API QError LogArgs
+(
+  QHandle       hView,               // [in]  хэндл окна
+  const char*   sFormat,             // [in]  строка формата printf (должна существовать до вывода, обычно литерал)
+  const LogArg* args,                // [in]  аргументы
+  int           nArgs,               // [in]  количество аргументов
+  bool          bNewLine             // [in]  завершить сообщение переводом строки
+);
+
+// отложенный вывод сообщения уровня level: строка оформляется цветом уровня
+QSNAP_API QError LogArgsAt
+(
+  QHandle       hView,               // [in]  хэндл окна
+  LogLevel      level,               // [in]  уровень сообщения LL_*
+  const char*   sFormat,             // [in]  строка формата printf (должна существовать до вывода, обычно литерал)
+  const LogArg* args,                // [in]  аргументы
+  int           nArgs,               // [in]  количество аргументов
+  bool          bNewLine             // [in]  завершить сообщение переводом строки
+);
+
+// вывод текстового сообщения уровня level отдельной строкой: строка оформляется цветом уровня
+QSNAP_API QError LogLnAt
 (
   QHandle     hView,                 // [in]  хэндл окна
+  LogLevel    level,                 // [in]  уровень сообщения LL_*
   const char* sText,                 // [in]  текстовый шаблон
+  ...                                // [in]  параметры шаблона
+);
+
+// вывод расширенного текстового сообщения: строки, начатые сообщением, выводятся
+// цветом color и шрифтом flags (FF_BOLD, FF_ITALIC, FF_UNDERLINED)
+QSNAP_API QError LogEx
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sText,                 // [in]  текст сообщения (выводится без форматирования)
   SnpColor    color,                 // [in]  цвет текста
   FontFlags   flags                  // [in]  параметры шрифта
 );
@@ -358,6 +440,56 @@ QSNAP_API QError ClearTextView
   QHandle     hView                  // [in]  хэндл окна
 );
 
+// ограничение объема текстового окна: при превышении вытесняются старые строки
+QSNAP_API QError SetLogLimits
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  int         maxLines,              // [in]  максимальное количество строк (0 - по умолчанию)
+  long long   maxBytes               // [in]  максимальный объем текста в байтах (0 - по умолчанию)
+);
+
+// выгрузка вытесненных строк текстового окна в отображаемые в память файлы-сегменты
+// с ротацией по размеру: строки остаются доступны при прокрутке, при превышении
+// maxSegments удаляются самые старые сегменты; при выключении, повторной настройке
+// и очистке окна файлы удаляются
+QSNAP_API QError SetLogSpill
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sDir,                  // [in]  каталог файлов выгрузки (NULL или "" - выключить)
+  long long   segmentBytes,          // [in]  размер файла-сегмента (0 - по умолчанию)
+  int         maxSegments            // [in]  максимальное количество сегментов (0 - без ограничения)
+);
+
+// фильтр уровня и каналов текстового окна: проверяется вызывающим до форматирования,
+// переключается из окна или функциями SetLogLevel/EnableLogChannel
+QSNAP_API const LogFilter* GetLogFilter // [ret] фильтр, NULL для окна другого типа
+(
+  QHandle     hView                  // [in]  хэндл окна
+);
+
+// регистрация именованного канала лога (повторная регистрация возвращает тот же номер)
+QSNAP_API int RegisterLogChannel     // [ret] номер канала, -1 при ошибке
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sName,                 // [in]  имя канала
+  bool        bEnabled               // [in]  начальное состояние канала
+);
+
+// включение/отключение канала лога
+QSNAP_API QError EnableLogChannel
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  int         channel,               // [in]  номер канала
+  bool        bEnable                // [in]  включить канал
+);
+
+// установка минимального уровня выводимых сообщений
+QSNAP_API QError SetLogLevel
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  LogLevel    level                  // [in]  уровень LL_*
+);
+
 ////////////////////////////////////////////////////////
 //////    Работа с окном показа изображения QImageView
 ////////////////////////////////////////////////////////
@@ -396,6 +528,28 @@ QSNAP_API QError SetSubMatImage
   ImageFlags    flagsShow            // [in]  флаги показа изображения
 );
 
+// установка соответствий точек двух окон SyncImageView (линии поверх окон)
+// -- соответствия рисуются одним проходом, заменяют предыдущие; nMatches==0 - удаление
+// -- при заданных оценках под окнами показывается ползунок порога оценки
+QSNAP_API QError SetMatches
+(
+  QHandle       hView,               // [in]  хэндл окна
+  const SnpPoint* ptsFrom,           // [in]  точки первого окна
+  const SnpPoint* ptsTo,             // [in]  точки второго окна
+  const float*  scores,              // [in]  оценки соответствий (NULL - без оценок)
+  const SnpColor* colors,            // [in]  цвета соответствий (NULL - цвет color)
+  int           nMatches,            // [in]  количество соответствий
+  int           lineWidth,           // [in]  толщина линий
+  SnpColor      color                // [in]  цвет по умолчанию
+);
+
+// установка порога оценки показываемых соответствий (см. SetMatches)
+QSNAP_API QError SetMatchThreshold
+(
+  QHandle       hView,               // [in]  хэндл окна
+  float         threshold            // [in]  показываются соответствия с оценкой >= threshold
+);
+
 #ifdef __MINIMG__
 
 // установка изображения хранимого в MinImg
@@ -568,11 +722,25 @@ QSNAP_API void SortListViewItems
 ////////////////////////////////////////////////////////
 
 // установка коэффициента масштабирования фигур в координатах изображения
+// (применяется при отрисовке, в том числе к уже добавленным фигурам группы)
 QSNAP_API QError SetScaleFactor
 (
   QHandle       hView,              // [in] хэндл окна
   double        scale,              // [in] координата по горизонтали
-  const char*   idGroup             // [in] идентификатор группы фигур (not implemented)
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// установка преобразования группы фигур: точка фигуры (x,y) выводится в
+// offset + rotate(rotation) * scale * (x,y); фигуры хранятся в своих координатах,
+// смена преобразования не пересчитывает их
+QSNAP_API QError SetGroupTransform
+(
+  QHandle       hView,              // [in] хэндл окна
+  double        scale,              // [in] коэффициент масштабирования
+  double        dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+  double        dy,                 // [in] сдвиг по вертикали (в координатах изображения)
+  double        rotation,           // [in] поворот, градусы (по часовой стрелке на экране)
+  const char*   idGroup             // [in] идентификатор группы фигур
 );
 
 // отрисовка точки
@@ -612,6 +780,7 @@ QSNAP_API QHandle DrawRect          // [ret] хэндл фигуры
 );
 
 // отрисовка многоугольника, ломанной
+// -- при уменьшении изображения рисуется упрощенная копия (Douglas-Peucker)
 QSNAP_API QHandle DrawPolygon       // [ret] хэндл фигуры
 (
   QHandle       hView,              // [in] хэндл окна
@@ -619,7 +788,8 @@ QSNAP_API QHandle DrawPolygon       // [ret] хэндл фигуры
   int*          szPoints,           // [in,out] размер массива точек
   int           lineWidth,          // [in] толщина линии
   SnpColor      color,              // [in] цвет
-  PolygonType   type                // [in] тип многоугольника (ломаная, замкнутый и т.д.)
+  PolygonType   type,               // [in] тип многоугольника (ломаная, замкнутый и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
 );
 
 // отрисовка эллипса
@@ -633,11 +803,14 @@ QSNAP_API QHandle DrawEllipse       // [ret] хэндл фигуры
   const char*   idGroup             // [in] идентификатор группы фигур
 );
 
-// отрисовка дуги
+// отрисовка дуги эллипса
+// -- углы в градусах, 0 - направление "на 3 часа", положительные - против часовой стрелки
 QSNAP_API QHandle DrawArc           // [ret] хэндл фигуры
 (
   QHandle       hView,              // [in] хэндл окна
-//  ...                             // [in] параметры дуги
+  SnpRect*      pRect,              // [in] координаты охватывающего прямоугольника эллипса
+  double        startAngle,         // [in] начальный угол дуги
+  double        spanAngle,          // [in] угловой размер дуги
   int           lineWidth,          // [in] толщина линии
   SnpColor      color,              // [in] цвет
   LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
@@ -656,13 +829,148 @@ QSNAP_API QHandle DrawText          // [ret] хэндл текста
   const char*   idGroup             // [in] идентификатор группы фигур
 );
 
+// отрисовка массива точек одной фигурой
+// -- массив совместим по расположению в памяти с std::vector<cv::Point>
+QSNAP_API QHandle DrawPoints        // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] массив точек
+  int           nPoints,            // [in] количество точек
+  int           ptWidth,            // [in] толщина точки (диаметр)
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// отрисовка массива линий одной фигурой
+// -- линия i задается парой точек points[2*i], points[2*i+1]
+QSNAP_API QHandle DrawLines         // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] пары точек (начало, конец), 2*nLines элементов
+  int           nLines,             // [in] количество линий
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// отрисовка массива прямоугольников одной фигурой
+// -- массив совместим по расположению в памяти с std::vector<cv::Rect>
+QSNAP_API QHandle DrawRects         // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpRect* rects,             // [in] массив прямоугольников
+  int           nRects,             // [in] количество прямоугольников
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// отрисовка набора ломаных (контуров) одной фигурой
+// -- точки всех ломаных идут подряд, szPolylines[i] - количество точек i-й ломаной
+QSNAP_API QHandle DrawPolylines     // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] точки всех ломаных подряд
+  const int*    szPolylines,        // [in] количество точек в каждой ломаной
+  int           nPolylines,         // [in] количество ломаных
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  PolygonType   type,               // [in] тип (замкнутый многоугольник, ломаная)
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// отрисовка облака точек (до миллионов точек) одной фигурой
+// -- точки накапливаются в растр экранного разрешения, растр перестраивается
+// -- только при изменении масштаба или самих точек
+QSNAP_API QHandle DrawPointCloud    // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] массив точек
+  int           nPoints,            // [in] количество точек
+  int           ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+  SnpColor      color,              // [in] цвет
+  PointCloudType type,              // [in] режим отрисовки (плотность, пятна)
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// отрисовка траектории (ломаной, к которой добавляются точки функцией AppendPoint)
+// -- при maxLength > 0 хранятся последние maxLength точек
+QSNAP_API QHandle DrawTrajectory    // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] начальные точки (может быть NULL)
+  int           nPoints,            // [in] количество точек
+  int           maxLength,          // [in] максимальное количество точек (0 - без ограничения)
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// добавление точки в конец траектории
+// -- перерисовывается только прямоугольник нового отрезка
+QSNAP_API QError AppendPoint
+(
+  QHandle       hFigure,            // [in] хэндл траектории (DrawTrajectory)
+  int           x,                  // [in] координата по горизонтали
+  int           y                   // [in] координата по вертикали
+);
+
+// установка полупрозрачного оверлея изображения (маска меток, тепловая карта)
+// -- один оверлей на группу фигур, повторный вызов заменяет его; пустая матрица - удаление
+// -- CV_8UC1: значения - индексы палитры; CV_32FC1: значения 0..1 квантуются в 256 уровней
+// -- смешивание по палитре, показ/скрытие класса (SetOverlayClassVisible) и группы
+// -- (ShowGroup) не пересчитывают пиксели оверлея
+QSNAP_API QError SetOverlayMat
+(
+  QHandle       hView,              // [in] хэндл окна
+  const cv::Mat* pMat,              // [in] матрица оверлея (размер изображения)
+  OverlayColormap colormap,         // [in] палитра
+  const SnpColor* pLut,             // [in] собственная палитра из 256 цветов (NULL - палитра colormap)
+  double        alpha,              // [in] непрозрачность 0..1
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
+// показ/скрытие класса (значения) оверлея изображения
+QSNAP_API QError SetOverlayClassVisible
+(
+  QHandle       hView,              // [in] хэндл окна
+  int           label,              // [in] значение (индекс палитры)
+  bool          bShow,              // [in] показать/скрыть
+  const char*   idGroup             // [in] идентификатор группы фигур
+);
+
 // функция показа/скрытия фигуры
+// -- хэндл фигуры остается действительным до ее удаления (RemoveFigure, ClearGroup, ClearFigures),
+// -- после удаления функции с этим хэндлом возвращают QERR_ERROR
 QSNAP_API QError ShowFigure
 (
   QHandle       hFigure,            // [in] хэндл фигуры
   bool          bShow               // [in] показать/скрыть
 );
 
+// функция удаления одной фигуры
+QSNAP_API QError RemoveFigure
+(
+  QHandle       hFigure             // [in] хэндл фигуры
+);
+
+// функция сдвига фигуры
+QSNAP_API QError MoveFigure
+(
+  QHandle       hFigure,            // [in] хэндл фигуры
+  int           dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+  int           dy                  // [in] сдвиг по вертикали (в координатах изображения)
+);
+
+// функция изменения цвета фигуры
+QSNAP_API QError SetFigureColor
+(
+  QHandle       hFigure,            // [in] хэндл фигуры
+  SnpColor      color               // [in] цвет
+);
+
 // функция удаления всех фигур в данном окне
 QSNAP_API QError ClearFigures
 (
@@ -677,6 +985,29 @@ QSNAP_API QError ShowGroup
   bool          bShow               // [in] показать/скрыть
 );
 
+// функция удаления всех фигур группы (остальные группы не затрагиваются)
+QSNAP_API QError ClearGroup
+(
+  QHandle       hView,              // [in] хэндл окна
+  const char*   idGroup             // [in] id группы фигур
+);
+
+// начало построения кадра оверлея (двойная буферизация группы фигур)
+// -- до CommitOverlay фигуры группы idGroup складываются в задний буфер,
+// -- окно продолжает рисовать предыдущий кадр; буфер прошлого кадра очищается здесь,
+// -- в потоке приложения, а не в потоке окна
+QSNAP_API QError BeginOverlay
+(
+  QHandle       hView,              // [in] хэндл окна
+  const char*   idGroup             // [in] id группы фигур
+);
+
+// показ всех построенных кадров оверлеев окна (подмена указателей групп)
+QSNAP_API QError CommitOverlay
+(
+  QHandle       hView               // [in] хэндл окна
+);
+
 ////////////////////////////////////////////////////////
 //////    Работа с окном кадров QFrameView
 ////////////////////////////////////////////////////////
@@ -793,6 +1124,8 @@ QSNAP_API QError GetUserRect
 );
 
 // получение координат пользовательского многоугольника
+// -- вершины ставятся ALT+щелчком, ALT+правая кнопка - сброс
+// -- если массив мал (или points==0), в szPoints возвращается нужный размер и QERR_ERROR
 QSNAP_API QError GetUserPolygon
 (
   QHandle       hView,              // [in]  хэндл окна
@@ -800,6 +1133,32 @@ QSNAP_API QError GetUserPolygon
   int*          szPoints            // [in,out] размер массива
 );
 
+// получение координат пользовательской точки в системе фигур группы
+// -- idGroup==0 - группа по умолчанию (как GetUserPoint)
+QSNAP_API QError GetUserPointInGroup
+(
+  QHandle       hView,              // [in]  хэндл окна
+  SnpPoint*     point,              // [out] координаты точки
+  const char*   idGroup             // [in]  идентификатор группы фигур
+);
+
+// получение координат пользовательского прямоугольника в системе фигур группы
+QSNAP_API QError GetUserRectInGroup
+(
+  QHandle       hView,              // [in]  хэндл окна
+  SnpRect*      rect,               // [out] координаты прямоугольника
+  const char*   idGroup             // [in]  идентификатор группы фигур
+);
+
+// получение координат пользовательского многоугольника в системе фигур группы
+QSNAP_API QError GetUserPolygonInGroup
+(
+  QHandle       hView,              // [in]  хэндл окна
+  SnpPoint*     points,             // [in,out] массив точек многоугольника
+  int*          szPoints,           // [in,out] размер массива
+  const char*   idGroup             // [in]  идентификатор группы фигур
+);
+
 // получение пользовательской строки
 QSNAP_API QError GetUserString
 (
@@ -915,6 +1274,27 @@ QSNAP_API QError RemoveControl
   QHandle         hControl          // [in]  хэндл элемента управления
 );
 
+// состояние элемента управления: обновляется библиотекой, читается вызывающим
+// напрямую (state->checked(), state->enabled()); действительно, пока существует панель
+QSNAP_API const SnapState* GetControlState // [ret] состояние, NULL для чужого хэндла
+(
+  QHandle         hControl          // [in]  хэндл элемента управления
+);
+
+// нажатие/отпускание кнопки с фиксацией (CTRL_CHKBUTTON)
+QSNAP_API QError CheckControl
+(
+  QHandle         hControl,         // [in]  хэндл элемента управления
+  bool            bCheck            // [in]  нажать/отпустить
+);
+
+// включение/отключение элемента управления
+QSNAP_API QError EnableControl
+(
+  QHandle         hControl,         // [in]  хэндл элемента управления
+  bool            bEnable           // [in]  включить/отключить
+);
+
 ////////////////////////////////////////////////////////
 //////    Пользовательские виджеты
 ////////////////////////////////////////////////////////
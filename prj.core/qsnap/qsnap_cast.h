@@ -19,6 +19,11 @@
 
 namespace QSnp {
 
+// массивы cv::Point / cv::Rect передаются в библиотеку без преобразования
+// как массивы SnpPoint / SnpRect (см. DrawPoints, DrawRects и т.д.)
+static_assert(sizeof(cv::Point) == sizeof(QSnp::SnpPoint), "cv::Point is not layout compatible with SnpPoint");
+static_assert(sizeof(cv::Rect)  == sizeof(QSnp::SnpRect),  "cv::Rect is not layout compatible with SnpRect");
+
 // cv::Rect -> QSnp::SnpRect
 inline QSnp::SnpRect SnpRect_cast(cv::Rect _rc)
 {
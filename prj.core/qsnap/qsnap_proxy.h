@@ -18,6 +18,7 @@
 #include <qsnap/qspx_macro.h>
 
 #include <list>
+#include <vector>
 
 using namespace QSnp;
 
@@ -355,7 +356,17 @@ public:
   QError setScaleFactor
   (
     double        scale,              // [in] координата по горизонтали
-    const char*   idGroup = 0         // [in] идентификатор группы фигур (not implemented)
+    const char*   idGroup = 0         // [in] идентификатор группы фигур
+  );
+
+  // установка преобразования группы фигур (масштаб, поворот, сдвиг)
+  QError setGroupTransform
+  (
+    double        scale,              // [in] коэффициент масштабирования
+    double        dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+    double        dy,                 // [in] сдвиг по вертикали (в координатах изображения)
+    double        rotation = 0,       // [in] поворот, градусы (по часовой стрелке на экране)
+    const char*   idGroup = 0         // [in] идентификатор группы фигур
   );
 
   // отрисовка точки
@@ -405,6 +416,17 @@ public:
     bool          bRepaint = false    // [in] отрисовка окна
 );
 
+  // отрисовка многоугольника, ломанной OpenCV
+  QSpxFigure* drawPolygon       // [ret] хэндл фигуры
+  (
+    const std::vector<cv::Point>& points, // [in] массив точек многоугольника
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    PolygonType   type = PT_POLYGON,  // [in] тип многоугольника (ломаная, замкнутый и т.д.)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
   // отрисовка эллипса
   QSpxFigure* drawEllipse       // [ret] хэндл фигуры
   (
@@ -416,12 +438,15 @@ public:
     bool          bRepaint = false    // [in] отрисовка окна
   );
 
-  // отрисовка дуги
+  // отрисовка дуги эллипса
   QSpxFigure* drawArc           // [ret] хэндл фигуры
   (
+    SnpRect       rect,               // [in] координаты охватывающего прямоугольника эллипса
+    double        startAngle,         // [in] начальный угол дуги (градусы)
+    double        spanAngle,          // [in] угловой размер дуги (градусы)
     int           lineWidth,          // [in] толщина линии
     SnpColor      color,              // [in] цвет
-    LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+    LineType      type = LT_LINE,     // [in] тип линии (линия, пунктир и т.д.)
     const char*   idGroup = 0,        // [in] идентификатор группы фигур
     bool          bRepaint = false    // [in] отрисовка окна
   );
@@ -438,17 +463,174 @@ public:
     bool          bRepaint = false    // [in] отрисовка окна
   );
 
+  // отрисовка массива точек одной фигурой
+  QSpxFigure* drawPoints        // [ret] хэндл фигуры
+  (
+    const SnpPoint* points,           // [in] массив точек
+    int           nPoints,            // [in] количество точек
+    int           ptWidth,            // [in] толщина точки (диаметр)
+    SnpColor      color,              // [in] цвет
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка массива точек OpenCV одной фигурой
+  QSpxFigure* drawPoints        // [ret] хэндл фигуры
+  (
+    const std::vector<cv::Point>& points, // [in] массив точек
+    int           ptWidth,            // [in] толщина точки (диаметр)
+    SnpColor      color,              // [in] цвет
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка массива линий одной фигурой
+  QSpxFigure* drawLines         // [ret] хэндл фигуры
+  (
+    const SnpPoint* points,           // [in] пары точек (начало, конец), 2*nLines элементов
+    int           nLines,             // [in] количество линий
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    LineType      type = LT_LINE,     // [in] тип линии (линия, пунктир и т.д.)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка массива линий OpenCV одной фигурой
+  QSpxFigure* drawLines         // [ret] хэндл фигуры
+  (
+    const std::vector<cv::Point>& points, // [in] пары точек (начало, конец)
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    LineType      type = LT_LINE,     // [in] тип линии (линия, пунктир и т.д.)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка массива прямоугольников одной фигурой
+  QSpxFigure* drawRects         // [ret] хэндл фигуры
+  (
+    const SnpRect* rects,             // [in] массив прямоугольников
+    int           nRects,             // [in] количество прямоугольников
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    LineType      type = LT_LINE,     // [in] тип линии (линия, пунктир и т.д.)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка массива прямоугольников OpenCV одной фигурой
+  QSpxFigure* drawRects         // [ret] хэндл фигуры
+  (
+    const std::vector<cv::Rect>& rects, // [in] массив прямоугольников
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    LineType      type = LT_LINE,     // [in] тип линии (линия, пунктир и т.д.)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка набора ломаных одной фигурой
+  QSpxFigure* drawPolylines     // [ret] хэндл фигуры
+  (
+    const SnpPoint* points,           // [in] точки всех ломаных подряд
+    const int*    szPolylines,        // [in] количество точек в каждой ломаной
+    int           nPolylines,         // [in] количество ломаных
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    PolygonType   type = PT_POLYGON,  // [in] тип (замкнутый многоугольник, ломаная)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка контуров OpenCV (результат cv::findContours) одной фигурой
+  QSpxFigure* drawPolylines     // [ret] хэндл фигуры
+  (
+    const std::vector< std::vector<cv::Point> >& contours, // [in] контуры
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    PolygonType   type = PT_POLYGON,  // [in] тип (замкнутый многоугольник, ломаная)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка облака точек одной фигурой (карта плотности)
+  QSpxFigure* drawPointCloud    // [ret] хэндл фигуры
+  (
+    const SnpPoint* points,           // [in] массив точек
+    int           nPoints,            // [in] количество точек
+    int           ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+    SnpColor      color,              // [in] цвет
+    PointCloudType type = PC_DENSITY, // [in] режим отрисовки (плотность, пятна)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка облака точек OpenCV одной фигурой
+  QSpxFigure* drawPointCloud    // [ret] хэндл фигуры
+  (
+    const std::vector<cv::Point>& points, // [in] массив точек
+    int           ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+    SnpColor      color,              // [in] цвет
+    PointCloudType type = PC_DENSITY, // [in] режим отрисовки (плотность, пятна)
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    bool          bRepaint = false    // [in] отрисовка окна
+  );
+
+  // отрисовка траектории (точки добавляются appendPoint)
+  QSpxFigure* drawTrajectory    // [ret] хэндл фигуры
+  (
+    int           maxLength,          // [in] максимальное количество точек (0 - без ограничения)
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    const SnpPoint* points = 0,       // [in] начальные точки
+    int           nPoints = 0         // [in] количество точек
+  );
+
+  // добавление точки в конец траектории
+  QError appendPoint
+  (
+    QSpxFigure*   hFigure,            // [in] хэндл траектории
+    int           x,                  // [in] координата по горизонтали
+    int           y                   // [in] координата по вертикали
+  );
+
+  // установка полупрозрачного оверлея изображения (маска меток, тепловая карта)
+  QError setOverlayMat
+  (
+    const cv::Mat& mat,               // [in] CV_8UC1 (метки) или CV_32FC1 (0..1), пустая - удаление
+    OverlayColormap colormap = OC_LABELS, // [in] палитра
+    double        alpha = 0.5,        // [in] непрозрачность 0..1
+    const char*   idGroup = 0,        // [in] идентификатор группы фигур
+    const SnpColor* pLut = 0          // [in] собственная палитра из 256 цветов
+  );
+
+  // показ/скрытие класса (значения) оверлея изображения
+  QError setOverlayClassVisible
+  (
+    int           label,              // [in] значение (индекс палитры)
+    bool          bShow,              // [in] показать/скрыть
+    const char*   idGroup = 0         // [in] идентификатор группы фигур
+  );
+
   // выставлена ли пользовательская точка
   bool userPointSet();
 
-  // получение координат пользовательской точки
-  QSnp::SnpPoint getUserPoint();
+  // получение координат пользовательской точки (в системе фигур группы idGroup)
+  QSnp::SnpPoint getUserPoint(const char* idGroup = 0);
 
   // выставлен ли пользовательский прямоугольник
   bool userRectSet();
 
-  // получение координат пользовательского прямоугольника
-  QSnp::SnpRect getUserRect();
+  // получение координат пользовательского прямоугольника (в системе фигур группы idGroup)
+  QSnp::SnpRect getUserRect(const char* idGroup = 0);
+
+  // выставлен ли пользовательский многоугольник
+  bool userPolygonSet();
+
+  // получение вершин пользовательского многоугольника (в системе фигур группы idGroup)
+  std::vector<QSnp::SnpPoint> getUserPolygon(const char* idGroup = 0);
   
   // содержит ли прямоугольник пользовательскую точку
   bool containUserPoint(QSnp::SnpRect rc);
@@ -456,17 +638,60 @@ public:
   // содержится ли прямоугольник полностью внутри пользовательского прямоугольника
   bool insideUserRect(QSnp::SnpRect rc);
 
-  /*
   // функция показа/скрытия фигуры
   QError showFigure
   (
-    QHandle       hFigure,            // [in] хэндл фигуры
+    QSpxFigure*   hFigure,            // [in] хэндл фигуры
     bool          bShow               // [in] показать/скрыть
   );
-*/
+
+  // функция удаления одной фигуры
+  QError removeFigure
+  (
+    QSpxFigure*   hFigure             // [in] хэндл фигуры
+  );
+
+  // функция сдвига фигуры
+  QError moveFigure
+  (
+    QSpxFigure*   hFigure,            // [in] хэндл фигуры
+    int           dx,                 // [in] сдвиг по горизонтали
+    int           dy                  // [in] сдвиг по вертикали
+  );
+
+  // функция изменения цвета фигуры
+  QError setFigureColor
+  (
+    QSpxFigure*   hFigure,            // [in] хэндл фигуры
+    SnpColor      color               // [in] цвет
+  );
+
   // функция удаления всех фигур в данном окне
   QError clearFigures();
 
+  // функция показа/скрытия группы фигур
+  QError showGroup
+  (
+    const char*   idGroup,            // [in] id группы фигур
+    bool          bShow               // [in] показать/скрыть
+  );
+
+  // функция удаления всех фигур группы
+  QError clearGroup
+  (
+    const char*   idGroup             // [in] id группы фигур
+  );
+
+  // начало построения кадра оверлея: до commitOverlay фигуры группы
+  // складываются в задний буфер, окно рисует предыдущий кадр
+  QError beginOverlay
+  (
+    const char*   idGroup             // [in] id группы фигур
+  );
+
+  // показ построенных кадров оверлеев
+  QError commitOverlay();
+
 
 protected:
 
@@ -495,10 +720,21 @@ protected:
   (
     QHandle       hView,              // [in] хэндл окна
     double        scale,              // [in] координата по горизонтали
-    const char*   idGroup             // [in] идентификатор группы фигур (not implemented)
+    const char*   idGroup             // [in] идентификатор группы фигур
   );
   QW_DEF_FUNC(SetScaleFactor);
 
+  QW_DEF_TYPE(SetGroupTransform)
+  (
+    QHandle       hView,              // [in] хэндл окна
+    double        scale,              // [in] коэффициент масштабирования
+    double        dx,                 // [in] сдвиг по горизонтали
+    double        dy,                 // [in] сдвиг по вертикали
+    double        rotation,           // [in] поворот, градусы
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(SetGroupTransform);
+
   QW_DEF_TYPE(DrawPoint)
   (
     QHandle       hView,              // [in] хэндл окна
@@ -558,7 +794,8 @@ protected:
     int*          szPoints,           // [in,out] размер массива точек
     int           lineWidth,          // [in] толщина линии
     SnpColor      color,              // [in] цвет
-    PolygonType   type                // [in] тип многоугольника (ломаная, замкнутый и т.д.)
+    PolygonType   type,               // [in] тип многоугольника (ломаная, замкнутый и т.д.)
+    const char*   idGroup             // [in] идентификатор группы фигур
   );
   QW_DEF_FUNC(DrawPolygon);
 
@@ -578,7 +815,9 @@ protected:
   QW_DEF_TYPE(DrawArc)           // [ret] хэндл фигуры
   (
     QHandle       hView,              // [in] хэндл окна
-  //  ...                             // [in] параметры дуги
+    QSnp::SnpRect*   pRect,           // [in] координаты охватывающего прямоугольника эллипса
+    double        startAngle,         // [in] начальный угол дуги
+    double        spanAngle,          // [in] угловой размер дуги
     int           lineWidth,          // [in] толщина линии
     SnpColor      color,              // [in] цвет
     LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
@@ -586,6 +825,115 @@ protected:
   );
   QW_DEF_FUNC(DrawArc);
 
+  // отрисовка массива точек
+  QW_DEF_TYPE(DrawPoints)        // [ret] хэндл фигуры
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const SnpPoint* points,           // [in] массив точек
+    int           nPoints,            // [in] количество точек
+    int           ptWidth,            // [in] толщина точки (диаметр)
+    SnpColor      color,              // [in] цвет
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(DrawPoints);
+
+  // отрисовка массива линий
+  QW_DEF_TYPE(DrawLines)         // [ret] хэндл фигуры
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const SnpPoint* points,           // [in] пары точек (начало, конец)
+    int           nLines,             // [in] количество линий
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(DrawLines);
+
+  // отрисовка массива прямоугольников
+  QW_DEF_TYPE(DrawRects)         // [ret] хэндл фигуры
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const SnpRect* rects,             // [in] массив прямоугольников
+    int           nRects,             // [in] количество прямоугольников
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(DrawRects);
+
+  // отрисовка набора ломаных
+  QW_DEF_TYPE(DrawPolylines)     // [ret] хэндл фигуры
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const SnpPoint* points,           // [in] точки всех ломаных подряд
+    const int*    szPolylines,        // [in] количество точек в каждой ломаной
+    int           nPolylines,         // [in] количество ломаных
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    PolygonType   type,               // [in] тип (замкнутый многоугольник, ломаная)
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(DrawPolylines);
+
+  // отрисовка облака точек одной фигурой
+  QW_DEF_TYPE(DrawPointCloud)    // [ret] хэндл фигуры
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const SnpPoint* points,           // [in] массив точек
+    int           nPoints,            // [in] количество точек
+    int           ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+    SnpColor      color,              // [in] цвет
+    PointCloudType type,              // [in] режим отрисовки (плотность, пятна)
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(DrawPointCloud);
+
+  // отрисовка траектории
+  QW_DEF_TYPE(DrawTrajectory)    // [ret] хэндл фигуры
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const SnpPoint* points,           // [in] начальные точки
+    int           nPoints,            // [in] количество точек
+    int           maxLength,          // [in] максимальное количество точек
+    int           lineWidth,          // [in] толщина линии
+    SnpColor      color,              // [in] цвет
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(DrawTrajectory);
+
+  // добавление точки в конец траектории
+  QW_DEF_TYPE(AppendPoint)
+  (
+    QHandle       hFigure,            // [in] хэндл траектории
+    int           x,                  // [in] координата по горизонтали
+    int           y                   // [in] координата по вертикали
+  );
+  QW_DEF_FUNC(AppendPoint);
+
+  // установка полупрозрачного оверлея изображения
+  QW_DEF_TYPE(SetOverlayMat)
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const cv::Mat* pMat,              // [in] матрица оверлея
+    OverlayColormap colormap,         // [in] палитра
+    const SnpColor* pLut,             // [in] собственная палитра из 256 цветов
+    double        alpha,              // [in] непрозрачность 0..1
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(SetOverlayMat);
+
+  // показ/скрытие класса оверлея изображения
+  QW_DEF_TYPE(SetOverlayClassVisible)
+  (
+    QHandle       hView,              // [in] хэндл окна
+    int           label,              // [in] значение (индекс палитры)
+    bool          bShow,              // [in] показать/скрыть
+    const char*   idGroup             // [in] идентификатор группы фигур
+  );
+  QW_DEF_FUNC(SetOverlayClassVisible);
+
   // получение координат пользовательской точки
   QW_DEF_TYPE(GetUserPoint)
   (
@@ -602,6 +950,43 @@ protected:
   );
   QW_DEF_FUNC(GetUserRect);
 
+  // получение координат пользовательского многоугольника
+  QW_DEF_TYPE(GetUserPolygon)
+  (
+    QHandle       hView,              // [in]  хэндл окна
+    QSnp::SnpPoint*  points,          // [in,out] массив точек многоугольника
+    int*          szPoints            // [in,out] размер массива
+  );
+  QW_DEF_FUNC(GetUserPolygon);
+
+  // получение координат пользовательской точки в системе фигур группы
+  QW_DEF_TYPE(GetUserPointInGroup)
+  (
+    QHandle       hView,              // [in]  хэндл окна
+    QSnp::SnpPoint*  point,           // [out] координаты точки
+    const char*   idGroup             // [in]  идентификатор группы фигур
+  );
+  QW_DEF_FUNC(GetUserPointInGroup);
+
+  // получение координат пользовательского прямоугольника в системе фигур группы
+  QW_DEF_TYPE(GetUserRectInGroup)
+  (
+    QHandle       hView,              // [in]  хэндл окна
+    QSnp::SnpRect*   pRect,           // [out] координаты прямоугольника
+    const char*   idGroup             // [in]  идентификатор группы фигур
+  );
+  QW_DEF_FUNC(GetUserRectInGroup);
+
+  // получение координат пользовательского многоугольника в системе фигур группы
+  QW_DEF_TYPE(GetUserPolygonInGroup)
+  (
+    QHandle       hView,              // [in]  хэндл окна
+    QSnp::SnpPoint*  points,          // [in,out] массив точек многоугольника
+    int*          szPoints,           // [in,out] размер массива
+    const char*   idGroup             // [in]  идентификатор группы фигур
+  );
+  QW_DEF_FUNC(GetUserPolygonInGroup);
+
   // функция показа/скрытия фигуры
   QW_DEF_TYPE(ShowFigure)
   (
@@ -610,6 +995,30 @@ protected:
   );
   QW_DEF_FUNC(ShowFigure);
 
+  // функция удаления одной фигуры
+  QW_DEF_TYPE(RemoveFigure)
+  (
+    QHandle       hFigure             // [in] хэндл фигуры
+  );
+  QW_DEF_FUNC(RemoveFigure);
+
+  // функция сдвига фигуры
+  QW_DEF_TYPE(MoveFigure)
+  (
+    QHandle       hFigure,            // [in] хэндл фигуры
+    int           dx,                 // [in] сдвиг по горизонтали
+    int           dy                  // [in] сдвиг по вертикали
+  );
+  QW_DEF_FUNC(MoveFigure);
+
+  // функция изменения цвета фигуры
+  QW_DEF_TYPE(SetFigureColor)
+  (
+    QHandle       hFigure,            // [in] хэндл фигуры
+    SnpColor      color               // [in] цвет
+  );
+  QW_DEF_FUNC(SetFigureColor);
+
   // функция удаления всех фигур в данном окне
   QW_DEF_TYPE(ClearFigures)
   (
@@ -617,6 +1026,38 @@ protected:
   );
   QW_DEF_FUNC(ClearFigures);
 
+  // функция показа/скрытия группы фигур
+  QW_DEF_TYPE(ShowGroup)
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const char*   idGroup,            // [in] id группы фигур
+    bool          bShow               // [in] показать/скрыть
+  );
+  QW_DEF_FUNC(ShowGroup);
+
+  // функция удаления всех фигур группы
+  QW_DEF_TYPE(ClearGroup)
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const char*   idGroup             // [in] id группы фигур
+  );
+  QW_DEF_FUNC(ClearGroup);
+
+  // начало построения кадра оверлея
+  QW_DEF_TYPE(BeginOverlay)
+  (
+    QHandle       hView,              // [in] хэндл окна
+    const char*   idGroup             // [in] id группы фигур
+  );
+  QW_DEF_FUNC(BeginOverlay);
+
+  // показ построенных кадров оверлеев
+  QW_DEF_TYPE(CommitOverlay)
+  (
+    QHandle       hView               // [in] хэндл окна
+  );
+  QW_DEF_FUNC(CommitOverlay);
+
 };
 
 ///////////////////////////////////////////////////////////////////////
@@ -661,6 +1102,34 @@ public:
   );
 #endif
 
+  // установка соответствий точек двух окон (линии поверх окон)
+  QError setMatches
+  (
+    const SnpPoint* ptsFrom,            // [in]  точки первого окна
+    const SnpPoint* ptsTo,              // [in]  точки второго окна
+    int           nMatches,             // [in]  количество соответствий
+    const float*  scores = 0,           // [in]  оценки соответствий
+    const SnpColor* colors = 0,         // [in]  цвета соответствий
+    int           lineWidth = 1,        // [in]  толщина линий
+    SnpColor      color = 0x00ff00      // [in]  цвет по умолчанию (зеленый)
+  );
+
+  // установка соответствий OpenCV (queryIdx - первое окно, trainIdx - второе)
+  QError setMatches
+  (
+    const std::vector<cv::KeyPoint>& keysFrom, // [in]  особые точки первого окна
+    const std::vector<cv::KeyPoint>& keysTo,   // [in]  особые точки второго окна
+    const std::vector<cv::DMatch>& matches,    // [in]  соответствия (оценка - минус расстояние)
+    int           lineWidth = 1,        // [in]  толщина линий
+    SnpColor      color = 0x00ff00      // [in]  цвет (зеленый)
+  );
+
+  // установка порога оценки показываемых соответствий
+  QError setMatchThreshold
+  (
+    float         threshold             // [in]  показываются соответствия с оценкой >= threshold
+  );
+
 protected:
 
   // указатели на функции
@@ -670,6 +1139,13 @@ protected:
   QW_DEF_TYPE(SetSubMatImage)(QHandle hView, const cv::Mat* pImage, int nSubView, QSnp::ImageFlags flagsShow);
   QW_DEF_FUNC(SetSubMatImage);
 
+  QW_DEF_TYPE(SetMatches)(QHandle hView, const SnpPoint* ptsFrom, const SnpPoint* ptsTo,
+    const float* scores, const SnpColor* colors, int nMatches, int lineWidth, SnpColor color);
+  QW_DEF_FUNC(SetMatches);
+
+  QW_DEF_TYPE(SetMatchThreshold)(QHandle hView, float threshold);
+  QW_DEF_FUNC(SetMatchThreshold);
+
 #ifdef __MINIMG__
   QW_DEF_TYPE(SetSubMinImage)(QHandle hView, const MinImg* pMinImage, int nSubView, QSnp::ImageFlags flagsShow);
   QW_DEF_FUNC(SetSubMinImage);
@@ -708,10 +1184,68 @@ public:
     ...                                // [in]  параметры шаблона
   );
 
-  // вывод расширенного текстового сообщения
-  QError logEx
+  // отложенный вывод текстового сообщения: аргументы проверяются по типу и
+  // сохраняются без форматирования, форматирование выполняется в потоке окна
+  template <typename... Args>
+  QError logArgs
+  (
+    const char* sFormat,               // [in]  строка формата printf (должна существовать до вывода, обычно литерал)
+    const Args&... args                // [in]  параметры шаблона
+  );
+
+  // отложенный вывод текстового сообщения отдельной строкой
+  template <typename... Args>
+  QError logArgsLn
   (
+    const char* sFormat,               // [in]  строка формата printf (должна существовать до вывода, обычно литерал)
+    const Args&... args                // [in]  параметры шаблона
+  );
+
+  // вывод сообщения уровня level в канал channel отдельной строкой
+  // (при отключенных уровне или канале сообщение не форматируется)
+  QError logLnAt
+  (
+    LogLevel    level,                 // [in]  уровень сообщения LL_*
+    int         channel,               // [in]  канал (см. registerChannel)
     const char* sText,                 // [in]  текстовый шаблон
+    ...                                // [in]  параметры шаблона
+  );
+
+  // отложенный вывод сообщения уровня level в канал channel отдельной строкой
+  template <typename... Args>
+  QError logArgsLnAt
+  (
+    LogLevel    level,                 // [in]  уровень сообщения LL_*
+    int         channel,               // [in]  канал (см. registerChannel)
+    const char* sFormat,               // [in]  строка формата printf (должна существовать до вывода, обычно литерал)
+    const Args&... args                // [in]  параметры шаблона
+  );
+
+  // будет ли выведено сообщение уровня level в канале channel (проверка без обращения к окну)
+  bool isLogEnabled(LogLevel level, int channel = LOG_CHANNEL_DEFAULT) const
+  {
+    return !pLogFilter || pLogFilter->enabled(level, channel);
+  }
+
+  // регистрация именованного канала, возвращает номер канала
+  int registerChannel(const char* sName, bool bEnabled = true);
+
+  // присоединение к окну по хэндлу (с получением фильтра окна)
+  virtual bool attach(QHandle hView);
+
+  // отсоединение от окна
+  virtual bool detach();
+
+  // включение/отключение канала
+  QError enableChannel(int channel, bool bEnable);
+
+  // установка минимального уровня выводимых сообщений
+  QError setLogLevel(LogLevel level);
+
+  // вывод текста цветом color и шрифтом flags (FF_BOLD, FF_ITALIC, FF_UNDERLINED)
+  QError logEx
+  (
+    const char* sText,                 // [in]  текст сообщения
     SnpColor    color,                 // [in]  цвет текста
     FontFlags   flags                  // [in]  параметры шрифта
   );
@@ -719,6 +1253,21 @@ public:
   // очистка текста
   QError clear();
 
+  // ограничение объема лога (0 - по умолчанию)
+  QError setLogLimits
+  (
+    int         maxLines,              // [in]  максимальное количество строк
+    long long   maxBytes = 0           // [in]  максимальный объем текста в байтах
+  );
+
+  // выгрузка вытесненных строк в файлы-сегменты (NULL - выключить)
+  QError setLogSpill
+  (
+    const char* sDir,                  // [in]  каталог файлов выгрузки
+    long long   segmentBytes = 0,      // [in]  размер файла-сегмента (0 - по умолчанию)
+    int         maxSegments = 0        // [in]  максимальное количество сегментов (0 - без ограничения)
+  );
+
 protected:
 
   // указатели на функции
@@ -731,8 +1280,36 @@ protected:
   QW_DEF_TYPE(LogEx)(QHandle hView, const char* sText, SnpColor color, FontFlags flags);
   QW_DEF_FUNC(LogEx);
 
+  QW_DEF_TYPE(LogLnAt)(QHandle hView, LogLevel level, const char* sText, ... );
+  QW_DEF_FUNC(LogLnAt);
+
+  QW_DEF_TYPE(LogArgsAt)(QHandle hView, LogLevel level, const char* sFormat, const LogArg* args, int nArgs, bool bNewLine);
+  QW_DEF_FUNC(LogArgsAt);
+
+  QW_DEF_TYPE(LogArgs)(QHandle hView, const char* sFormat, const LogArg* args, int nArgs, bool bNewLine);
+  QW_DEF_FUNC(LogArgs);
+
+  QW_DEF_TYPE_EX(GetLogFilter, const LogFilter*)(QHandle hView);
+  QW_DEF_FUNC(GetLogFilter);
+
+  QW_DEF_TYPE_EX(RegisterLogChannel, int)(QHandle hView, const char* sName, bool bEnabled);
+  QW_DEF_FUNC(RegisterLogChannel);
+
+  QW_DEF_TYPE(EnableLogChannel)(QHandle hView, int channel, bool bEnable);
+  QW_DEF_FUNC(EnableLogChannel);
+
+  QW_DEF_TYPE(SetLogLevel)(QHandle hView, LogLevel level);
+  QW_DEF_FUNC(SetLogLevel);
+
+  const LogFilter* pLogFilter;         // фильтр окна, общий с библиотекой
+
   QW_DEF_TYPE(ClearTextView)(QHandle hView);
   QW_DEF_FUNC(ClearTextView);
+
+  QW_DEF_TYPE(SetLogLimits)(QHandle hView, int maxLines, long long maxBytes);
+  QW_DEF_FUNC(SetLogLimits);
+  QW_DEF_TYPE(SetLogSpill)(QHandle hView, const char* sDir, long long segmentBytes, int maxSegments);
+  QW_DEF_FUNC(SetLogSpill);
   
 };
 
@@ -941,7 +1518,7 @@ public:
   // цвет вершины
   QError setColor(SnpColor color);
 
-  // проверка выделена ли вершина
+  // проверка выделена ли вершина (чтение опубликованного состояния, без вызова библиотеки)
   bool isChecked();
 
   // выделение вершины
@@ -963,13 +1540,13 @@ public:
   QHandle handle() { return hNode; }
 
   // установка хэндла вершины
-  void setHandle(QHandle h) { hNode=h; }
+  void setHandle(QHandle h);
 
   // получение окна дерева снепа
   QSpxTreeView* treeView() { return pView; }
   
   // установка окна дерева снепа
-  void setTreeView(QSpxTreeView* p) { pView=p; }
+  void setTreeView(QSpxTreeView* p);
 
 ////////////////////////////////////////////////////////////
 //// Работа со свойствами вершины
@@ -991,7 +1568,7 @@ public:
     NodePropertyInfo* pNodeProperty    // [in]  свойство
   );
 
-  // получение свойства вершины
+  // получение свойства вершины (копия действительна до следующего запроса этого свойства в потоке)
   const char* value   // [ret] значение свойства, NULL если свойство не существует
   (
     const char* sKey                   // [in]  название свойства
@@ -1031,10 +1608,55 @@ public:
     const char* sKey                   // [in]  название свойства
   );
 
+  // описание типизированного свойства
+  QError defineProperty
+  (
+    const char* sKey,                  // [in]  название свойства
+    SnpPropType type,                  // [in]  тип свойства
+    const char* sDefault = 0,          // [in]  значение по умолчанию
+    double      dMin = 0,              // [in]  минимальное значение
+    double      dMax = 0,              // [in]  максимальное значение (dMin >= dMax - без ограничения)
+    const char* sEnum = 0              // [in]  варианты PROP_ENUM через '|'
+  );
+
+  // типизированное значение свойства; указатель можно сохранить и читать
+  // значение (toInt(), toDouble(), toBool()) без вызова библиотеки; значение
+  // создается при первом запросе и до добавления свойства нулевое (version = 0)
+  const PropValue* propertyValue // [ret] значение, NULL при неверной вершине или названии
+  (
+    const char* sKey                   // [in]  название свойства
+  );
+
+  // номер изменения свойств вершины (чтение без вызова библиотеки)
+  unsigned propertiesVersion();
+
+  // связывание свойства с переменной: изменения свойства (в том числе в окне
+  // свойств) записываются в переменную без опроса; std::atomic - сразу,
+  // обычные переменные - при QSpxTreeView::applyBindings() и после ожидания
+  // действия пользователя. Переменная должна существовать до unbind()
+  QError bind(const char* sKey, int* pVar)                  { return bindVar(sKey, BIND_INT, pVar); }
+  QError bind(const char* sKey, double* pVar)               { return bindVar(sKey, BIND_DOUBLE, pVar); }
+  QError bind(const char* sKey, bool* pVar)                 { return bindVar(sKey, BIND_BOOL, pVar); }
+  QError bind(const char* sKey, std::atomic<int>* pVar)     { return bindVar(sKey, BIND_ATOMIC_INT, pVar); }
+  QError bind(const char* sKey, std::atomic<double>* pVar)  { return bindVar(sKey, BIND_ATOMIC_DOUBLE, pVar); }
+  QError bind(const char* sKey, std::atomic<bool>* pVar)    { return bindVar(sKey, BIND_ATOMIC_BOOL, pVar); }
+
+  // отмена связи свойства с переменной
+  QError unbind(const char* sKey)                           { return bindVar(sKey, BIND_INT, 0); }
+
+protected:
+  // связывание свойства с переменной заданного типа
+  QError bindVar(const char* sKey, SnpBindType type, void* pVar);
+
+  // получение опубликованных библиотекой состояний вершины
+  void resolvePublished();
+
 protected:
   QSnapNode     hNode;        ///< хэндл окна
   QSpxTreeView* pView;        ///< класс дерева снепа
   NodeInfo      nodeInfo;     ///< свойства вершины
+  const SnapState* pState;    ///< опубликованное состояние вершины
+  const std::atomic<unsigned>* pPropVersion;  ///< опубликованный счетчик изменений свойств
 
 };
 
@@ -1069,6 +1691,10 @@ public:
   // сохранить состояние вершин
   void saveState();
 
+  // запись измененных в окне значений свойств в связанные переменные
+  // (вызывается в потоке, читающем переменные)
+  int applyBindings();  // [ret] количество записанных значений
+
 protected:
   // указатели на функции
   QW_DEF_TYPE(GetSnapTreeRoot)(QHandle hInstance);
@@ -1095,6 +1721,9 @@ protected:
   QW_DEF_TYPE(CheckNode)(QSnapNode hNode, bool bCheck);
   QW_DEF_FUNC(CheckNode);
 
+  QW_DEF_TYPE_EX(GetNodeState, const SnapState*)(QSnapNode hNode);
+  QW_DEF_FUNC(GetNodeState);
+
   QW_DEF_TYPE(GetParentNode)(QSnapNode hNode);
   QW_DEF_FUNC(GetParentNode);
 
@@ -1140,6 +1769,21 @@ protected:
   QW_DEF_TYPE(SaveNodeProperty)(QSnapNode hNode, const char* sKey);
   QW_DEF_FUNC(SaveNodeProperty);
 
+  QW_DEF_TYPE(DefineNodeProperty)(QSnapNode hNode, const PropertyDef* pDef);
+  QW_DEF_FUNC(DefineNodeProperty);
+
+  QW_DEF_TYPE_EX(GetNodePropertyValue, const PropValue*)(QSnapNode hNode, const char* sKey);
+  QW_DEF_FUNC(GetNodePropertyValue);
+
+  QW_DEF_TYPE_EX(GetNodePropertiesVersion, const std::atomic<unsigned>*)(QSnapNode hNode);
+  QW_DEF_FUNC(GetNodePropertiesVersion);
+
+  QW_DEF_TYPE(BindNodeProperty)(QSnapNode hNode, const char* sKey, SnpBindType type, void* pVar);
+  QW_DEF_FUNC(BindNodeProperty);
+
+  QW_DEF_TYPE_EX(ApplyNodeBindings, int)();
+  QW_DEF_FUNC(ApplyNodeBindings);
+
   QW_DEF_TYPE_EX(LoadTreeViewState, void)(QHandle hView);
   QW_DEF_FUNC(LoadTreeViewState);
 
@@ -1181,6 +1825,27 @@ public:
     QHandle         hControl          // [in]  хэндл элемента управления
   );
 
+  // состояние элемента управления: указатель запрашивается один раз, далее
+  // state->checked()/state->enabled() читаются без вызова библиотеки
+  const SnapState* controlState
+  (
+    QHandle         hControl          // [in]  хэндл элемента управления
+  );
+
+  // нажатие/отпускание кнопки с фиксацией
+  QError checkControl
+  (
+    QHandle         hControl,         // [in]  хэндл элемента управления
+    bool            bCheck            // [in]  нажать/отпустить
+  );
+
+  // включение/отключение элемента управления
+  QError enableControl
+  (
+    QHandle         hControl,         // [in]  хэндл элемента управления
+    bool            bEnable           // [in]  включить/отключить
+  );
+
 protected:
   // указатели на функции
   QW_DEF_TYPE(AddControl)(QHandle hView, QSnp::CtrlInfo* pControlInfo);
@@ -1189,6 +1854,15 @@ protected:
   QW_DEF_TYPE(RemoveControl)(QHandle hControl);
   QW_DEF_FUNC(RemoveControl);
 
+  QW_DEF_TYPE_EX(GetControlState, const SnapState*)(QHandle hControl);
+  QW_DEF_FUNC(GetControlState);
+
+  QW_DEF_TYPE(CheckControl)(QHandle hControl, bool bCheck);
+  QW_DEF_FUNC(CheckControl);
+
+  QW_DEF_TYPE(EnableControl)(QHandle hControl, bool bEnable);
+  QW_DEF_FUNC(EnableControl);
+
 };
 
 ///////////////////////////////////////////////////////////////////////
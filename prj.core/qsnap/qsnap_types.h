@@ -9,6 +9,8 @@
 #ifndef QSNAP_TYPES_H
 #define QSNAP_TYPES_H
 
+#include <atomic>
+
 namespace QSnp {
 
 #ifdef __GCC__
@@ -23,6 +25,10 @@ typedef int     FontFlags;
 #define FF_ITALIC         0x00000002    ///<  курсив
 #define FF_UNDERLINED     0x00000004    ///<  подчеркнутый
 
+typedef int     StateFlags;
+#define SF_CHECKED        0x00000001    ///<  выделен (кнопка нажата)
+#define SF_ENABLED        0x00000002    ///<  доступен
+
 typedef int     ImageFlags;
 #define IF_HSTRETCH       0x00000001    ///<  растянутое по горизонтали
 #define IF_VSTRETCH       0x00000002    ///<  растянутое по вертикали
@@ -57,6 +63,31 @@ typedef int     PolygonType;
 #define PT_POLYGON        0x00000000    ///<  замкнутый многоугольник
 #define PT_LINES          0x00000001    ///<  ломаная (незамкнутая)
 
+typedef int     PointCloudType;
+#define PC_DENSITY        0x00000000    ///<  карта плотности: прозрачность по числу точек в пикселе
+#define PC_SPLAT          0x00000001    ///<  непрозрачные пятна размером в толщину точки
+
+typedef int     OverlayColormap;
+#define OC_LABELS         0x00000000    ///<  метки классов (CV_8UC1): свой цвет каждой метке, метка 0 прозрачна
+#define OC_HEAT           0x00000001    ///<  тепловая карта (CV_32FC1, 0..1): синий - зеленый - красный, прозрачность по значению
+#define OC_GRAY           0x00000002    ///<  оттенки серого
+
+typedef int     LogArgType;
+#define LA_INT            0x00000000    ///<  целое со знаком
+#define LA_UINT           0x00000001    ///<  целое без знака
+#define LA_DOUBLE         0x00000002    ///<  вещественное
+#define LA_STRING         0x00000003    ///<  строка (копируется при записи)
+#define LA_POINTER        0x00000004    ///<  указатель (выводится только значение)
+
+typedef int     LogLevel;
+#define LL_DEBUG          0x00000000    ///<  отладочное сообщение
+#define LL_INFO           0x00000001    ///<  информационное сообщение
+#define LL_WARNING        0x00000002    ///<  предупреждение
+#define LL_ERROR          0x00000003    ///<  ошибка
+
+#define LOG_CHANNEL_DEFAULT  0          ///<  канал лога по умолчанию
+#define LOG_MAX_CHANNELS     64         ///<  максимальное количество каналов лога
+
 typedef int     MbType;
 #define MG_OK             0x00000001    ///<  информирование
 #define MG_YESNO          0x00000002    ///<  да/нет
@@ -212,6 +243,53 @@ typedef struct
   char  sValue[QS_STR_BUFF];        ///<  значение свойства
 } NodePropertyInfo;
 
+// Тип свойства вершины
+typedef enum
+{
+  PROP_STRING=0,            ///<  строка (без проверки значения)
+  PROP_INT,                 ///<  целое
+  PROP_DOUBLE,              ///<  вещественное
+  PROP_BOOL,                ///<  логическое (0/1, true/false, yes/no, on/off)
+  PROP_ENUM                 ///<  перечисление (значение - имя или номер варианта)
+} SnpPropType;
+
+// Описание типизированного свойства вершины (см. DefineNodeProperty)
+typedef struct
+{
+  const char* sKey;                 ///<  название свойства
+  SnpPropType type;                 ///<  тип свойства
+  const char* sDefault;             ///<  значение по умолчанию (NULL - пустое), если свойство еще не задано
+  double      dMin;                 ///<  минимальное значение PROP_INT/PROP_DOUBLE
+  double      dMax;                 ///<  максимальное значение (dMin >= dMax - без ограничения)
+  const char* sEnum;                ///<  варианты PROP_ENUM через '|', например "none|fast|best"
+} PropertyDef;
+
+// Типизированное значение свойства: общее для библиотеки и proxy, обновляется
+// библиотекой при каждой установке значения и читается вызывающим без разбора
+// строки и без вызова библиотеки (указатель действителен, пока существует вершина)
+struct PropValue
+{
+  std::atomic<long long>  i;                ///<  целое значение (PROP_BOOL - 0/1, PROP_ENUM - номер варианта)
+  std::atomic<double>     d;                ///<  вещественное значение
+  std::atomic<unsigned>   version;          ///<  номер изменения значения
+
+  int       toInt() const { return (int)i.load(std::memory_order_relaxed); }
+  long long toLongLong() const { return i.load(std::memory_order_relaxed); }
+  double    toDouble() const { return d.load(std::memory_order_relaxed); }
+  bool      toBool() const { return i.load(std::memory_order_relaxed) != 0; }
+};
+
+// Тип переменной, связанной со свойством вершины (см. BindNodeProperty)
+typedef enum
+{
+  BIND_INT=0,               ///<  int
+  BIND_DOUBLE,              ///<  double
+  BIND_BOOL,                ///<  bool
+  BIND_ATOMIC_INT,          ///<  std::atomic<int>
+  BIND_ATOMIC_DOUBLE,       ///<  std::atomic<double>
+  BIND_ATOMIC_BOOL          ///<  std::atomic<bool>
+} SnpBindType;
+
 // Аналог описания шрифта в Windows
 typedef struct
 {
@@ -250,6 +328,58 @@ typedef struct : public ViewInfo
 
 } TextViewInfo;
 
+// Аргумент отложенного форматирования сообщения (см. LogArgs)
+typedef struct
+{
+  LogArgType  type;                 ///<  тип аргумента
+  union
+  {
+    long long           i;          ///<  LA_INT
+    unsigned long long  u;          ///<  LA_UINT
+    double              d;          ///<  LA_DOUBLE
+    const char*         s;          ///<  LA_STRING
+    const void*         p;          ///<  LA_POINTER
+  };
+} LogArg;
+
+// Фильтр вывода в текстовое окно: общий для библиотеки и proxy,
+// проверяется вызывающим до форматирования сообщения
+struct LogFilter
+{
+  std::atomic<unsigned long long> channels; ///<  маска включенных каналов (бит на канал)
+  std::atomic<int>                level;    ///<  минимальный уровень выводимых сообщений
+
+  /// сообщение уровня level в канале channel будет выведено
+  bool enabled(LogLevel lev, int channel) const
+  {
+    return lev >= level.load(std::memory_order_relaxed) &&
+      ((channels.load(std::memory_order_relaxed) >> (channel & (LOG_MAX_CHANNELS-1))) & 1) != 0;
+  }
+};
+
+// Состояние вершины дерева или элемента панели управления: общее для библиотеки
+// и proxy, обновляется библиотекой и читается вызывающим без вызова функций
+// библиотеки и без обращения к потоку окна (указатель действителен до удаления объекта)
+struct SnapState
+{
+  std::atomic<int>  flags;                  ///<  флаги состояния SF_*
+
+  /// выделен
+  bool checked() const { return (flags.load(std::memory_order_relaxed) & SF_CHECKED) != 0; }
+
+  /// доступен
+  bool enabled() const { return (flags.load(std::memory_order_relaxed) & SF_ENABLED) != 0; }
+
+  /// установка/сброс флагов
+  void set(StateFlags f, bool bSet)
+  {
+    if(bSet)
+      flags.fetch_or(f, std::memory_order_relaxed);
+    else
+      flags.fetch_and(~f, std::memory_order_relaxed);
+  }
+};
+
 // Свойства окна дерева управления
 typedef struct : public ViewInfo
 {
@@ -19,6 +19,7 @@
 
 #include <cstdio>
 #include <cstdarg>
+#include <string>
 #include <typeinfo>
 
 #include <qsnap/qsnap.h>
@@ -284,6 +285,12 @@ inline void QSpxTreeView::saveState()
   QW_SAFECALL(pSaveTreeViewState)(hView);
 }
 
+// запись измененных в окне значений свойств в связанные переменные
+inline int QSpxTreeView::applyBindings()
+{
+  return !pApplyNodeBindings ? 0 : pApplyNodeBindings();
+}
+
 template<class TView> 
 inline TView* QSpxInstance::createView(
   const char* sId                     // [in]  идентификатор окна
@@ -618,17 +625,38 @@ inline QSpxImageView::QSpxImageView(QHandle hView, bool bAttach) : QSpxView(hVie
   //QW_INIT(SetImageViewInfo);
   //QW_INIT(ImageScaleToRect);
   QW_INIT(SetScaleFactor);
+  QW_INIT(SetGroupTransform);
   QW_INIT(DrawPoint);
   QW_INIT(DrawLine);
   QW_INIT(DrawRect);
-  //QW_INIT(DrawPolygon);
+  QW_INIT(DrawPolygon);
   QW_INIT(DrawEllipse);
-  //QW_INIT(DrawArc);
+  QW_INIT(DrawArc);
   QW_INIT(DrawText);
+  QW_INIT(DrawPoints);
+  QW_INIT(DrawLines);
+  QW_INIT(DrawRects);
+  QW_INIT(DrawPolylines);
+  QW_INIT(DrawPointCloud);
+  QW_INIT(DrawTrajectory);
+  QW_INIT(AppendPoint);
+  QW_INIT(SetOverlayMat);
+  QW_INIT(SetOverlayClassVisible);
   QW_INIT(GetUserPoint);
   QW_INIT(GetUserRect);
+  QW_INIT(GetUserPolygon);
+  QW_INIT(GetUserPointInGroup);
+  QW_INIT(GetUserRectInGroup);
+  QW_INIT(GetUserPolygonInGroup);
   QW_INIT(ShowFigure);
+  QW_INIT(RemoveFigure);
+  QW_INIT(MoveFigure);
+  QW_INIT(SetFigureColor);
   QW_INIT(ClearFigures);
+  QW_INIT(ShowGroup);
+  QW_INIT(ClearGroup);
+  QW_INIT(BeginOverlay);
+  QW_INIT(CommitOverlay);
 }
 
 inline QSpxImageView::~QSpxImageView()
@@ -676,12 +704,25 @@ inline QError QSpxImageView::setImage
 inline QError QSpxImageView::setScaleFactor
 (
   double        scale,              // [in] координата по горизонтали
-  const char*   idGroup             // [in] идентификатор группы фигур (not implemented)
+  const char*   idGroup             // [in] идентификатор группы фигур
 )
 {
   return QW_CALL(SetScaleFactor)(hView, scale, idGroup);
 }
 
+// установка преобразования группы фигур (масштаб, поворот, сдвиг)
+inline QError QSpxImageView::setGroupTransform
+(
+  double        scale,              // [in] коэффициент масштабирования
+  double        dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+  double        dy,                 // [in] сдвиг по вертикали (в координатах изображения)
+  double        rotation,           // [in] поворот, градусы (по часовой стрелке на экране)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  return QW_CALL(SetGroupTransform)(hView, scale, dx, dy, rotation, idGroup);
+}
+
 // отрисовка точки
 inline QSpxFigure* QSpxImageView::drawPoint         // [ret] хэндл фигуры
 (
@@ -748,7 +789,28 @@ inline QSpxFigure* QSpxImageView::drawPolygon       // [ret] хэндл фигу
   bool          bRepaint            // [in] отрисовка окна
 )
 {
-  return NULL;
+  QHandle hFigure = QW_NULLCALL(DrawPolygon)(hView, points, szPoints, lineWidth, color, type, idGroup);
+  if(bRepaint)
+    this->update();
+  return (QSpxFigure*)hFigure;
+}
+
+// отрисовка многоугольника, ломанной OpenCV
+inline QSpxFigure* QSpxImageView::drawPolygon       // [ret] хэндл фигуры
+(
+  const std::vector<cv::Point>& points, // [in] массив точек многоугольника
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  PolygonType   type,               // [in] тип многоугольника (ломаная, замкнутый и т.д.)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  if(points.empty())
+    return NULL;
+  int szPoints = (int)points.size();
+  return drawPolygon(reinterpret_cast<SnpPoint*>(const_cast<cv::Point*>(&points[0])), &szPoints,
+    lineWidth, color, type, idGroup, bRepaint);
 }
 
 // отрисовка эллипса
@@ -768,9 +830,12 @@ inline QSpxFigure* QSpxImageView::drawEllipse       // [ret] хэндл фигу
   return NULL;
 }
 
-// отрисовка дуги
+// отрисовка дуги эллипса
 inline QSpxFigure* QSpxImageView::drawArc           // [ret] хэндл фигуры
 (
+  SnpRect       rect,               // [in] координаты охватывающего прямоугольника эллипса
+  double        startAngle,         // [in] начальный угол дуги (градусы)
+  double        spanAngle,          // [in] угловой размер дуги (градусы)
   int           lineWidth,          // [in] толщина линии
   SnpColor      color,              // [in] цвет
   LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
@@ -778,7 +843,10 @@ inline QSpxFigure* QSpxImageView::drawArc           // [ret] хэндл фигу
   bool          bRepaint            // [in] отрисовка окна
 )
 {
-  return NULL;
+  QHandle hFigure = QW_NULLCALL(DrawArc)(hView, &rect, startAngle, spanAngle, lineWidth, color, type, idGroup);
+  if(bRepaint)
+    this->update(&rect);
+  return (QSpxFigure*)hFigure;
 }
 
 // отрисовка текста
@@ -799,6 +867,247 @@ inline QSpxFigure* QSpxImageView::drawText          // [ret] хэндл фигу
   return NULL;
 }
 
+// отрисовка массива точек одной фигурой
+inline QSpxFigure* QSpxImageView::drawPoints        // [ret] хэндл фигуры
+(
+  const SnpPoint* points,           // [in] массив точек
+  int           nPoints,            // [in] количество точек
+  int           ptWidth,            // [in] толщина точки (диаметр)
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  QHandle hFigure = QW_NULLCALL(DrawPoints)(hView, points, nPoints, ptWidth, color, idGroup);
+  if(bRepaint)
+    this->update();
+  return (QSpxFigure*)hFigure;
+}
+
+// отрисовка массива точек OpenCV одной фигурой
+inline QSpxFigure* QSpxImageView::drawPoints        // [ret] хэндл фигуры
+(
+  const std::vector<cv::Point>& points, // [in] массив точек
+  int           ptWidth,            // [in] толщина точки (диаметр)
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  if(points.empty())
+    return NULL;
+  return drawPoints(reinterpret_cast<const SnpPoint*>(&points[0]), (int)points.size(),
+    ptWidth, color, idGroup, bRepaint);
+}
+
+// отрисовка массива линий одной фигурой
+inline QSpxFigure* QSpxImageView::drawLines         // [ret] хэндл фигуры
+(
+  const SnpPoint* points,           // [in] пары точек (начало, конец), 2*nLines элементов
+  int           nLines,             // [in] количество линий
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  QHandle hFigure = QW_NULLCALL(DrawLines)(hView, points, nLines, lineWidth, color, type, idGroup);
+  if(bRepaint)
+    this->update();
+  return (QSpxFigure*)hFigure;
+}
+
+// отрисовка массива линий OpenCV одной фигурой
+inline QSpxFigure* QSpxImageView::drawLines         // [ret] хэндл фигуры
+(
+  const std::vector<cv::Point>& points, // [in] пары точек (начало, конец)
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  if(points.size()<2)
+    return NULL;
+  return drawLines(reinterpret_cast<const SnpPoint*>(&points[0]), (int)points.size()/2,
+    lineWidth, color, type, idGroup, bRepaint);
+}
+
+// отрисовка массива прямоугольников одной фигурой
+inline QSpxFigure* QSpxImageView::drawRects         // [ret] хэндл фигуры
+(
+  const SnpRect* rects,             // [in] массив прямоугольников
+  int           nRects,             // [in] количество прямоугольников
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  QHandle hFigure = QW_NULLCALL(DrawRects)(hView, rects, nRects, lineWidth, color, type, idGroup);
+  if(bRepaint)
+    this->update();
+  return (QSpxFigure*)hFigure;
+}
+
+// отрисовка массива прямоугольников OpenCV одной фигурой
+inline QSpxFigure* QSpxImageView::drawRects         // [ret] хэндл фигуры
+(
+  const std::vector<cv::Rect>& rects, // [in] массив прямоугольников
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  if(rects.empty())
+    return NULL;
+  return drawRects(reinterpret_cast<const SnpRect*>(&rects[0]), (int)rects.size(),
+    lineWidth, color, type, idGroup, bRepaint);
+}
+
+// отрисовка набора ломаных одной фигурой
+inline QSpxFigure* QSpxImageView::drawPolylines     // [ret] хэндл фигуры
+(
+  const SnpPoint* points,           // [in] точки всех ломаных подряд
+  const int*    szPolylines,        // [in] количество точек в каждой ломаной
+  int           nPolylines,         // [in] количество ломаных
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  PolygonType   type,               // [in] тип (замкнутый многоугольник, ломаная)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  QHandle hFigure = QW_NULLCALL(DrawPolylines)(hView, points, szPolylines, nPolylines, lineWidth, color, type, idGroup);
+  if(bRepaint)
+    this->update();
+  return (QSpxFigure*)hFigure;
+}
+
+// отрисовка контуров OpenCV одной фигурой
+// -- контуры укладываются в один непрерывный буфер, библиотека вызывается один раз
+inline QSpxFigure* QSpxImageView::drawPolylines     // [ret] хэндл фигуры
+(
+  const std::vector< std::vector<cv::Point> >& contours, // [in] контуры
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  PolygonType   type,               // [in] тип (замкнутый многоугольник, ломаная)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  if(contours.empty())
+    return NULL;
+
+  size_t nPoints = 0;
+  for(size_t i = 0; i < contours.size(); i++)
+    nPoints += contours[i].size();
+  if(nPoints==0)
+    return NULL;
+
+  std::vector<cv::Point> points;
+  std::vector<int> sizes(contours.size());
+  points.reserve(nPoints);
+  for(size_t i = 0; i < contours.size(); i++)
+  {
+    points.insert(points.end(), contours[i].begin(), contours[i].end());
+    sizes[i] = (int)contours[i].size();
+  }
+
+  return drawPolylines(reinterpret_cast<const SnpPoint*>(&points[0]), &sizes[0], (int)sizes.size(),
+    lineWidth, color, type, idGroup, bRepaint);
+}
+
+// отрисовка облака точек одной фигурой
+inline QSpxFigure* QSpxImageView::drawPointCloud    // [ret] хэндл фигуры
+(
+  const SnpPoint* points,           // [in] массив точек
+  int           nPoints,            // [in] количество точек
+  int           ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+  SnpColor      color,              // [in] цвет
+  PointCloudType type,              // [in] режим отрисовки (плотность, пятна)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  QHandle hFigure = QW_NULLCALL(DrawPointCloud)(hView, points, nPoints, ptWidth, color, type, idGroup);
+  if(bRepaint)
+    this->update();
+  return (QSpxFigure*)hFigure;
+}
+
+// отрисовка облака точек OpenCV одной фигурой
+inline QSpxFigure* QSpxImageView::drawPointCloud    // [ret] хэндл фигуры
+(
+  const std::vector<cv::Point>& points, // [in] массив точек
+  int           ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+  SnpColor      color,              // [in] цвет
+  PointCloudType type,              // [in] режим отрисовки (плотность, пятна)
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  bool          bRepaint            // [in] отрисовка окна
+)
+{
+  if(points.empty())
+    return NULL;
+  return drawPointCloud(reinterpret_cast<const SnpPoint*>(&points[0]), (int)points.size(),
+    ptWidth, color, type, idGroup, bRepaint);
+}
+
+// отрисовка траектории
+inline QSpxFigure* QSpxImageView::drawTrajectory    // [ret] хэндл фигуры
+(
+  int           maxLength,          // [in] максимальное количество точек (0 - без ограничения)
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  const SnpPoint* points,           // [in] начальные точки
+  int           nPoints             // [in] количество точек
+)
+{
+  QHandle hFigure = QW_NULLCALL(DrawTrajectory)(hView, points, nPoints, maxLength, lineWidth, color, idGroup);
+  return (QSpxFigure*)hFigure;
+}
+
+// добавление точки в конец траектории
+inline QError QSpxImageView::appendPoint
+(
+  QSpxFigure*   hFigure,            // [in] хэндл траектории
+  int           x,                  // [in] координата по горизонтали
+  int           y                   // [in] координата по вертикали
+)
+{
+  return QW_CALL(AppendPoint)((QHandle)hFigure, x, y);
+}
+
+// установка полупрозрачного оверлея изображения
+inline QError QSpxImageView::setOverlayMat
+(
+  const cv::Mat& mat,               // [in] CV_8UC1 (метки) или CV_32FC1 (0..1), пустая - удаление
+  OverlayColormap colormap,         // [in] палитра
+  double        alpha,              // [in] непрозрачность 0..1
+  const char*   idGroup,            // [in] идентификатор группы фигур
+  const SnpColor* pLut              // [in] собственная палитра из 256 цветов
+)
+{
+  return QW_CALL(SetOverlayMat)(hView, &mat, colormap, pLut, alpha, idGroup);
+}
+
+// показ/скрытие класса (значения) оверлея изображения
+inline QError QSpxImageView::setOverlayClassVisible
+(
+  int           label,              // [in] значение (индекс палитры)
+  bool          bShow,              // [in] показать/скрыть
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  return QW_CALL(SetOverlayClassVisible)(hView, label, bShow, idGroup);
+}
+
 // выставлена ли пользовательская точка
 inline bool QSpxImageView::userPointSet()
 {
@@ -809,10 +1118,10 @@ inline bool QSpxImageView::userPointSet()
 }
 
 // получение координат пользовательской точки
-inline QSnp::SnpPoint QSpxImageView::getUserPoint()
+inline QSnp::SnpPoint QSpxImageView::getUserPoint(const char* idGroup)
 {
   QSnp::SnpPoint ptUser={0};
-  QW_CALL(GetUserPoint)(hView, &ptUser);
+  QW_CALL(GetUserPointInGroup)(hView, &ptUser, idGroup);
   return ptUser;
 }
 
@@ -841,21 +1150,76 @@ inline bool QSpxImageView::userRectSet()
 }
 
 // получение координат пользовательского прямоугольника
-inline QSnp::SnpRect QSpxImageView::getUserRect()
+inline QSnp::SnpRect QSpxImageView::getUserRect(const char* idGroup)
 {
   QSnp::SnpRect rcUser={0};
-  QW_CALL(GetUserRect)(hView, &rcUser);
+  QW_CALL(GetUserRectInGroup)(hView, &rcUser, idGroup);
   return rcUser;
 }
 
-/*
+// выставлен ли пользовательский многоугольник
+inline bool QSpxImageView::userPolygonSet()
+{
+  return !getUserPolygon().empty();
+}
+
+// получение вершин пользовательского многоугольника
+inline std::vector<QSnp::SnpPoint> QSpxImageView::getUserPolygon(const char* idGroup)
+{
+  std::vector<QSnp::SnpPoint> points;
+  if(!pGetUserPolygonInGroup)
+    return points;
+  int szPoints = 0;
+  pGetUserPolygonInGroup(hView, NULL, &szPoints, idGroup); // запрос размера
+  if(szPoints<=0)
+    return points;
+  points.resize(szPoints);
+  if(pGetUserPolygonInGroup(hView, &points[0], &szPoints, idGroup)!=QERR_NO_ERROR)
+    points.clear();
+  else
+    points.resize(szPoints);
+  return points;
+}
+
 // функция показа/скрытия фигуры
-QError showFigure
+inline QError QSpxImageView::showFigure
 (
-  QHandle       hFigure,            // [in] хэндл фигуры
+  QSpxFigure*   hFigure,            // [in] хэндл фигуры
   bool          bShow               // [in] показать/скрыть
-);
-*/
+)
+{
+  return QW_CALL(ShowFigure)((QHandle)hFigure, bShow);
+}
+
+// функция удаления одной фигуры
+inline QError QSpxImageView::removeFigure
+(
+  QSpxFigure*   hFigure             // [in] хэндл фигуры
+)
+{
+  return QW_CALL(RemoveFigure)((QHandle)hFigure);
+}
+
+// функция сдвига фигуры
+inline QError QSpxImageView::moveFigure
+(
+  QSpxFigure*   hFigure,            // [in] хэндл фигуры
+  int           dx,                 // [in] сдвиг по горизонтали
+  int           dy                  // [in] сдвиг по вертикали
+)
+{
+  return QW_CALL(MoveFigure)((QHandle)hFigure, dx, dy);
+}
+
+// функция изменения цвета фигуры
+inline QError QSpxImageView::setFigureColor
+(
+  QSpxFigure*   hFigure,            // [in] хэндл фигуры
+  SnpColor      color               // [in] цвет
+)
+{
+  return QW_CALL(SetFigureColor)((QHandle)hFigure, color);
+}
 
 // функция удаления всех фигур в данном окне
 inline QError QSpxImageView::clearFigures()
@@ -863,6 +1227,40 @@ inline QError QSpxImageView::clearFigures()
   return QW_CALL(ClearFigures)(hView);
 }
 
+// функция показа/скрытия группы фигур
+inline QError QSpxImageView::showGroup
+(
+  const char*   idGroup,            // [in] id группы фигур
+  bool          bShow               // [in] показать/скрыть
+)
+{
+  return QW_CALL(ShowGroup)(hView, idGroup, bShow);
+}
+
+// функция удаления всех фигур группы
+inline QError QSpxImageView::clearGroup
+(
+  const char*   idGroup             // [in] id группы фигур
+)
+{
+  return QW_CALL(ClearGroup)(hView, idGroup);
+}
+
+// начало построения кадра оверлея
+inline QError QSpxImageView::beginOverlay
+(
+  const char*   idGroup             // [in] id группы фигур
+)
+{
+  return QW_CALL(BeginOverlay)(hView, idGroup);
+}
+
+// показ построенных кадров оверлеев
+inline QError QSpxImageView::commitOverlay()
+{
+  return QW_CALL(CommitOverlay)(hView);
+}
+
 ///////////////////////////////////////////////////////////////////////
 ////  QSpxSyncImageView class
 
@@ -872,6 +1270,8 @@ inline QSpxSyncImageView::QSpxSyncImageView(QHandle hView, bool bAttach) : QSpxI
   // инициализация динамически подгружаемых функций
   QW_INIT(SetSubImage);
   QW_INIT(SetSubMatImage);
+  QW_INIT(SetMatches);
+  QW_INIT(SetMatchThreshold);
 
 #ifdef __MINIMG__
   QW_INIT(SetSubMinImage);
@@ -912,6 +1312,61 @@ inline QError QSpxSyncImageView::setSubImage
   return QW_CALL(SetSubMatImage)(hView, &image, nSubView, flagsShow);
 }
 
+// установка соответствий точек двух окон
+inline QError QSpxSyncImageView::setMatches
+(
+  const SnpPoint* ptsFrom,            // [in]  точки первого окна
+  const SnpPoint* ptsTo,              // [in]  точки второго окна
+  int           nMatches,             // [in]  количество соответствий
+  const float*  scores,               // [in]  оценки соответствий
+  const SnpColor* colors,             // [in]  цвета соответствий
+  int           lineWidth,            // [in]  толщина линий
+  SnpColor      color                 // [in]  цвет по умолчанию
+)
+{
+  return QW_CALL(SetMatches)(hView, ptsFrom, ptsTo, scores, colors, nMatches, lineWidth, color);
+}
+
+// установка соответствий OpenCV
+inline QError QSpxSyncImageView::setMatches
+(
+  const std::vector<cv::KeyPoint>& keysFrom, // [in]  особые точки первого окна
+  const std::vector<cv::KeyPoint>& keysTo,   // [in]  особые точки второго окна
+  const std::vector<cv::DMatch>& matches,    // [in]  соответствия (оценка - минус расстояние)
+  int           lineWidth,            // [in]  толщина линий
+  SnpColor      color                 // [in]  цвет
+)
+{
+  std::vector<SnpPoint> ptsFrom, ptsTo;
+  std::vector<float> scores;
+  ptsFrom.reserve(matches.size());
+  ptsTo.reserve(matches.size());
+  scores.reserve(matches.size());
+  for(size_t i = 0; i < matches.size(); i++)
+  {
+    const cv::DMatch& m = matches[i];
+    if(m.queryIdx<0 || m.queryIdx>=(int)keysFrom.size() || m.trainIdx<0 || m.trainIdx>=(int)keysTo.size())
+      continue;
+    SnpPoint ptFrom = { cvRound(keysFrom[m.queryIdx].pt.x), cvRound(keysFrom[m.queryIdx].pt.y) };
+    SnpPoint ptTo = { cvRound(keysTo[m.trainIdx].pt.x), cvRound(keysTo[m.trainIdx].pt.y) };
+    ptsFrom.push_back(ptFrom);
+    ptsTo.push_back(ptTo);
+    scores.push_back(-m.distance); // меньшее расстояние - лучшее соответствие
+  }
+  if(ptsFrom.empty())
+    return QW_CALL(SetMatches)(hView, NULL, NULL, NULL, NULL, 0, lineWidth, color);
+  return QW_CALL(SetMatches)(hView, &ptsFrom[0], &ptsTo[0], &scores[0], NULL, (int)ptsFrom.size(), lineWidth, color);
+}
+
+// установка порога оценки показываемых соответствий
+inline QError QSpxSyncImageView::setMatchThreshold
+(
+  float         threshold             // [in]  показываются соответствия с оценкой >= threshold
+)
+{
+  return QW_CALL(SetMatchThreshold)(hView, threshold);
+}
+
 #ifdef __MINIMG__
 
 // установка изображения
@@ -1097,7 +1552,18 @@ inline QSpxTextView::QSpxTextView(QHandle hView, bool bAttach) : QSpxView(hView,
   QW_INIT(Log);
   QW_INIT(LogLn);
   QW_INIT(LogEx);
+  QW_INIT(LogLnAt);
+  QW_INIT(LogArgsAt);
+  QW_INIT(LogArgs);
   QW_INIT(ClearTextView);
+  QW_INIT(SetLogLimits);
+  QW_INIT(SetLogSpill);
+  QW_INIT(GetLogFilter);
+  QW_INIT(RegisterLogChannel);
+  QW_INIT(EnableLogChannel);
+  QW_INIT(SetLogLevel);
+
+  pLogFilter = QW_NULLCALL(GetLogFilter)(hView);
 }
 
 inline QSpxTextView::~QSpxTextView()
@@ -1111,13 +1577,23 @@ inline QError QSpxTextView::log
   ...                                // [in]  параметры шаблона
 )
 {
+  if(!isLogEnabled(LL_INFO))
+    return QERR_NO_ERROR;
+
   char strbuf[4096]; strbuf[0]=0;
   va_list list;
   va_start(list, sText );
-  vsprintf( strbuf, sText, list );
+  int len = vsnprintf( strbuf, sizeof(strbuf), sText, list );
   va_end( list );
+  if(len < (int)sizeof(strbuf))
+    return QW_CALL(Log)(hView, "%s", strbuf);
 
-  return QW_CALL(Log)(hView, strbuf);
+  // длинное сообщение форматируется в буфер нужного размера
+  std::vector<char> strLong(len + 1);
+  va_start(list, sText );
+  vsnprintf( &strLong[0], strLong.size(), sText, list );
+  va_end( list );
+  return QW_CALL(Log)(hView, "%s", &strLong[0]);
 }
 
 // вывод текстового сообщения
@@ -1127,20 +1603,152 @@ inline QError QSpxTextView::logLn
   ...                                // [in]  параметры шаблона
 )
 {
+  if(!isLogEnabled(LL_INFO))
+    return QERR_NO_ERROR;
+
   char strbuf[4096]; strbuf[0]=0;
   va_list list;
   va_start(list, sText );
-  vsprintf( strbuf, sText, list );
+  int len = vsnprintf( strbuf, sizeof(strbuf), sText, list );
   va_end( list );
+  if(len < (int)sizeof(strbuf))
+    return QW_CALL(LogLn)(hView, "%s", strbuf);
+
+  // длинное сообщение форматируется в буфер нужного размера
+  std::vector<char> strLong(len + 1);
+  va_start(list, sText );
+  vsnprintf( &strLong[0], strLong.size(), sText, list );
+  va_end( list );
+  return QW_CALL(LogLn)(hView, "%s", &strLong[0]);
+}
+
+// аргументы отложенного вывода: тип аргумента определяется перегрузкой
+inline LogArg qspxLogArg(int v)                { LogArg a; a.type = LA_INT;    a.i = v; return a; }
+inline LogArg qspxLogArg(long v)               { LogArg a; a.type = LA_INT;    a.i = v; return a; }
+inline LogArg qspxLogArg(long long v)          { LogArg a; a.type = LA_INT;    a.i = v; return a; }
+inline LogArg qspxLogArg(unsigned int v)       { LogArg a; a.type = LA_UINT;   a.u = v; return a; }
+inline LogArg qspxLogArg(unsigned long v)      { LogArg a; a.type = LA_UINT;   a.u = v; return a; }
+inline LogArg qspxLogArg(unsigned long long v) { LogArg a; a.type = LA_UINT;   a.u = v; return a; }
+inline LogArg qspxLogArg(double v)             { LogArg a; a.type = LA_DOUBLE; a.d = v; return a; }
+inline LogArg qspxLogArg(long double v)        { LogArg a; a.type = LA_DOUBLE; a.d = (double)v; return a; }
+inline LogArg qspxLogArg(const char* v)        { LogArg a; a.type = LA_STRING; a.s = v; return a; }
+inline LogArg qspxLogArg(const std::string& v) { LogArg a; a.type = LA_STRING; a.s = v.c_str(); return a; }
+
+template <typename T>
+inline LogArg qspxLogArg(const T* v)           { LogArg a; a.type = LA_POINTER; a.p = v; return a; }
+
+// отложенный вывод текстового сообщения
+template <typename... Args>
+inline QError QSpxTextView::logArgs
+(
+  const char* sFormat,               // [in]  строка формата printf
+  const Args&... args                // [in]  параметры шаблона
+)
+{
+  if(!isLogEnabled(LL_INFO))
+    return QERR_NO_ERROR;
 
-  return QW_CALL(LogLn)(hView, strbuf);
+  LogArg argv[sizeof...(Args) + 1] = { qspxLogArg(args)... };
+  return QW_CALL(LogArgs)(hView, sFormat, argv, (int)sizeof...(Args), false);
 }
 
+// отложенный вывод текстового сообщения отдельной строкой
+template <typename... Args>
+inline QError QSpxTextView::logArgsLn
+(
+  const char* sFormat,               // [in]  строка формата printf
+  const Args&... args                // [in]  параметры шаблона
+)
+{
+  if(!isLogEnabled(LL_INFO))
+    return QERR_NO_ERROR;
 
-// вывод расширенного текстового сообщения
-inline QError QSpxTextView::logEx
+  LogArg argv[sizeof...(Args) + 1] = { qspxLogArg(args)... };
+  return QW_CALL(LogArgs)(hView, sFormat, argv, (int)sizeof...(Args), true);
+}
+
+// вывод сообщения уровня level в канал channel отдельной строкой
+inline QError QSpxTextView::logLnAt
 (
+  LogLevel    level,                 // [in]  уровень сообщения LL_*
+  int         channel,               // [in]  канал (см. registerChannel)
   const char* sText,                 // [in]  текстовый шаблон
+  ...                                // [in]  параметры шаблона
+)
+{
+  if(!isLogEnabled(level, channel))
+    return QERR_NO_ERROR;
+
+  char strbuf[4096]; strbuf[0]=0;
+  va_list list;
+  va_start(list, sText );
+  int len = vsnprintf( strbuf, sizeof(strbuf), sText, list );
+  va_end( list );
+  if(len < (int)sizeof(strbuf))
+    return QW_CALL(LogLnAt)(hView, level, "%s", strbuf);
+
+  std::vector<char> strLong(len + 1);
+  va_start(list, sText );
+  vsnprintf( &strLong[0], strLong.size(), sText, list );
+  va_end( list );
+  return QW_CALL(LogLnAt)(hView, level, "%s", &strLong[0]);
+}
+
+// отложенный вывод сообщения уровня level в канал channel отдельной строкой
+template <typename... Args>
+inline QError QSpxTextView::logArgsLnAt
+(
+  LogLevel    level,                 // [in]  уровень сообщения LL_*
+  int         channel,               // [in]  канал (см. registerChannel)
+  const char* sFormat,               // [in]  строка формата printf
+  const Args&... args                // [in]  параметры шаблона
+)
+{
+  if(!isLogEnabled(level, channel))
+    return QERR_NO_ERROR;
+
+  LogArg argv[sizeof...(Args) + 1] = { qspxLogArg(args)... };
+  return QW_CALL(LogArgsAt)(hView, level, sFormat, argv, (int)sizeof...(Args), true);
+}
+
+// присоединение к окну по хэндлу
+inline bool QSpxTextView::attach(QHandle _hView)
+{
+  QSpxView::attach(_hView);
+  pLogFilter = QW_NULLCALL(GetLogFilter)(_hView);
+  return true;
+}
+
+// отсоединение от окна
+inline bool QSpxTextView::detach()
+{
+  pLogFilter = 0;
+  return QSpxView::detach();
+}
+
+// регистрация именованного канала
+inline int QSpxTextView::registerChannel(const char* sName, bool bEnabled)
+{
+  return !pRegisterLogChannel ? -1 : pRegisterLogChannel(hView, sName, bEnabled);
+}
+
+// включение/отключение канала
+inline QError QSpxTextView::enableChannel(int channel, bool bEnable)
+{
+  return QW_CALL(EnableLogChannel)(hView, channel, bEnable);
+}
+
+// установка минимального уровня выводимых сообщений
+inline QError QSpxTextView::setLogLevel(LogLevel level)
+{
+  return QW_CALL(SetLogLevel)(hView, level);
+}
+
+
+// вывод текста цветом color и шрифтом flags
+inline QError QSpxTextView::logEx
+(
+  const char* sText,                 // [in]  текст сообщения
   SnpColor    color,                 // [in]  цвет текста
   FontFlags   flags                  // [in]  параметры шрифта
 )
@@ -1154,6 +1762,27 @@ inline QError QSpxTextView::clear()
   return QW_CALL(ClearTextView)(hView);
 }
 
+// ограничение объема лога
+inline QError QSpxTextView::setLogLimits
+(
+  int         maxLines,              // [in]  максимальное количество строк
+  long long   maxBytes               // [in]  максимальный объем текста в байтах
+)
+{
+  return QW_CALL(SetLogLimits)(hView, maxLines, maxBytes);
+}
+
+// выгрузка вытесненных строк в файлы-сегменты
+inline QError QSpxTextView::setLogSpill
+(
+  const char* sDir,                  // [in]  каталог файлов выгрузки
+  long long   segmentBytes,          // [in]  размер файла-сегмента
+  int         maxSegments            // [in]  максимальное количество сегментов
+)
+{
+  return QW_CALL(SetLogSpill)(hView, sDir, segmentBytes, maxSegments);
+}
+
 
 ///////////////////////////////////////////////////////////////////////
 ////  QSpxTreeView class
@@ -1332,6 +1961,7 @@ inline QSpxTreeView::QSpxTreeView(QHandle hView, bool bAttach)  : QSpxView(hView
   QW_INIT(FindNode);
   QW_INIT(NodeChecked);
   QW_INIT(CheckNode);
+  QW_INIT(GetNodeState);
   QW_INIT(GetParentNode);
   QW_INIT(GetFirstChildNode);
   QW_INIT(GetNextChildNode);
@@ -1347,6 +1977,11 @@ inline QSpxTreeView::QSpxTreeView(QHandle hView, bool bAttach)  : QSpxView(hView
   QW_INIT(SaveNodeProperties);
   QW_INIT(LoadNodeProperty);
   QW_INIT(SaveNodeProperty);
+  QW_INIT(DefineNodeProperty);
+  QW_INIT(GetNodePropertyValue);
+  QW_INIT(GetNodePropertiesVersion);
+  QW_INIT(BindNodeProperty);
+  QW_INIT(ApplyNodeBindings);
   QW_INIT(LoadTreeViewState);
   QW_INIT(SaveTreeViewState);
 
@@ -1403,6 +2038,29 @@ inline QSpxNode::QSpxNode(QHandle h, QSpxTreeView* p)
   pView = p;
   if(hNode && pView)
     memcpy(&nodeInfo, info(), sizeof(NodeInfo));
+  resolvePublished();
+}
+
+// установка хэндла вершины
+inline void QSpxNode::setHandle(QHandle h)
+{
+  hNode = h;
+  resolvePublished();
+}
+
+// установка окна дерева снепа
+inline void QSpxNode::setTreeView(QSpxTreeView* p)
+{
+  pView = p;
+  resolvePublished();
+}
+
+// получение опубликованных библиотекой состояний вершины
+inline void QSpxNode::resolvePublished()
+{
+  bool bValid = hNode && pView;
+  pState = !bValid || !pView->pGetNodeState ? 0 : pView->pGetNodeState(hNode);
+  pPropVersion = !bValid || !pView->pGetNodePropertiesVersion ? 0 : pView->pGetNodePropertiesVersion(hNode);
 }
 
   // добавление вершины
@@ -1520,6 +2178,8 @@ inline QError QSpxNode::setColor(SnpColor color)
 // проверка выделена ли вершина
 inline bool QSpxNode::isChecked()
 {
+  if(pState)
+    return pState->checked();
   return QW_PCALL(pView,NodeChecked)(hNode) != 0;
 }
 
@@ -1686,6 +2346,45 @@ inline QError QSpxNode::saveProperty
   return QW_PCALL(pView,SaveNodeProperty)(hNode, sKey);
 }
 
+// описание типизированного свойства
+inline QError QSpxNode::defineProperty
+(
+  const char* sKey,                  // [in]  название свойства
+  SnpPropType type,                  // [in]  тип свойства
+  const char* sDefault,              // [in]  значение по умолчанию
+  double      dMin,                  // [in]  минимальное значение
+  double      dMax,                  // [in]  максимальное значение (dMin >= dMax - без ограничения)
+  const char* sEnum                  // [in]  варианты PROP_ENUM через '|'
+)
+{
+  PropertyDef def = { sKey, type, sDefault, dMin, dMax, sEnum };
+  return QW_PCALL(pView,DefineNodeProperty)(hNode, &def);
+}
+
+// типизированное значение свойства
+inline const PropValue* QSpxNode::propertyValue // [ret] значение, NULL при неверной вершине или названии
+(
+  const char* sKey                   // [in]  название свойства
+)
+{
+  if(!pView || !pView->pGetNodePropertyValue)
+    return 0;
+
+  return pView->pGetNodePropertyValue(hNode, sKey);
+}
+
+// номер изменения свойств вершины
+inline unsigned QSpxNode::propertiesVersion()
+{
+  return pPropVersion ? pPropVersion->load(std::memory_order_acquire) : 0;
+}
+
+// связывание свойства с переменной заданного типа
+inline QError QSpxNode::bindVar(const char* sKey, SnpBindType type, void* pVar)
+{
+  return QW_PCALL(pView,BindNodeProperty)(hNode, sKey, type, pVar);
+}
+
 
 ///////////////////////////////////////////////////////////////////////
 ////  QSpxToolbar class
@@ -1695,6 +2394,9 @@ inline QSpxToolbar::QSpxToolbar(QHandle hView, bool bAttach)  : QSpxView(hView,
   // инициализация динамически подгружаемых функций
   QW_INIT(AddControl);
   QW_INIT(RemoveControl);
+  QW_INIT(GetControlState);
+  QW_INIT(CheckControl);
+  QW_INIT(EnableControl);
 }
 
 inline QSpxToolbar::~QSpxToolbar()
@@ -1717,6 +2419,32 @@ inline QError QSpxToolbar::removeControl
   return QW_CALL(RemoveControl)(hControl);
 }
 
+inline const SnapState* QSpxToolbar::controlState
+(
+  QHandle         hControl          // [in]  хэндл элемента управления
+)
+{
+  return QW_NULLCALL(GetControlState)(hControl);
+}
+
+inline QError QSpxToolbar::checkControl
+(
+  QHandle         hControl,         // [in]  хэндл элемента управления
+  bool            bCheck            // [in]  нажать/отпустить
+)
+{
+  return QW_CALL(CheckControl)(hControl, bCheck);
+}
+
+inline QError QSpxToolbar::enableControl
+(
+  QHandle         hControl,         // [in]  хэндл элемента управления
+  bool            bEnable           // [in]  включить/отключить
+)
+{
+  return QW_CALL(EnableControl)(hControl, bEnable);
+}
+
 inline QSpxExternalWidget::QSpxExternalWidget(
   const char* dllname,
   QHandle hHandle
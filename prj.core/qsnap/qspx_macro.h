@@ -53,6 +53,9 @@
 // вызов функции возвращающей значение только в случае не нулевого указателя (safe call)
 #define QW_BOOLCALL( cl ) cl && cl
 
+// вывод в лог только при включенных уровне и канале: без вычисления аргументов и форматирования
+#define QW_LOG( view, level, channel, ... ) if(!((view) && (view)->isLogEnabled(level, channel))) ; else (view)->logArgsLnAt(level, channel, __VA_ARGS__)
+
 // удаление вызов функции возвращающей значение только в случае не нулевого указателя (safe call)
 #define QW_RELEASE( view ) { if (view) delete view; view = 0; }
 
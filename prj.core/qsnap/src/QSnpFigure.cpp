@@ -7,6 +7,25 @@
 
 #include "QSnpFigure.h"
 #include "QSnpView.h"
+#include "QSnpImageWidget.h"
+
+#include <QWidget>
+
+#include <cmath>
+
+// перо с толщиной в пикселях экрана при любом преобразовании QPainter
+static QPen cosmeticPen(const QColor& color, int width, Qt::PenCapStyle cap = Qt::SquareCap)
+{
+  QPen pen(QBrush(color), width, Qt::SolidLine, cap);
+  pen.setCosmetic(true);
+  return pen;
+}
+
+// коэффициент масштабирования, вносимый преобразованием QPainter (преобразование группы)
+static float transformScale(const QPainter* pPainter)
+{
+  return float(sqrt(qAbs(pPainter->worldTransform().determinant())));
+}
 
 /////////////////////////////////////////////////////////////////
 ////  QSnpFigure
@@ -15,22 +34,108 @@ QSnpFigure::QSnpFigure(QSnpView* p)
 {
   bVisible = true;
   pView = p;
+  pGroup = 0;
+  nGroupIndex = -1;
+  hFigure = QSnpFigureTable::attach(this);
 }
 
 QSnpFigure::~QSnpFigure(void)
 {
+  QSnpFigureTable::detach(hFigure);
 }
 
 void QSnpFigure::setVisible(bool _bVisible)
 {  
   bVisible = _bVisible;
+  update();
+}
+
+void QSnpFigure::setColor(const QColor& _color)
+{
+  color = _color;
+  update();
+}
+
+void QSnpFigure::move(int dx, int dy)
+{
+  translate(QPoint(dx, dy));
+  update();
+}
+
+void QSnpFigure::invalidate()
+{
+  if(pGroup)
+    pGroup->invalidate();
+}
+
+void QSnpFigure::update()
+{
+  invalidate();
   QSnpView* pView = getView();
   if(!pView)
     return;
   QWidget* pWidget = pView->getWidget();
   if(!pWidget)
     return;
-  pWidget->repaint();
+  pWidget->update();
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpFigureTable
+
+QVector<QSnpFigureTable::Slot> QSnpFigureTable::vecSlots;
+QQueue<int> QSnpFigureTable::queueFree;
+QMutex QSnpFigureTable::mutex;
+
+QHandle QSnpFigureTable::attach(QSnpFigure* pFigure)
+{
+  QMutexLocker lock(&mutex);
+  int index;
+  if(!queueFree.isEmpty())
+    index = queueFree.dequeue();
+  else
+  {
+    if(vecSlots.size() >= (int)QSNP_FIGURE_INDEX_MASK)
+      return QHANDLE_NULL;
+    Slot slot = { 0, 1 };
+    index = vecSlots.size();
+    vecSlots.push_back(slot);
+  }
+
+  Slot& slot = vecSlots[index];
+  slot.pFigure = pFigure;
+  return ((QHandle)slot.nGeneration << QSNP_FIGURE_INDEX_BITS) | (QHandle)(index + 1);
+}
+
+void QSnpFigureTable::detach(QHandle hFigure)
+{
+  QMutexLocker lock(&mutex);
+  if(!lookup(hFigure))
+    return;
+  int index = int(hFigure & QSNP_FIGURE_INDEX_MASK) - 1;
+  Slot& slot = vecSlots[index];
+  slot.pFigure = 0;
+  slot.nGeneration = (slot.nGeneration + 1) & QSNP_FIGURE_GEN_MASK;
+  if(slot.nGeneration == 0) // поколение 0 не выдается
+    slot.nGeneration = 1;
+  queueFree.enqueue(index);
+}
+
+QSnpFigure* QSnpFigureTable::find(QHandle hFigure)
+{
+  QMutexLocker lock(&mutex);
+  return lookup(hFigure);
+}
+
+QSnpFigure* QSnpFigureTable::lookup(QHandle hFigure)
+{
+  int index = int(hFigure & QSNP_FIGURE_INDEX_MASK) - 1;
+  if(index < 0 || index >= vecSlots.size())
+    return 0;
+  const Slot& slot = vecSlots[index];
+  if(slot.nGeneration != quint64(hFigure >> QSNP_FIGURE_INDEX_BITS))
+    return 0;
+  return slot.pFigure;
 }
 
 /////////////////////////////////////////////////////////////////
@@ -49,7 +154,7 @@ QSnpLine::~QSnpLine(void)
 void QSnpLine::Draw(QPainter* pPainter, float ratio)
 {
   pPainter->setRenderHint(QPainter::Antialiasing, true);
-  pPainter->setPen( QPen(color, lineWidth) );
+  pPainter->setPen(cosmeticPen(color, lineWidth));
   
   QPoint ptImageFrom = QPoint_scale(ptFrom, ratio);
   QPoint ptImageTo = QPoint_scale(ptTo, ratio);
@@ -57,6 +162,13 @@ void QSnpLine::Draw(QPainter* pPainter, float ratio)
   pPainter->drawLine(ptImageFrom, ptImageTo);
 }
 
+void QSnpLine::translate(const QPoint& offset)
+{
+  QSnpFigure::translate(offset);
+  ptFrom += offset;
+  ptTo += offset;
+}
+
 /////////////////////////////////////////////////////////////////
 ////  QSnpRect
 
@@ -72,7 +184,7 @@ QSnpRect::~QSnpRect(void)
 
 void QSnpRect::Draw(QPainter* pPainter, float ratio)
 {
-  pPainter->setPen(QPen(color, lineWidth));
+  pPainter->setPen(cosmeticPen(color, lineWidth));
   pPainter->setBrush(QBrush(Qt::NoBrush));
 
   QRect rcImage = QRect_scale(rc, ratio);
@@ -94,7 +206,7 @@ QSnpEllipse::~QSnpEllipse(void)
 
 void QSnpEllipse::Draw(QPainter* pPainter, float ratio)
 {
-  pPainter->setPen(QPen(color, lineWidth));
+  pPainter->setPen(cosmeticPen(color, lineWidth));
   pPainter->setBrush(QBrush(Qt::NoBrush));
 
   QRect rcImage = QRect_scale(rc, ratio);
@@ -113,24 +225,76 @@ QSnpText::QSnpText(QSnpView* pView) : QSnpFigure(pView)
   bItalic   = false;
   fontType  = "Consolas";
   textValue = "";
+  fontSize  = 10;
+  layoutRatio = 0;
+  staticText.setTextFormat(Qt::PlainText);
 }
 
 QSnpText::~QSnpText(void)
 {
 }
 
+void QSnpText::setText(const QString& text)
+{
+  textValue = text;
+  invalidateLayout();
+}
+
+// кэш шрифтов по (гарнитура, кегль, флаги): QFont не создается при каждой отрисовке
+static const QFont& cachedFont(const QString& family, double size, bool bBold, bool bItalic)
+{
+  static QHash<QString, QFont> fonts;
+
+  QString key = QString("%1|%2|%3").arg(family).arg(size).arg(int(bBold) | int(bItalic)<<1);
+  QHash<QString, QFont>::iterator it = fonts.find(key);
+  if(it==fonts.end())
+  {
+    QFont font(family);
+    font.setPointSizeF(size > 0 ? size : 1);
+    font.setBold(bBold);
+    font.setItalic(bItalic);
+    it = fonts.insert(key, font);
+  }
+  return *it;
+}
+
 void QSnpText::Draw(QPainter* pPainter, float ratio)
 {
+  // надпись не поворачивается и не масштабируется группой: переносится только ее прямоугольник
+  QRect rcImage = pPainter->worldTransform().mapRect(QRect_scale(rc, ratio));
+  float ratioText = ratio*transformScale(pPainter);
+
+  // надпись слишком мелкая при текущем масштабе
+  if(rcImage.height() < QSNP_MIN_TEXT_PIXELS || rcImage.width() < QSNP_MIN_TEXT_PIXELS)
+    return;
+
+  const QFont& font = cachedFont(fontType, fontSize, bBold, bItalic);
   pPainter->setPen(QPen(color, lineWidth));
   pPainter->setBrush(QBrush(Qt::NoBrush));
-  
-  QFont font(fontType, fontSize);
-  font.setBold(bBold);
-  font.setItalic(bItalic);
   pPainter->setFont(font);
 
-  QRect rcImage = QRect_scale(rc, ratio);
-  pPainter->drawText(rcImage, textValue, QTextOption((Qt::AlignmentFlag)alignment));
+  // раскладка текста готовится один раз и перестраивается только при изменении текста или масштаба
+  if(layoutRatio != ratioText)
+  {
+    staticText.setText(textValue);
+    staticText.setTextWidth(rcImage.width());
+    staticText.setTextOption(QTextOption(Qt::Alignment(alignment) & Qt::AlignHorizontal_Mask));
+    staticText.prepare(QTransform(), font);
+    layoutRatio = ratioText;
+  }
+
+  // вертикальное выравнивание внутри охватывающего прямоугольника
+  QPointF pos = rcImage.topLeft();
+  qreal dy = rcImage.height() - staticText.size().height();
+  if(alignment & Qt::AlignBottom)
+    pos.ry() += dy;
+  else if(alignment & Qt::AlignVCenter)
+    pos.ry() += dy/2;
+
+  pPainter->save();
+  pPainter->setWorldTransform(QTransform());
+  pPainter->drawStaticText(pos, staticText);
+  pPainter->restore();
 }
 
 /////////////////////////////////////////////////////////////////
@@ -150,18 +314,808 @@ QSnpPoint::~QSnpPoint(void)
 {
 }
 
+void QSnpPoint::translate(const QPoint& offset)
+{
+  // точка рисуется по центру mX, mY, а не по rc
+  mX += offset.x();
+  mY += offset.y();
+  QSnpFigure::translate(offset);
+}
+
 void QSnpPoint::Draw(QPainter* pPainter, float ratio)
 {
   pPainter->setRenderHint(QPainter::Antialiasing, true);
   pPainter->setPen(QPen(color, 1));
   pPainter->setBrush(QBrush(color));
 
+  // размер точки задан в пикселях экрана: преобразование группы переносит только ее центр
+  QPoint pt = pPainter->worldTransform().map(QPoint(float_scale(mX+0.5,ratio), float_scale(mY+0.5,ratio)));
   QRect rcImage(
-    float_scale(mX+0.5,ratio)-lineWidth/2, 
-    float_scale(mY+0.5,ratio)-lineWidth/2,
+    pt.x()-lineWidth/2, 
+    pt.y()-lineWidth/2,
     lineWidth, 
     lineWidth
     );
 
+  pPainter->save();
+  pPainter->setWorldTransform(QTransform());
   pPainter->drawEllipse(rcImage);
-}
\ No newline at end of file
+  pPainter->restore();
+}
+
+/////////////////////////////////////////////////////////////////
+////  Массивы фигур рисуются в координатах изображения:
+////  масштаб задается преобразованием QPainter, толщина пера
+////  остается в пикселях экрана (cosmetic pen)
+
+/////////////////////////////////////////////////////////////////
+////  QSnpPointArray
+
+QSnpPointArray::QSnpPointArray(QSnpView* pView) : QSnpFigure(pView)
+{
+  color = Qt::red;
+  lineWidth = 1;
+}
+
+QSnpPointArray::~QSnpPointArray(void)
+{
+}
+
+void QSnpPointArray::Draw(QPainter* pPainter, float ratio)
+{
+  pPainter->save();
+  pPainter->setRenderHint(QPainter::Antialiasing, true);
+  pPainter->setPen(cosmeticPen(color, lineWidth, Qt::RoundCap));
+  pPainter->scale(ratio, ratio);
+  pPainter->translate(0.5, 0.5); // центр пикселя, как в QSnpPoint
+
+  pPainter->drawPoints(points.constData(), points.size());
+  pPainter->restore();
+}
+
+void QSnpPointArray::translate(const QPoint& offset)
+{
+  QSnpFigure::translate(offset);
+  QPoint* pts = points.data();
+  for(int i = 0; i < points.size(); i++)
+    pts[i] += offset;
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpLineArray
+
+QSnpLineArray::QSnpLineArray(QSnpView* pView) : QSnpFigure(pView)
+{
+  color = Qt::red;
+  lineWidth = 1;
+}
+
+QSnpLineArray::~QSnpLineArray(void)
+{
+}
+
+void QSnpLineArray::Draw(QPainter* pPainter, float ratio)
+{
+  pPainter->save();
+  pPainter->setRenderHint(QPainter::Antialiasing, true);
+  pPainter->setPen(cosmeticPen(color, lineWidth));
+  pPainter->scale(ratio, ratio);
+
+  pPainter->drawLines(points.constData(), points.size()/2);
+  pPainter->restore();
+}
+
+void QSnpLineArray::translate(const QPoint& offset)
+{
+  QSnpFigure::translate(offset);
+  QPoint* pts = points.data();
+  for(int i = 0; i < points.size(); i++)
+    pts[i] += offset;
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpRectArray
+
+QSnpRectArray::QSnpRectArray(QSnpView* pView) : QSnpFigure(pView)
+{
+  color = Qt::red;
+  lineWidth = 1;
+}
+
+QSnpRectArray::~QSnpRectArray(void)
+{
+}
+
+void QSnpRectArray::Draw(QPainter* pPainter, float ratio)
+{
+  pPainter->save();
+  pPainter->setPen(cosmeticPen(color, lineWidth));
+  pPainter->setBrush(QBrush(Qt::NoBrush));
+  pPainter->scale(ratio, ratio);
+
+  pPainter->drawRects(rects.constData(), rects.size());
+  pPainter->restore();
+}
+
+void QSnpRectArray::translate(const QPoint& offset)
+{
+  QSnpFigure::translate(offset);
+  for(int i = 0; i < rects.size(); i++)
+    rects[i].translate(offset);
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpPolylineArray
+
+QSnpPolylineArray::QSnpPolylineArray(QSnpView* pView) : QSnpFigure(pView)
+{
+  color = Qt::red;
+  lineWidth = 1;
+  bClosed = true;
+}
+
+QSnpPolylineArray::~QSnpPolylineArray(void)
+{
+}
+
+// уровень детализации для масштаба: 0 - без упрощения, L - масштаб порядка 1/2^L
+static int lodLevel(float ratio)
+{
+  int level = 0;
+  while(ratio < 0.75f && level < QSNP_LOD_MAX_LEVEL)
+  {
+    ratio *= 2;
+    level++;
+  }
+  return level;
+}
+
+// упрощение ломаной алгоритмом Douglas-Peucker (без рекурсии) с точностью eps
+static void simplifyDP(const QPoint* pts, int n, double eps, QVector<QPoint>& out)
+{
+  if(n<=2)
+  {
+    for(int i = 0; i < n; i++)
+      out.append(pts[i]);
+    return;
+  }
+
+  QVector<char> keep(n, 0);
+  keep[0] = keep[n-1] = 1;
+
+  double eps2 = eps*eps;
+  QVector<QPair<int,int> > stack;
+  stack.append(qMakePair(0, n-1));
+  while(!stack.isEmpty())
+  {
+    int a = stack.last().first;
+    int b = stack.last().second;
+    stack.pop_back();
+    if(b-a<2)
+      continue;
+
+    // самая удаленная от отрезка [a,b] точка
+    double dx = pts[b].x()-pts[a].x(), dy = pts[b].y()-pts[a].y();
+    double len2 = dx*dx + dy*dy;
+    double dmax = -1;
+    int imax = a;
+    for(int i = a+1; i < b; i++)
+    {
+      double px = pts[i].x()-pts[a].x(), py = pts[i].y()-pts[a].y();
+      double cross = px*dy - py*dx;
+      double d2 = len2 > 0 ? cross*cross/len2 : px*px + py*py;
+      if(d2 > dmax)
+      {
+        dmax = d2;
+        imax = i;
+      }
+    }
+
+    if(dmax > eps2)
+    {
+      keep[imax] = 1;
+      stack.append(qMakePair(a, imax));
+      stack.append(qMakePair(imax, b));
+    }
+  }
+
+  for(int i = 0; i < n; i++)
+    if(keep[i])
+      out.append(pts[i]);
+}
+
+const QSnpPolylineLod& QSnpPolylineArray::lod(int level)
+{
+  QMap<int, QSnpPolylineLod>::iterator it = lods.find(level);
+  if(it!=lods.end())
+    return *it;
+
+  // допуск в координатах изображения: около пикселя экрана при масштабе 1/2^level
+  double eps = 0.5 * (1 << level);
+
+  QSnpPolylineLod& lod = lods[level];
+  lod.sizes.reserve(sizes.size());
+  const QPoint* pts = points.constData();
+  for(int i = 0; i < sizes.size(); i++)
+  {
+    int n = sizes[i];
+    int nBefore = lod.points.size();
+    if(bClosed && n > 3)
+    {
+      // замкнутый контур делится на две цепочки по самой удаленной от начала точке
+      int iFar = 0;
+      qint64 dFar = -1;
+      for(int j = 1; j < n; j++)
+      {
+        qint64 dx = pts[j].x()-pts[0].x(), dy = pts[j].y()-pts[0].y();
+        if(dx*dx + dy*dy > dFar)
+        {
+          dFar = dx*dx + dy*dy;
+          iFar = j;
+        }
+      }
+      simplifyDP(pts, iFar+1, eps, lod.points);
+      lod.points.pop_back(); // точка iFar - начало второй цепочки
+      simplifyDP(pts+iFar, n-iFar, eps, lod.points);
+    }
+    else
+      simplifyDP(pts, n, eps, lod.points);
+    lod.sizes.append(lod.points.size()-nBefore);
+    pts += n;
+  }
+  return lod;
+}
+
+void QSnpPolylineArray::Draw(QPainter* pPainter, float ratio)
+{
+  // при уменьшении рисуется упрощенная копия контуров
+  const QVector<QPoint>* pPoints = &points;
+  const QVector<int>* pSizes = &sizes;
+  int level = lodLevel(ratio*transformScale(pPainter));
+  if(level > 0 && points.size() >= QSNP_LOD_MIN_POINTS)
+  {
+    const QSnpPolylineLod& lodCurr = lod(level);
+    pPoints = &lodCurr.points;
+    pSizes = &lodCurr.sizes;
+  }
+
+  pPainter->save();
+  pPainter->setRenderHint(QPainter::Antialiasing, true);
+  pPainter->setPen(cosmeticPen(color, lineWidth));
+  pPainter->setBrush(QBrush(Qt::NoBrush));
+  pPainter->scale(ratio, ratio);
+
+  const QPoint* pts = pPoints->constData();
+  for(int i = 0; i < pSizes->size(); i++)
+  {
+    int n = pSizes->at(i);
+    if(bClosed)
+      pPainter->drawPolygon(pts, n);
+    else
+      pPainter->drawPolyline(pts, n);
+    pts += n;
+  }
+  pPainter->restore();
+}
+
+void QSnpPolylineArray::translate(const QPoint& offset)
+{
+  QSnpFigure::translate(offset);
+  QPoint* pts = points.data();
+  for(int i = 0; i < points.size(); i++)
+    pts[i] += offset;
+  invalidateLod();
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpPointCloud
+
+QSnpPointCloud::QSnpPointCloud(QSnpView* pView) : QSnpFigure(pView)
+{
+  color = Qt::red;
+  lineWidth = 1;
+  bSplat = false;
+  rasterRatio = 0;
+  rasterColor = 0;
+}
+
+QSnpPointCloud::~QSnpPointCloud(void)
+{
+}
+
+void QSnpPointCloud::translate(const QPoint& offset)
+{
+  QSnpFigure::translate(offset);
+  QPoint* pts = points.data();
+  for(int i = 0; i < points.size(); i++)
+    pts[i] += offset;
+  invalidateRaster();
+}
+
+// размытие маски занятости квадратом size x size (раздельно по строкам и столбцам)
+static void dilateMask(QVector<quint32>& mask, int width, int height, int size)
+{
+  int r0 = (size-1)/2, r1 = size/2;
+  QVector<quint32> line(qMax(width, height) + 1);
+  quint32* pm = mask.data();
+  quint32* pl = line.data();
+
+  for(int y = 0; y < height; y++)
+  {
+    quint32* row = pm + y*width;
+    pl[0] = 0;
+    for(int x = 0; x < width; x++)
+      pl[x+1] = pl[x] + (row[x]!=0);
+    for(int x = 0; x < width; x++)
+      row[x] = pl[qMin(x+r1+1, width)] - pl[qMax(x-r0, 0)];
+  }
+
+  for(int x = 0; x < width; x++)
+  {
+    pl[0] = 0;
+    for(int y = 0; y < height; y++)
+      pl[y+1] = pl[y] + (pm[y*width+x]!=0);
+    for(int y = 0; y < height; y++)
+      pm[y*width+x] = pl[qMin(y+r1+1, height)] - pl[qMax(y-r0, 0)];
+  }
+}
+
+void QSnpPointCloud::buildRaster(float ratio, float scale)
+{
+  // растр экранного разрешения (с учетом масштаба группы), слишком большие облака накапливаются грубее
+  double k = ratio*scale;
+  double area = (rc.width()+1)*k * (rc.height()+1)*k;
+  if(area > QSNP_MAX_LAYER_PIXELS)
+    k *= sqrt(QSNP_MAX_LAYER_PIXELS/area);
+
+  int splat = bSplat ? qMax(1, int(lineWidth*k/(ratio*scale) + 0.5)) : 1;
+  int pad = splat/2 + 1;
+  int width = int(ceil((rc.width()+1)*k)) + 2*pad;
+  int height = int(ceil((rc.height()+1)*k)) + 2*pad;
+
+  // накопление: координаты в фиксированной точке 16.16, один проход по массиву
+  QVector<quint32> counts(width*height, 0);
+  quint32* pc = counts.data();
+  const QPoint* pts = points.constData();
+  const int n = points.size();
+  const qint64 kFix = qint64(k*65536 + 0.5);
+  const int x0 = rc.x(), y0 = rc.y();
+  for(int i = 0; i < n; i++)
+  {
+    unsigned x = unsigned(((pts[i].x()-x0)*kFix >> 16) + pad);
+    unsigned y = unsigned(((pts[i].y()-y0)*kFix >> 16) + pad);
+    if(x < (unsigned)width && y < (unsigned)height)
+      pc[y*width+x]++;
+  }
+
+  if(bSplat && splat>1)
+    dilateMask(counts, width, height, splat);
+
+  // палитра: непрозрачность по логарифму плотности (одиночная точка - 1/4)
+  quint32 cmax = 0;
+  for(int i = 0; i < counts.size(); i++)
+    cmax = qMax(cmax, pc[i]);
+  QRgb rgb = color.rgb();
+  QRgb palette[256];
+  for(int a = 0; a < 256; a++)
+    palette[a] = qPremultiply(qRgba(qRed(rgb), qGreen(rgb), qBlue(rgb), a));
+  double logMax = cmax>1 ? log(double(cmax)) : 1.0;
+
+  raster = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+  for(int y = 0; y < height; y++)
+  {
+    QRgb* line = (QRgb*)raster.scanLine(y);
+    const quint32* row = pc + y*width;
+    for(int x = 0; x < width; x++)
+    {
+      quint32 c = row[x];
+      if(!c)
+        line[x] = 0;
+      else if(bSplat || cmax<=1)
+        line[x] = palette[255];
+      else
+        line[x] = palette[64 + int(191*log(double(c))/logMax)];
+    }
+  }
+
+  rcRaster = QRectF((x0 - pad/k)*ratio, (y0 - pad/k)*ratio, width/k*ratio, height/k*ratio);
+  rasterRatio = ratio*scale;
+  rasterColor = rgb;
+}
+
+void QSnpPointCloud::Draw(QPainter* pPainter, float ratio)
+{
+  if(points.isEmpty())
+    return;
+  float scale = transformScale(pPainter);
+  if(rasterRatio!=ratio*scale || rasterColor!=color.rgb())
+    buildRaster(ratio, scale);
+  pPainter->drawImage(rcRaster, raster);
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpTrajectory
+
+QSnpTrajectory::QSnpTrajectory(QSnpView* pView) : QSnpFigure(pView), nMaxLength(0), bDirect(false), points(), nStart(0)
+{
+  color = Qt::red;
+  lineWidth = 1;
+}
+
+QSnpTrajectory::~QSnpTrajectory(void)
+{
+  if(bDirect && getGroup())
+    getGroup()->lsDirect.removeOne(this);
+}
+
+void QSnpTrajectory::appendPoint(const QPoint& pt)
+{
+  if(nMaxLength>0 && points.size()>=nMaxLength)
+  {
+    // буфер заполнен: новая точка занимает место самой старой
+    QPoint ptOldFirst = points[nStart];
+    QPoint ptLast = at(points.size()-1);
+    points[nStart] = pt;
+    nStart = (nStart+1) % points.size();
+    rc = rc.united(QRect(pt, pt)); // охватывающий прямоугольник не сужается
+
+    // траектория уходит из слоя группы (одно перестроение) и дальше рисуется
+    // поверх него: вытесненный отрезок стирается перерисовкой своего прямоугольника
+    if(!bDirect && getGroup())
+    {
+      bDirect = true;
+      getGroup()->lsDirect.push_back(this);
+      invalidate();
+    }
+    if(bVisible && getGroup())
+    {
+      updateSegment(ptOldFirst, at(0));
+      updateSegment(ptLast, pt);
+    }
+    return;
+  }
+
+  points.push_back(pt);
+  rc = points.size()==1 ? QRect(pt, pt) : rc.united(QRect(pt, pt));
+
+  // фигура еще не в группе: начальные точки, окно не перерисовывается
+  if(points.size() < 2 || !getGroup())
+    return;
+
+  QPoint ptLast = points[points.size()-2];
+  getGroup()->appendSegment(this, ptLast, pt);
+  if(bVisible)
+    updateSegment(ptLast, pt);
+}
+
+void QSnpTrajectory::updateSegment(const QPoint& from, const QPoint& to)
+{
+  QSnpView* pView = getView();
+  QWidget* pWidget = pView ? pView->getWidget() : 0;
+  if(!pWidget)
+    return;
+
+  QSnpImageWidget* pImageWidget = qobject_cast<QSnpImageWidget*>(pWidget);
+  if(!pImageWidget)
+  {
+    pWidget->update();
+    return;
+  }
+
+  // прямоугольник отрезка в координатах виджета с запасом на толщину пера
+  float ratio = pImageWidget->getRatio();
+  QRectF rcSegment(QPointF(from)*ratio, QPointF(to)*ratio);
+  QRect rcUpdate = getGroup()->screenTransform(ratio).mapRect(rcSegment.normalized()).toAlignedRect();
+  int margin = lineWidth/2 + 2;
+  pWidget->update(rcUpdate.adjusted(-margin, -margin, margin, margin));
+}
+
+void QSnpTrajectory::Draw(QPainter* pPainter, float ratio)
+{
+  if(points.size() < 2)
+    return;
+
+  pPainter->save();
+  pPainter->setRenderHint(QPainter::Antialiasing, true);
+  pPainter->setPen(cosmeticPen(color, lineWidth, Qt::RoundCap));
+  pPainter->setBrush(QBrush(Qt::NoBrush));
+  pPainter->scale(ratio, ratio);
+
+  // кольцевой буфер - не более двух непрерывных участков
+  const QPoint* pts = points.constData();
+  int n = points.size();
+  pPainter->drawPolyline(pts + nStart, n - nStart);
+  if(nStart > 0)
+  {
+    pPainter->drawLine(pts[n-1], pts[0]);
+    pPainter->drawPolyline(pts, nStart);
+  }
+  pPainter->restore();
+}
+
+void QSnpTrajectory::drawSegment(QPainter* pPainter, float ratio, const QPoint& from, const QPoint& to)
+{
+  pPainter->save();
+  pPainter->setRenderHint(QPainter::Antialiasing, true);
+  pPainter->setPen(cosmeticPen(color, lineWidth, Qt::RoundCap));
+  pPainter->scale(ratio, ratio);
+  pPainter->drawLine(from, to);
+  pPainter->restore();
+}
+
+void QSnpTrajectory::translate(const QPoint& offset)
+{
+  QSnpFigure::translate(offset);
+  QPoint* pts = points.data();
+  for(int i = 0; i < points.size(); i++)
+    pts[i] += offset;
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpMatOverlay
+
+QSnpMatOverlay::QSnpMatOverlay(QSnpView* pView) : QSnpFigure(pView), image(), palette(256, 0), hidden(256)
+{
+}
+
+QSnpMatOverlay::~QSnpMatOverlay(void)
+{
+}
+
+void QSnpMatOverlay::setPalette(const QVector<QRgb>& _palette)
+{
+  palette = _palette;
+  palette.resize(256);
+  applyPalette();
+}
+
+void QSnpMatOverlay::setClassVisible(int label, bool bShow)
+{
+  if(label<0 || label>=hidden.size() || hidden.testBit(label)!=bShow)
+    return;
+  hidden.setBit(label, !bShow);
+  applyPalette();
+}
+
+void QSnpMatOverlay::applyPalette()
+{
+  QVector<QRgb> colors(palette);
+  for(int i = 0; i < colors.size(); i++)
+  {
+    if(hidden.testBit(i))
+      colors[i] = 0;
+  }
+  image.setColorTable(colors);
+}
+
+void QSnpMatOverlay::Draw(QPainter* pPainter, float ratio)
+{
+  if(image.isNull())
+    return;
+  pPainter->drawImage(QRectF(rc.x()*ratio, rc.y()*ratio, image.width()*ratio, image.height()*ratio), image);
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpFigureGroup
+
+QSnpFigureGroup::QSnpFigureGroup(const QString& _id, double _scale) :
+  id(_id), lsFigures(), nRemoved(0), bVisible(true), scale(_scale), offset(), rotation(0), bOwnTransform(false), nRevision(1), layers()
+{
+}
+
+QSnpFigureGroup::~QSnpFigureGroup(void)
+{
+  clear();
+}
+
+void QSnpFigureGroup::addFigure(QSnpFigure* pFigure)
+{
+  pFigure->setGroup(this, lsFigures.size());
+  lsFigures.push_back(pFigure);
+  invalidate();
+}
+
+void QSnpFigureGroup::removeFigure(QSnpFigure* pFigure)
+{
+  int index = pFigure->getGroupIndex();
+  if(pFigure->getGroup()!=this || index<0 || index>=lsFigures.size() || lsFigures[index]!=pFigure)
+    return;
+
+  // позиция освобождается без сдвига списка, порядок прорисовки сохраняется
+  lsFigures[index] = 0;
+  nRemoved++;
+  delete pFigure;
+  invalidate();
+
+  if(nRemoved*2 > lsFigures.size())
+    compact();
+}
+
+void QSnpFigureGroup::appendSegment(QSnpTrajectory* pFigure, const QPoint& from, const QPoint& to)
+{
+  // длинный журнал дешевле заменить перестроением слоя
+  if(vecSegments.size() >= QSNP_MAX_APPENDED_SEGMENTS)
+  {
+    invalidate();
+    return;
+  }
+
+  QSnpAppendedSegment segment = { pFigure, from, to };
+  vecSegments.push_back(segment);
+}
+
+void QSnpFigureGroup::compact()
+{
+  QList<QSnpFigure*> lsAlive;
+  lsAlive.reserve(lsFigures.size() - nRemoved);
+  foreach(QSnpFigure* pf, lsFigures)
+  {
+    if(!pf)
+      continue;
+    pf->setGroup(this, lsAlive.size());
+    lsAlive.push_back(pf);
+  }
+  lsFigures.swap(lsAlive);
+  nRemoved = 0;
+}
+
+void QSnpFigureGroup::clear()
+{
+  QList<QSnpFigure*> lsRemoved;
+  lsRemoved.swap(lsFigures);
+  nRemoved = 0;
+  foreach(QSnpFigure* pf, lsRemoved)
+    delete pf; // блоки фигур возвращаются в пул окна
+  lsFigures.reserve(lsRemoved.size()); // следующий кадр обычно того же размера
+  layers.clear();
+  lsDirect.clear();
+  invalidate();
+}
+
+QTransform QSnpFigureGroup::transform() const
+{
+  QTransform t;
+  t.translate(offset.x(), offset.y());
+  t.rotate(rotation);
+  t.scale(scale, scale);
+  return t;
+}
+
+QTransform QSnpFigureGroup::screenTransform(float ratio) const
+{
+  // фигуры сами умножают координаты на ratio, поэтому масштаб и поворот
+  // применяются к уже умноженным координатам, а сдвиг умножается на ratio
+  QTransform t;
+  t.translate(offset.x()*ratio, offset.y()*ratio);
+  t.rotate(rotation);
+  t.scale(scale, scale);
+  return t;
+}
+
+void QSnpFigureGroup::copyTransform(const QSnpFigureGroup* pOther)
+{
+  scale = pOther->scale;
+  offset = pOther->offset;
+  rotation = pOther->rotation;
+}
+
+void QSnpFigureGroup::Draw(
+    QPainter*       pPainter,           // [in] painter
+    float           ratio,              // [in] масштаб виджета
+    bool            bLayer              // [in] отрисовка слоя: без траекторий из lsDirect
+    )
+{
+  if(!bVisible)
+    return;
+
+  bool bTransform = !isIdentity();
+  if(bTransform)
+  {
+    pPainter->save();
+    pPainter->setWorldTransform(screenTransform(ratio), true);
+  }
+
+  foreach(QSnpFigure* pf, lsFigures)
+  {
+    if(!pf || !pf->bVisible)
+      continue;
+    if(bLayer && pf->getType()==SFT_TRAJECTORY && static_cast<QSnpTrajectory*>(pf)->bDirect)
+      continue;
+    pf->Draw(pPainter, ratio);
+  }
+
+  if(bTransform)
+    pPainter->restore();
+}
+
+void QSnpFigureGroup::DrawCached(
+    QPainter*       pPainter,           // [in] painter виджета
+    float           ratio,              // [in] масштаб виджета
+    const QWidget*  pTarget,            // [in] виджет (у каждого виджета свой слой)
+    const QRect&    rcPaint             // [in] перерисовываемая область виджета
+    )
+{
+  // слои разрушенных виджетов больше не нужны
+  for(QHash<const QWidget*, QSnpGroupLayer>::iterator it = layers.begin(); it != layers.end(); )
+  {
+    if(it->pTarget.isNull() && it.key() != pTarget)
+      it = layers.erase(it);
+    else
+      ++it;
+  }
+
+  if(!bVisible || lsFigures.size()==nRemoved)
+    return;
+
+  // видимая часть виджета (в области прокрутки - часть, попадающая в окно)
+  QRect rcWidget = pTarget->rect();
+  QRect rcVisible = pTarget->visibleRegion().boundingRect().united(rcPaint) & rcWidget;
+
+  // слишком большая видимая область не кэшируется
+  if((qint64)rcVisible.width()*rcVisible.height() > QSNP_MAX_LAYER_PIXELS)
+  {
+    layers.remove(pTarget);
+    Draw(pPainter, ratio);
+    return;
+  }
+
+  // перестроение слоя при изменении группы или масштаба и при выходе видимой области за слой
+  QSnpGroupLayer& layer = layers[pTarget];
+  bool bValid = layer.pTarget == pTarget && layer.ratio==ratio && layer.nRevision==nRevision;
+  if(!bValid || !layer.rcLayer.contains(rcVisible))
+  {
+    int dx = int(rcVisible.width()*QSNP_LAYER_MARGIN), dy = int(rcVisible.height()*QSNP_LAYER_MARGIN);
+    QRect rcLayer = rcVisible.adjusted(-dx, -dy, dx, dy) & rcWidget;
+    if((qint64)rcLayer.width()*rcLayer.height() > QSNP_MAX_LAYER_PIXELS)
+      rcLayer = rcVisible;
+
+    layer.pTarget = const_cast<QWidget*>(pTarget);
+    if(layer.image.size()!=rcLayer.size())
+      layer.image = QImage(rcLayer.size(), QImage::Format_ARGB32_Premultiplied);
+    layer.image.fill(0);
+    layer.rcLayer = rcLayer;
+
+    QPainter layerPainter(&layer.image);
+    layerPainter.translate(-rcLayer.topLeft());
+    Draw(&layerPainter, ratio, true);
+    layerPainter.end();
+
+    layer.ratio = ratio;
+    layer.nRevision = nRevision;
+    layer.nSegments = vecSegments.size();
+  }
+  else if(layer.nSegments < vecSegments.size())
+  {
+    // дорисовка добавленных отрезков траекторий поверх готового слоя
+    QPainter layerPainter(&layer.image);
+    layerPainter.translate(-layer.rcLayer.topLeft());
+    if(!isIdentity())
+      layerPainter.setWorldTransform(screenTransform(ratio), true);
+    for(int i = layer.nSegments; i < vecSegments.size(); i++)
+    {
+      const QSnpAppendedSegment& segment = vecSegments[i];
+      if(segment.pFigure->bVisible)
+        segment.pFigure->drawSegment(&layerPainter, ratio, segment.from, segment.to);
+    }
+    layerPainter.end();
+    layer.nSegments = vecSegments.size();
+  }
+
+  QRect rcCopy = rcPaint & layer.rcLayer;
+  pPainter->drawImage(rcCopy, layer.image, rcCopy.translated(-layer.rcLayer.topLeft()));
+
+  // траектории с вытеснением точек (не длиннее nMaxLength) рисуются поверх слоя
+  if(!lsDirect.isEmpty())
+  {
+    pPainter->save();
+    if(!isIdentity())
+      pPainter->setWorldTransform(screenTransform(ratio), true);
+    foreach(QSnpTrajectory* pf, lsDirect)
+    {
+      if(pf->bVisible)
+        pf->Draw(pPainter, ratio);
+    }
+    pPainter->restore();
+  }
+}
+
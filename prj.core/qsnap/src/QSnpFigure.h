@@ -9,7 +9,20 @@
 
 #include <QRect>
 #include <QPainter>
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QImage>
+#include <QHash>
+#include <QStaticText>
+#include <QMap>
+#include <QMutex>
+#include <QTransform>
+#include <QBitArray>
+#include <QPointer>
+#include <QQueue>
 #include "QCastEx.h"
+#include "QSnpPool.h"
 
 #define SFT_NONE      0
 #define SFT_POINT     1
@@ -17,7 +30,16 @@
 #define SFT_RECT      3
 #define SFT_ELLIPSE   4
 #define SFT_TEXT      5
+#define SFT_POINTS    6
+#define SFT_LINES     7
+#define SFT_RECTS     8
+#define SFT_POLYLINES 9
+#define SFT_POINTCLOUD 10
+#define SFT_TRAJECTORY 11
+#define SFT_MAT_OVERLAY 12
 
+class QWidget;
+class QSnpFigureGroup;
 
 class QSnpFigure
 {
@@ -25,6 +47,10 @@ public:
   QSnpFigure(class QSnpView* pView=0);
   virtual ~QSnpFigure(void);
 
+  // фигуры размещаются в общих для процесса пулах по классам размеров
+  static void* operator new(size_t sz) { return QSnpObjectPool::allocate(sz); }
+  static void  operator delete(void* p) { QSnpObjectPool::release(p); }
+
   virtual int getType() { return SFT_NONE; }
   virtual void Draw(QPainter* pPainter, float ratio)=0;
 
@@ -35,12 +61,79 @@ public:
 
   void setVisible(bool bVisible);
 
+  // установка цвета
+  void setColor(const QColor& color);
+
+  // сдвиг фигуры на (dx,dy) в координатах фигуры (до преобразования группы)
+  virtual void move(int dx, int dy);
+
+  // отметка об изменении фигуры (перестроение слоя группы)
+  void invalidate();
+
+  // отметка об изменении фигуры и перерисовка окна
+  void update();
+
+  // хэндл фигуры (см. QSnpFigureTable)
+  QHandle getHandle() { return hFigure; }
+
   QSnpView* getView() { return pView; }
   void setView(QSnpView* p) { pView = p; }
 
+  QSnpFigureGroup* getGroup() { return pGroup; }
+  void setGroup(QSnpFigureGroup* p, int index = -1) { pGroup = p; nGroupIndex = index; }
+  int getGroupIndex() { return nGroupIndex; }
+
+protected:
+  // сдвиг хранимых координат фигуры
+  virtual void translate(const QPoint& offset) { rc.translate(offset); }
+
 private:
   QSnpView* pView;
+  QSnpFigureGroup* pGroup;
+  int       nGroupIndex;                // позиция в списке фигур группы
+  QHandle   hFigure;
+
+};
 
+///////////////////////////////////////////////////////////
+////  Таблица хэндлов фигур (slot map).
+////  Хэндл = (поколение << QSNP_FIGURE_INDEX_BITS) | (номер слота + 1). При удалении
+////  фигуры поколение слота увеличивается, поэтому старые хэндлы перестают
+////  находиться, а не указывают на освобожденную память. Свободные слоты
+////  выдаются в порядке освобождения (FIFO), поэтому слот используется снова
+////  только после всех остальных свободных, а 40-битное поколение не
+////  повторяется при любой частоте очистки и перерисовки.
+////  Таблица защищена мьютексом: оверлеи строятся вне потока окна
+
+#define QSNP_FIGURE_INDEX_BITS  24
+#define QSNP_FIGURE_INDEX_MASK  ((1ull << QSNP_FIGURE_INDEX_BITS) - 1)
+#define QSNP_FIGURE_GEN_MASK    ((1ull << (64 - QSNP_FIGURE_INDEX_BITS)) - 1)
+
+class QSnpFigureTable
+{
+public:
+  /// регистрация фигуры, возвращает новый хэндл (QHANDLE_NULL, если слоты исчерпаны)
+  static QHandle attach(QSnpFigure* pFigure);
+
+  /// освобождение слота фигуры
+  static void detach(QHandle hFigure);
+
+  /// фигура по хэндлу (0, если фигура удалена или хэндл неверный)
+  static QSnpFigure* find(QHandle hFigure);
+
+private:
+  // поиск без блокировки
+  static QSnpFigure* lookup(QHandle hFigure);
+
+  struct Slot
+  {
+    QSnpFigure* pFigure;
+    quint64     nGeneration;
+  };
+
+  static QVector<Slot>  vecSlots;       // слоты фигур
+  static QQueue<int>    queueFree;      // номера свободных слотов в порядке освобождения
+  static QMutex         mutex;
 };
 
 
@@ -56,6 +149,9 @@ public:
   virtual int getType() { return SFT_LINE; }
   virtual void Draw(QPainter* pPainter, float ratio = 1.0);
 
+protected:
+  virtual void translate(const QPoint& offset);
+
 public:
   QPoint ptFrom;
   QPoint ptTo;
@@ -82,6 +178,9 @@ public:
   virtual void Draw(QPainter* pPainter, float ratio = 1.0);
 };
 
+// минимальная высота текста на экране (в пикселях), более мелкие надписи не рисуются
+#define QSNP_MIN_TEXT_PIXELS  4
+
 class QSnpText : public QSnpFigure
 {
 public:
@@ -91,6 +190,12 @@ public:
   virtual int getType() { return SFT_TEXT; }
   virtual void Draw(QPainter* pPainter, float ratio = 1.0);
 
+  // установка текста (сбрасывает подготовленную раскладку)
+  void setText(const QString& text);
+
+  // сброс подготовленной раскладки текста (после изменения шрифта, выравнивания)
+  void invalidateLayout() { layoutRatio = 0; }
+
 public:
   QString textValue;
 
@@ -100,6 +205,10 @@ public:
   bool    bItalic;
   int     alignment;
 
+protected:
+  QStaticText staticText;               // раскладка текста, подготовленная для layoutRatio
+  float   layoutRatio;                  // масштаб подготовленной раскладки, 0 - не подготовлена
+
 };
 
 class QSnpPoint : public QSnpFigure
@@ -111,12 +220,341 @@ public:
   virtual int getType() { return SFT_POINT; }
   virtual void Draw(QPainter* pPainter, float ratio = 1.0);
 
+
   virtual int x() { return mX; }
   virtual int y() { return mY; }
 
   protected:
+    virtual void translate(const QPoint& offset);
+
     int mX;
     int mY;
 
 
-};
\ No newline at end of file
+};
+
+
+///////////////////////////////////////////////////////////
+////  Классы, соответствующие массивам фигур.
+////  Весь массив хранится одной фигурой в непрерывном буфере
+////  и отрисовывается одним вызовом QPainter
+
+class QSnpPointArray : public QSnpFigure
+{
+public:
+  QSnpPointArray(QSnpView* pView=0);
+  virtual ~QSnpPointArray(void);
+
+  virtual int getType() { return SFT_POINTS; }
+  virtual void Draw(QPainter* pPainter, float ratio = 1.0);
+
+protected:
+  virtual void translate(const QPoint& offset);
+
+public:
+  QVector<QPoint> points;
+
+};
+
+class QSnpLineArray : public QSnpFigure
+{
+public:
+  QSnpLineArray(QSnpView* pView=0);
+  virtual ~QSnpLineArray(void);
+
+  virtual int getType() { return SFT_LINES; }
+  virtual void Draw(QPainter* pPainter, float ratio = 1.0);
+
+protected:
+  virtual void translate(const QPoint& offset);
+
+public:
+  QVector<QPoint> points;   // пары точек (начало, конец) для каждой линии
+
+};
+
+class QSnpRectArray : public QSnpFigure
+{
+public:
+  QSnpRectArray(QSnpView* pView=0);
+  virtual ~QSnpRectArray(void);
+
+  virtual int getType() { return SFT_RECTS; }
+  virtual void Draw(QPainter* pPainter, float ratio = 1.0);
+
+protected:
+  virtual void translate(const QPoint& offset);
+
+public:
+  QVector<QRect> rects;
+
+};
+
+// упрощение ломаных при уменьшении: не упрощаются наборы меньше QSNP_LOD_MIN_POINTS точек,
+// уровень детализации L соответствует масштабу ~1/2^L (не более QSNP_LOD_MAX_LEVEL)
+#define QSNP_LOD_MIN_POINTS   256
+#define QSNP_LOD_MAX_LEVEL    12
+
+// упрощенная (Douglas-Peucker) копия вершинного буфера для одного уровня детализации
+struct QSnpPolylineLod
+{
+  QVector<QPoint> points;
+  QVector<int>    sizes;
+};
+
+// многоугольники, ломаные (в том числе контуры и дуги) в одном вершинном буфере
+class QSnpPolylineArray : public QSnpFigure
+{
+public:
+  QSnpPolylineArray(QSnpView* pView=0);
+  virtual ~QSnpPolylineArray(void);
+
+  virtual int getType() { return SFT_POLYLINES; }
+  virtual void Draw(QPainter* pPainter, float ratio = 1.0);
+
+  // сброс упрощенных копий (после изменения points/sizes)
+  void invalidateLod() { lods.clear(); }
+
+protected:
+  virtual void translate(const QPoint& offset);
+
+public:
+  QVector<QPoint> points;   // точки всех ломаных подряд
+  QVector<int>    sizes;    // количество точек в каждой ломаной
+  bool            bClosed;  // замкнутые многоугольники (PT_POLYGON) или ломаные (PT_LINES)
+
+protected:
+  // упрощенная копия для уровня детализации (строится при первом обращении)
+  const QSnpPolylineLod& lod(int level);
+
+  QMap<int, QSnpPolylineLod> lods;      // упрощенные копии по уровням детализации
+
+};
+
+
+///////////////////////////////////////////////////////////
+////  Облако точек: точки накапливаются в растр экранного разрешения
+////  (счетчики по пикселям), растр перестраивается только при изменении
+////  масштаба или точек
+
+class QSnpPointCloud : public QSnpFigure
+{
+public:
+  QSnpPointCloud(QSnpView* pView=0);
+  virtual ~QSnpPointCloud(void);
+
+  virtual int getType() { return SFT_POINTCLOUD; }
+  virtual void Draw(QPainter* pPainter, float ratio = 1.0);
+
+  // сброс растра (после изменения points, цвета или режима)
+  void invalidateRaster() { rasterRatio = 0; }
+
+protected:
+  virtual void translate(const QPoint& offset);
+
+  // накопление точек в растр для масштаба ratio и масштаба группы scale
+  void buildRaster(float ratio, float scale);
+
+public:
+  QVector<QPoint> points;
+  bool            bSplat;   // непрозрачные пятна размером lineWidth (PC_SPLAT) или плотность (PC_DENSITY)
+
+protected:
+  QImage  raster;                       // растр облака в координатах виджета (от rcRaster.topLeft)
+  QRectF  rcRaster;                     // прямоугольник растра в координатах виджета
+  float   rasterRatio;                  // масштаб (вместе с масштабом группы), для которого построен растр, 0 - не построен
+  QRgb    rasterColor;                  // цвет, с которым построен растр
+
+};
+
+
+///////////////////////////////////////////////////////////
+////  Траектория: ломаная, точки которой добавляются в конец за O(1).
+////  Точки хранятся в кольцевом буфере: он растет до nMaxLength точек,
+////  затем новая точка вытесняет самую старую. Новый отрезок дорисовывается
+////  поверх кэшированного слоя группы, перерисовывается только его прямоугольник
+
+class QSnpTrajectory : public QSnpFigure
+{
+public:
+  QSnpTrajectory(QSnpView* pView=0);
+  virtual ~QSnpTrajectory(void);
+
+  virtual int getType() { return SFT_TRAJECTORY; }
+  virtual void Draw(QPainter* pPainter, float ratio = 1.0);
+
+  // добавление точки в конец траектории
+  void appendPoint(const QPoint& pt);
+
+  // отрисовка одного отрезка траектории (дорисовка слоя группы)
+  void drawSegment(QPainter* pPainter, float ratio, const QPoint& from, const QPoint& to);
+
+  // количество точек
+  int size() const { return points.size(); }
+
+  // точка по номеру от начала траектории
+  const QPoint& at(int i) const { return points[(nStart+i) % points.size()]; }
+
+protected:
+  virtual void translate(const QPoint& offset);
+
+  // перерисовка прямоугольника отрезка в окне
+  void updateSegment(const QPoint& from, const QPoint& to);
+
+public:
+  int             nMaxLength;   // максимальное количество точек (0 - без ограничения)
+  bool            bDirect;      // рисуется поверх слоя группы (буфер заполнен, точки вытесняются)
+
+protected:
+  QVector<QPoint> points;       // кольцевой буфер точек
+  int             nStart;       // позиция первой точки в буфере (0, пока буфер не заполнен)
+
+};
+
+
+///////////////////////////////////////////////////////////
+////  Полупрозрачный оверлей изображения (маска меток, тепловая карта).
+////  Значения хранятся 8-битными индексами, цвет и прозрачность задает
+////  палитра (таблица цветов QImage), поэтому показ/скрытие класса и
+////  смена прозрачности меняют только палитру, а не пиксели
+
+class QSnpMatOverlay : public QSnpFigure
+{
+public:
+  QSnpMatOverlay(QSnpView* pView=0);
+  virtual ~QSnpMatOverlay(void);
+
+  virtual int getType() { return SFT_MAT_OVERLAY; }
+  virtual void Draw(QPainter* pPainter, float ratio = 1.0);
+
+  // установка палитры (256 цветов с прозрачностью)
+  void setPalette(const QVector<QRgb>& palette);
+
+  // показ/скрытие значения (класса) без пересчета изображения
+  void setClassVisible(int label, bool bShow);
+
+public:
+  QImage  image;                        // индексы палитры (Format_Indexed8), rc - положение на изображении
+
+protected:
+  // перенос палитры с учетом скрытых классов в таблицу цветов image
+  void applyPalette();
+
+  QVector<QRgb> palette;                // палитра с прозрачностью
+  QBitArray     hidden;                 // скрытые значения
+
+};
+
+
+///////////////////////////////////////////////////////////
+////  Растровый слой группы фигур, построенный для одного виджета.
+////  Слой покрывает видимую часть виджета с запасом QSNP_LAYER_MARGIN
+////  размера видимой части с каждой стороны: прокрутка в пределах запаса
+////  только копирует слой, выход за него перестраивает слой на новом месте
+
+// максимальный размер слоя (в пикселях), большие видимые области рисуются без кэша
+#define QSNP_MAX_LAYER_PIXELS  (4096*2048)
+
+// запас слоя вокруг видимой области (доля ее размера)
+#define QSNP_LAYER_MARGIN      0.5
+
+struct QSnpGroupLayer
+{
+  QSnpGroupLayer() : image(), rcLayer(), ratio(0), nRevision(0), nSegments(0) {}
+
+  QPointer<QWidget> pTarget;            // виджет слоя (слои разрушенных виджетов удаляются)
+  QImage    image;                      // растр слоя
+  QRect     rcLayer;                    // положение растра в координатах виджета
+  float     ratio;                      // масштаб, при котором построен слой
+  unsigned  nRevision;                  // версия группы, при которой построен слой
+  int       nSegments;                  // количество дорисованных отрезков траекторий
+};
+
+// отрезок траектории, дорисовываемый поверх слоя группы
+struct QSnpAppendedSegment
+{
+  QSnpTrajectory* pFigure;
+  QPoint    from;
+  QPoint    to;
+};
+
+// предел журнала дорисовки, дальше слой группы перестраивается целиком
+#define QSNP_MAX_APPENDED_SEGMENTS  4096
+
+///////////////////////////////////////////////////////////
+////  Группа фигур (idGroup в функциях Draw*)
+////  Фигуры группы хранятся подряд в своем списке, поэтому показ/скрытие
+////  группы - изменение одного флага, а очистка не затрагивает другие группы.
+////  Фигуры хранятся в собственных координатах, преобразование группы
+////  (масштаб, поворот, сдвиг) применяется при отрисовке
+
+class QSnpFigureGroup
+{
+public:
+  QSnpFigureGroup(const QString& id = QString(), double scale = 1.0);
+  ~QSnpFigureGroup(void);
+
+  /// добавление фигуры в конец группы
+  void addFigure(QSnpFigure* pFigure);
+
+  /// удаление (и разрушение) одной фигуры группы
+  void removeFigure(QSnpFigure* pFigure);
+
+  /// удаление всех фигур группы
+  void clear();
+
+  /// отметка об изменении группы, кэшированные слои будут перестроены
+  void invalidate() { nRevision++; vecSegments.clear(); }
+
+  /// дорисовка отрезка траектории поверх построенных слоев (без перестроения)
+  void appendSegment(QSnpTrajectory* pFigure, const QPoint& from, const QPoint& to);
+
+  /// преобразование координат фигур в координаты изображения
+  QTransform transform() const;
+
+  /// преобразование координат фигур, предварительно умноженных на ratio, в координаты виджета
+  QTransform screenTransform(float ratio) const;
+
+  /// преобразование группы тождественно
+  bool isIdentity() const { return scale==1.0 && rotation==0 && offset.isNull(); }
+
+  /// копирование преобразования другой группы
+  void copyTransform(const QSnpFigureGroup* pOther);
+
+  /// отрисовка видимых фигур группы
+  void Draw(
+    QPainter*       pPainter,           // [in] painter
+    float           ratio,              // [in] масштаб виджета
+    bool            bLayer = false      // [in] отрисовка слоя: без траекторий из lsDirect
+    );
+
+  /// отрисовка группы через растровый слой, построенный для виджета pTarget
+  void DrawCached(
+    QPainter*       pPainter,           // [in] painter виджета
+    float           ratio,              // [in] масштаб виджета
+    const QWidget*  pTarget,            // [in] виджет (у каждого виджета свой слой)
+    const QRect&    rcPaint             // [in] перерисовываемая область виджета
+    );
+
+public:
+  QString id;                           // идентификатор группы
+  QList<QSnpFigure*> lsFigures;         // фигуры группы в порядке добавления (0 - удаленная фигура)
+  int     nRemoved;                     // количество удаленных позиций в lsFigures
+  bool    bVisible;                     // показ/скрытие всей группы
+  double  scale;                        // коэффициент масштабирования координат группы
+  QPointF offset;                       // сдвиг (в координатах изображения)
+  double  rotation;                     // поворот вокруг начала координат, градусы (по часовой стрелке на экране)
+  bool    bOwnTransform;                // преобразование задано для группы (иначе - как у группы по умолчанию)
+  unsigned nRevision;                   // версия содержимого группы
+  QVector<QSnpAppendedSegment> vecSegments; // отрезки траекторий, добавленные после последнего invalidate
+  QList<QSnpTrajectory*> lsDirect;      // траектории с вытеснением точек, рисуются поверх слоя
+
+  QHash<const QWidget*, QSnpGroupLayer> layers; // кэшированные слои по виджетам
+
+private:
+  // удаление пустых позиций из lsFigures
+  void compact();
+
+  QSnpFigureGroup(const QSnpFigureGroup&);
+  QSnpFigureGroup& operator=(const QSnpFigureGroup&);
+};
@@ -11,6 +11,9 @@
 #include <QSettings>
 #include <QScrollBar>
 
+#include <algorithm>
+#include <cmath>
+
 using namespace QSnp;
 using namespace std;
 
@@ -20,7 +23,7 @@ QSnpImageView::QSnpImageView(void)
   eViewType = VT_IMAGE_VIEW;
   nStartHorSliderPos = 0;
   nStartVerSliderPos = 0;
-  scaleFactors[""]=1.0;
+  getGroup(0, true); // группа по умолчанию
 }
 
 QSnpImageView::~QSnpImageView(void)
@@ -36,7 +39,7 @@ QHandle QSnpImageView::Create(QSnpInstance* _pInstance)
   QSnpView::Create(_pInstance);
 
   QSnpImageWidget* pWidget = new QSnpImageWidget(this);
-  pWidget->setFigures(&lsFigures);
+  pWidget->setGroups(&lsGroups);
 
   scrollArea.setWidget(pWidget);
   pWidget->pScrollArea = &scrollArea;
@@ -60,10 +63,10 @@ QHandle QSnpImageView::Create(QSnpInstance* _pInstance)
 
 bool QSnpImageView::Destroy(void)
 {
-  foreach(QSnpFigure* pf, lsFigures)
-    delete pf;
-  
-  lsFigures.clear();
+  destroyOverlays();
+  qDeleteAll(lsGroups);
+  lsGroups.clear();
+  hashGroups.clear();
 
   if(!pWidget)
     return true;
@@ -205,7 +208,42 @@ QError QSnpImageView::setScaleFactor(
     const char*     idGroup             // [in] идентификатор группы фигур (для совместной работы)
     )
 {
-  scaleFactors[idGroup ? idGroup : ""] = scale;
+  QSnpFigureGroup* pGroup = getGroup(idGroup, true);
+  pGroup->bOwnTransform = true;
+  if(pGroup->scale == scale)
+    return QERR_NO_ERROR;
+
+  // координаты фигур не пересчитываются: масштаб применяется при отрисовке
+  pGroup->scale = scale;
+  pGroup->invalidate();
+  if(pGroup == getGroup(0))
+    applyDefaultTransform();
+  QWidget* pWidget = getWidget();
+  if(pWidget)
+    pWidget->update();
+  return QERR_NO_ERROR;
+}
+
+QError QSnpImageView::setGroupTransform(
+    double          scale,              // [in] коэффициент масштабирования
+    double          dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+    double          dy,                 // [in] сдвиг по вертикали (в координатах изображения)
+    double          rotation,           // [in] поворот вокруг начала координат, градусы
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  QSnpFigureGroup* pGroup = getGroup(idGroup, true);
+  pGroup->scale = scale;
+  pGroup->offset = QPointF(dx, dy);
+  pGroup->rotation = rotation;
+  pGroup->bOwnTransform = true;
+  pGroup->invalidate();
+  if(pGroup == getGroup(0))
+    applyDefaultTransform();
+
+  QWidget* pWidget = getWidget();
+  if(pWidget)
+    pWidget->update();
   return QERR_NO_ERROR;
 }
 
@@ -213,10 +251,169 @@ double QSnpImageView::getScaleFactor(
     const char*     idGroup             // [in] идентификатор группы фигур (для совместной работы)
     )
 {
-  QMap<QString,double>::iterator it = scaleFactors.find(idGroup);
-  if(it==scaleFactors.end())
-    return scaleFactors[""];
-  return *it;
+  QSnpFigureGroup* pGroup = getGroup(idGroup);
+  if(!pGroup)
+    pGroup = getGroup(0);
+  return pGroup ? pGroup->scale : 1.0;
+}
+
+void QSnpImageView::applyDefaultTransform()
+{
+  QSnpFigureGroup* pDefault = getGroup(0);
+  if(!pDefault)
+    return;
+
+  foreach(QSnpFigureGroup* pGroup, lsGroups)
+  {
+    if(pGroup == pDefault || pGroup->bOwnTransform)
+      continue;
+    pGroup->copyTransform(pDefault);
+    pGroup->invalidate();
+  }
+}
+
+QSnpFigureGroup* QSnpImageView::getGroup(
+    const char*     idGroup,            // [in] идентификатор группы фигур
+    bool            bCreate             // [in] создать группу, если ее нет
+    )
+{
+  QString id = idGroup ? QString(idGroup) : QString("");
+  QSnpFigureGroup* pGroup = hashGroups.value(id, 0);
+  if(pGroup || !bCreate)
+    return pGroup;
+
+  // новая группа следует преобразованию группы по умолчанию, пока не получит свое
+  QSnpFigureGroup* pDefault = hashGroups.value(QString(""), 0);
+  pGroup = new QSnpFigureGroup(id);
+  if(pDefault)
+    pGroup->copyTransform(pDefault);
+  lsGroups.push_back(pGroup);
+  hashGroups.insert(id, pGroup);
+  return pGroup;
+}
+
+QHandle QSnpImageView::addFigure(
+    QSnpFigure*     pFigure,            // [in] фигура
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  if(!pFigure)
+    return QHANDLE_NULL;
+
+  // таблица хэндлов исчерпана: фигура без хэндла не добавляется
+  if(pFigure->getHandle() == QHANDLE_NULL)
+  {
+    delete pFigure;
+    return QHANDLE_NULL;
+  }
+
+  // во время построения оверлея фигуры группы идут в задний буфер
+  QMutexLocker lock(&mutOverlays);
+  QSnpFigureGroup* pGroup = hashOverlays.value(idGroup ? QString(idGroup) : QString(""), 0);
+  if(pGroup)
+  {
+    pGroup->addFigure(pFigure);
+    return pFigure->getHandle();
+  }
+  lock.unlock();
+
+  pGroup = getGroup(idGroup, true);
+  pGroup->addFigure(pFigure);
+  return pFigure->getHandle();
+}
+
+QError QSnpImageView::showGroup(
+    const char*     idGroup,            // [in] идентификатор группы фигур
+    bool            bShow               // [in] показать/скрыть
+    )
+{
+  QSnpFigureGroup* pGroup = getGroup(idGroup);
+  if(!pGroup)
+    return QERR_ERROR;
+  if(pGroup->bVisible == bShow)
+    return QERR_NO_ERROR;
+
+  pGroup->bVisible = bShow;
+  QWidget* pWidget = getWidget();
+  if(pWidget)
+    pWidget->update();
+  return QERR_NO_ERROR;
+}
+
+QError QSnpImageView::clearGroup(
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  QSnpFigureGroup* pGroup = getGroup(idGroup);
+  if(!pGroup)
+    return QERR_ERROR;
+
+  pGroup->clear();
+  QWidget* pWidget = getWidget();
+  if(pWidget)
+    pWidget->update();
+  return QERR_NO_ERROR;
+}
+
+QError QSnpImageView::beginOverlay(
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  QString id = idGroup ? QString(idGroup) : QString("");
+
+  // задний буфер - прошлый кадр этого оверлея (очищается здесь, вне потока окна);
+  // видимая группа создается и получает преобразование при подмене в потоке окна
+  QMutexLocker lock(&mutOverlays);
+  QSnpFigureGroup* pBack = hashOverlays.value(id, 0);
+  if(!pBack)
+    pBack = hashSpares.take(id);
+  if(!pBack)
+    pBack = new QSnpFigureGroup(id);
+
+  pBack->clear();
+  hashOverlays.insert(id, pBack);
+  return QERR_NO_ERROR;
+}
+
+QError QSnpImageView::commitOverlays()
+{
+  QMutexLocker lock(&mutOverlays);
+  if(hashOverlays.isEmpty())
+    return QERR_NO_ERROR;
+
+  QHash<QString,QSnpFigureGroup*>::iterator it;
+  for(it = hashOverlays.begin(); it != hashOverlays.end(); ++it)
+  {
+    QSnpFigureGroup* pBack = it.value();
+    QSnpFigureGroup* pFront = getGroup(it.key().toUtf8().constData(), true);
+
+    // подмена указателей, фигуры не копируются и не удаляются
+    pBack->bVisible = pFront->bVisible;
+    pBack->bOwnTransform = pFront->bOwnTransform;
+    pBack->copyTransform(pFront);
+    pBack->invalidate();
+    lsGroups[lsGroups.indexOf(pFront)] = pBack;
+    hashGroups[it.key()] = pBack;
+
+    QSnpFigureGroup* pSpare = hashSpares.value(it.key(), 0);
+    delete pSpare;
+    hashSpares.insert(it.key(), pFront);
+  }
+  hashOverlays.clear();
+
+  QWidget* pWidget = getWidget();
+  if(pWidget)
+    pWidget->update();
+  return QERR_NO_ERROR;
+}
+
+void QSnpImageView::destroyOverlays()
+{
+  QMutexLocker lock(&mutOverlays);
+  qDeleteAll(hashOverlays);
+  hashOverlays.clear();
+  qDeleteAll(hashSpares);
+  hashSpares.clear();
 }
 
 QHandle QSnpImageView::addPoint(
@@ -229,9 +426,8 @@ QHandle QSnpImageView::addPoint(
 {
   QSnpFigure* pSnpFigure = new QSnpPoint(this, x, y, ptWidth);
   pSnpFigure->color = QColor_cast(color);
-  lsFigures.push_back(pSnpFigure);
 
-  return (QHandle)pSnpFigure;
+  return addFigure(pSnpFigure, idGroup);
 }
 
 QHandle QSnpImageView::addLine(
@@ -247,15 +443,13 @@ QHandle QSnpImageView::addLine(
 {
   QSnpLine* pSnpFigure = new QSnpLine(this);
 
-  double scale = getScaleFactor(idGroup); // масштаб для данной группы
-  pSnpFigure->ptFrom = QPoint(xFrom*scale, yFrom*scale);
-  pSnpFigure->ptTo = QPoint(xTo*scale, yTo*scale);
+  pSnpFigure->ptFrom = QPoint(xFrom, yFrom);
+  pSnpFigure->ptTo = QPoint(xTo, yTo);
   pSnpFigure->lineWidth = lineWidth;
   pSnpFigure->color = QColor_cast(color);
   pSnpFigure->rc = QRect(xFrom,yFrom,1,1).united(QRect(xTo,yTo,1,1)); // охватывающий прямоугольник
-  lsFigures.push_back(pSnpFigure);
 
-  return (QHandle)pSnpFigure;
+  return addFigure(pSnpFigure, idGroup);
 }
 
 QHandle QSnpImageView::addRect(
@@ -268,14 +462,12 @@ QHandle QSnpImageView::addRect(
 {
   QSnpFigure* pSnpFigure = new QSnpRect(this);
 
-  double scale = getScaleFactor(idGroup); // масштаб для данной группы
-  QRect qRect(pRect->x*scale, pRect->y*scale, pRect->width*scale, pRect->height*scale);
+  QRect qRect(pRect->x, pRect->y, pRect->width, pRect->height);
   pSnpFigure->rc = qRect;
   pSnpFigure->lineWidth = lineWidth;
   pSnpFigure->color = QColor_cast(color);
-  lsFigures.push_back(pSnpFigure);
-  
-  return (QHandle)pSnpFigure;
+
+  return addFigure(pSnpFigure, idGroup);
 }
 
 QHandle QSnpImageView::addEllipse(
@@ -288,15 +480,13 @@ QHandle QSnpImageView::addEllipse(
 {
   QSnpFigure* pSnpFigure = new QSnpEllipse(this);
 
-  double scale = getScaleFactor(idGroup); // масштаб для данной группы
-  QRect qRect(pRect->x*scale, pRect->y*scale, pRect->width*scale, pRect->height*scale);
+  QRect qRect(pRect->x, pRect->y, pRect->width, pRect->height);
 
   pSnpFigure->rc = qRect;
   pSnpFigure->lineWidth = lineWidth;
   pSnpFigure->color = QColor_cast(color);
-  lsFigures.push_back(pSnpFigure);
-  
-  return (QHandle)pSnpFigure;
+
+  return addFigure(pSnpFigure, idGroup);
 }
 
 QHandle QSnpImageView::addText(
@@ -310,24 +500,394 @@ QHandle QSnpImageView::addText(
 {
   QSnpText* pSnpFigure = new QSnpText(this);
 
-  double scale = getScaleFactor(idGroup); // масштаб для данной группы
-  QRect qRect(pRect->x*scale, pRect->y*scale, pRect->width*scale, pRect->height*scale);
+  QRect qRect(pRect->x, pRect->y, pRect->width, pRect->height);
 
   pSnpFigure->rc = qRect;
   pSnpFigure->lineWidth = 1;
   pSnpFigure->color = QColor_cast(fontColor);
 
-  pSnpFigure->textValue = textValue;
+  pSnpFigure->setText(textValue);
   pSnpFigure->fontSize = fontSize;
-  pSnpFigure->fontType = fontType;
+  if(fontType)
+    pSnpFigure->fontType = fontType;
 
-  lsFigures.push_back(pSnpFigure);
-  
-  return (QHandle)pSnpFigure;
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QHandle QSnpImageView::addPoints(
+    const QSnp::SnpPoint* points,       // [in] массив точек
+    int             nPoints,            // [in] количество точек
+    int             ptWidth,            // [in] толщина точки (диаметр)
+    QSnp::SnpColor  color,              // [in] цвет
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  if(!points || nPoints<=0)
+    return QHANDLE_NULL;
+
+  QSnpPointArray* pSnpFigure = new QSnpPointArray(this);
+
+  pSnpFigure->points.resize(nPoints);
+  QPoint* pts = pSnpFigure->points.data();
+  for(int i = 0; i < nPoints; i++)
+    pts[i] = QPoint(points[i].x, points[i].y);
+
+  pSnpFigure->lineWidth = ptWidth;
+  pSnpFigure->color = QColor_cast(color);
+  pSnpFigure->rc = QPolygon(pSnpFigure->points).boundingRect(); // охватывающий прямоугольник
+
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QHandle QSnpImageView::addLines(
+    const QSnp::SnpPoint* points,       // [in] пары точек (начало, конец), 2*nLines элементов
+    int             nLines,             // [in] количество линий
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  if(!points || nLines<=0)
+    return QHANDLE_NULL;
+
+  QSnpLineArray* pSnpFigure = new QSnpLineArray(this);
+
+  pSnpFigure->points.resize(nLines*2);
+  QPoint* pts = pSnpFigure->points.data();
+  for(int i = 0; i < nLines*2; i++)
+    pts[i] = QPoint(points[i].x, points[i].y);
+
+  pSnpFigure->lineWidth = lineWidth;
+  pSnpFigure->color = QColor_cast(color);
+  pSnpFigure->rc = QPolygon(pSnpFigure->points).boundingRect(); // охватывающий прямоугольник
+
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QHandle QSnpImageView::addRects(
+    const QSnp::SnpRect* rects,         // [in] массив прямоугольников
+    int             nRects,             // [in] количество прямоугольников
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  if(!rects || nRects<=0)
+    return QHANDLE_NULL;
+
+  QSnpRectArray* pSnpFigure = new QSnpRectArray(this);
+
+  pSnpFigure->rects.resize(nRects);
+  QRect* prc = pSnpFigure->rects.data();
+  QRect rcBound;
+  for(int i = 0; i < nRects; i++)
+  {
+    prc[i] = QRect(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+    rcBound |= prc[i];
+  }
+
+  pSnpFigure->lineWidth = lineWidth;
+  pSnpFigure->color = QColor_cast(color);
+  pSnpFigure->rc = rcBound; // охватывающий прямоугольник
+
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QHandle QSnpImageView::addPolylines(
+    const QSnp::SnpPoint* points,       // [in] точки всех ломаных подряд
+    const int*      szPolylines,        // [in] количество точек в каждой ломаной
+    int             nPolylines,         // [in] количество ломаных
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::PolygonType type,             // [in] тип (замкнутый многоугольник, ломаная)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  if(!points || !szPolylines || nPolylines<=0)
+    return QHANDLE_NULL;
+
+  int nPoints = 0;
+  for(int i = 0; i < nPolylines; i++)
+  {
+    if(szPolylines[i]<0)
+      return QHANDLE_NULL;
+    nPoints += szPolylines[i];
+  }
+
+  QSnpPolylineArray* pSnpFigure = new QSnpPolylineArray(this);
+
+  pSnpFigure->points.resize(nPoints);
+  QPoint* pts = pSnpFigure->points.data();
+  for(int i = 0; i < nPoints; i++)
+    pts[i] = QPoint(points[i].x, points[i].y);
+  pSnpFigure->sizes = QVector<int>(nPolylines);
+  std::copy(szPolylines, szPolylines+nPolylines, pSnpFigure->sizes.begin());
+
+  pSnpFigure->bClosed = (type & PT_LINES)==0;
+  pSnpFigure->lineWidth = lineWidth;
+  pSnpFigure->color = QColor_cast(color);
+  pSnpFigure->rc = QPolygon(pSnpFigure->points).boundingRect(); // охватывающий прямоугольник
+
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QHandle QSnpImageView::addPointCloud(
+    const QSnp::SnpPoint* points,       // [in] массив точек
+    int             nPoints,            // [in] количество точек
+    int             ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::PointCloudType type,          // [in] режим отрисовки (плотность, пятна)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  if(!points || nPoints<=0)
+    return QHANDLE_NULL;
+
+  QSnpPointCloud* pSnpFigure = new QSnpPointCloud(this);
+
+  pSnpFigure->points.resize(nPoints);
+  QPoint* pts = pSnpFigure->points.data();
+  for(int i = 0; i < nPoints; i++)
+    pts[i] = QPoint(points[i].x, points[i].y);
+
+  pSnpFigure->bSplat = (type & PC_SPLAT)!=0;
+  pSnpFigure->lineWidth = qMax(ptWidth, 1);
+  pSnpFigure->color = QColor_cast(color);
+  pSnpFigure->rc = QPolygon(pSnpFigure->points).boundingRect(); // охватывающий прямоугольник
+
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QHandle QSnpImageView::addTrajectory(
+    const QSnp::SnpPoint* points,       // [in] начальные точки (может быть 0)
+    int             nPoints,            // [in] количество точек
+    int             maxLength,          // [in] максимальное количество точек (0 - без ограничения)
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  QSnpTrajectory* pSnpFigure = new QSnpTrajectory(this);
+  pSnpFigure->nMaxLength = qMax(maxLength, 0);
+  pSnpFigure->lineWidth = lineWidth;
+  pSnpFigure->color = QColor_cast(color);
+
+  // начальные точки добавляются до попадания в группу, окно не перерисовывается
+  for(int i = 0; points && i < nPoints; i++)
+    pSnpFigure->appendPoint(QPoint(points[i].x, points[i].y));
+
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QHandle QSnpImageView::addPolygon(
+    const QSnp::SnpPoint* points,       // [in] массив точек многоугольника
+    int             nPoints,            // [in] количество точек
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::PolygonType type,             // [in] тип (замкнутый многоугольник, ломаная)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  return addPolylines(points, &nPoints, 1, lineWidth, color, type, idGroup);
+}
+
+QHandle QSnpImageView::addArc(
+    QSnp::SnpRect*  pRect,              // [in] охватывающий прямоугольник эллипса
+    double          startAngle,         // [in] начальный угол, градусы
+    double          spanAngle,          // [in] угловой размер дуги, градусы
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  if(!pRect || spanAngle==0)
+    return QHANDLE_NULL;
+
+  const double pi = 3.14159265358979323846;
+  double rx = pRect->width/2.0, ry = pRect->height/2.0;
+  double cx = pRect->x + rx, cy = pRect->y + ry;
+
+  // число сегментов - примерно по сегменту на 4 пикселя длины дуги
+  // (длина окружности эллипса ~ pi*(rx+ry))
+  double span = qMin(qAbs(spanAngle), 360.0);
+  int nSegments = int(span/360.0 * pi*(rx+ry)/4.0) + 1;
+  nSegments = qBound(8, nSegments, 720);
+
+  QVector<SnpPoint> arc(nSegments+1);
+  for(int i = 0; i <= nSegments; i++)
+  {
+    double a = (startAngle + spanAngle*i/nSegments) * pi/180.0;
+    SnpPoint pt = { int(floor(cx + rx*cos(a) + 0.5)), int(floor(cy - ry*sin(a) + 0.5)) };
+    arc[i] = pt;
+  }
+
+  int nPoints = arc.size();
+  return addPolylines(arc.constData(), &nPoints, 1, lineWidth, color, PT_LINES, idGroup);
+}
+
+// палитра оверлея: 256 цветов с прозрачностью alpha
+static QVector<QRgb> overlayPalette(OverlayColormap colormap, const SnpColor* pLut, double alpha)
+{
+  QVector<QRgb> palette(256);
+  int a = qBound(0, int(alpha*255 + 0.5), 255);
+  for(int i = 0; i < 256; i++)
+  {
+    QColor color;
+    int ai = a;
+    if(pLut)
+      color = QColor_cast(pLut[i]);
+    else if(colormap == OC_HEAT)
+    {
+      // синий - голубой - зеленый - желтый - красный
+      double t = i/255.0;
+      color.setRgbF(
+        qBound(0.0, 1.5 - fabs(4*t - 3), 1.0),
+        qBound(0.0, 1.5 - fabs(4*t - 2), 1.0),
+        qBound(0.0, 1.5 - fabs(4*t - 1), 1.0));
+    }
+    else if(colormap == OC_GRAY)
+      color = QColor(i, i, i);
+    else
+      color = QColor::fromHsv((i*137) % 360, 200, 255); // соседние метки - далекие оттенки
+
+    if(colormap == OC_HEAT)
+      ai = a*i/255;                     // низкие значения почти прозрачны
+    else if(colormap == OC_LABELS && i == 0)
+      ai = 0;                           // метка 0 - фон
+    palette[i] = qRgba(color.red(), color.green(), color.blue(), ai);
+  }
+  return palette;
+}
+
+QSnpMatOverlay* QSnpImageView::findMatOverlay(const char* idGroup)
+{
+  QString id = idGroup ? QString(idGroup) : QString("");
+  QSnpFigure* pFigure = QSnpFigureTable::find(hashMatOverlays.value(id, QHANDLE_NULL));
+  if(!pFigure || pFigure->getType()!=SFT_MAT_OVERLAY || pFigure->getGroup()!=getGroup(idGroup))
+    return 0;
+  return (QSnpMatOverlay*)pFigure;
+}
+
+QError QSnpImageView::setOverlayMat(
+    const cv::Mat&  mat,                // [in] CV_8UC1 (метки) или CV_32FC1 (значения 0..1), пустая - удаление
+    OverlayColormap colormap,           // [in] палитра
+    const SnpColor* pLut,               // [in] собственная палитра из 256 цветов (0 - палитра colormap)
+    double          alpha,              // [in] непрозрачность 0..1
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  QString id = idGroup ? QString(idGroup) : QString("");
+  QSnpMatOverlay* pOverlay = findMatOverlay(idGroup);
+
+  if(mat.empty())
+  {
+    if(pOverlay)
+      pOverlay->getGroup()->removeFigure(pOverlay);
+    hashMatOverlays.remove(id);
+    QWidget* pWidget = getWidget();
+    if(pWidget)
+      pWidget->update();
+    return QERR_NO_ERROR;
+  }
+  if(mat.type()!=CV_8UC1 && mat.type()!=CV_32FC1)
+    return QERR_ERROR;
+
+  bool bNew = !pOverlay;
+  if(bNew)
+    pOverlay = new QSnpMatOverlay(this);
+
+  // значения пишутся прямо в строки QImage: векторизованные convertTo/copyTo OpenCV
+  if(pOverlay->image.width()!=mat.cols || pOverlay->image.height()!=mat.rows)
+    pOverlay->image = QImage(mat.cols, mat.rows, QImage::Format_Indexed8);
+  cv::Mat dst(mat.rows, mat.cols, CV_8UC1, pOverlay->image.bits(), pOverlay->image.bytesPerLine());
+  if(mat.type()==CV_32FC1)
+    mat.convertTo(dst, CV_8U, 255.0);   // с насыщением
+  else
+    mat.copyTo(dst);
+
+  pOverlay->setPalette(overlayPalette(colormap, pLut, alpha));
+  pOverlay->rc = QRect(0, 0, mat.cols, mat.rows);
+
+  if(bNew)
+  {
+    QHandle hOverlay = addFigure(pOverlay, idGroup);
+    if(hOverlay == QHANDLE_NULL)
+      return QERR_ERROR;
+    hashMatOverlays.insert(id, hOverlay);
+    QWidget* pWidget = getWidget();
+    if(pWidget)
+      pWidget->update();
+  }
+  else
+    pOverlay->update();
+  return QERR_NO_ERROR;
+}
+
+QError QSnpImageView::setOverlayClassVisible(
+    int             label,              // [in] значение (индекс палитры)
+    bool            bShow,              // [in] показать/скрыть
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  QSnpMatOverlay* pOverlay = findMatOverlay(idGroup);
+  if(!pOverlay)
+    return QERR_ERROR;
+
+  pOverlay->setClassVisible(label, bShow);
+  pOverlay->update();
+  return QERR_NO_ERROR;
+}
+
+// преобразование координат изображения в координаты фигур группы (нет группы - группа по умолчанию)
+QTransform QSnpImageView::userTransform(
+    const char*     idGroup             // [in] идентификатор группы фигур
+    )
+{
+  QSnpFigureGroup* pGroup = getGroup(idGroup);
+  if(!pGroup)
+    pGroup = getGroup(0);
+  return pGroup ? pGroup->transform().inverted() : QTransform();
+}
+
+// получение координат пользовательского многоугольника
+QError QSnpImageView::getUserPolygon(
+    QSnp::SnpPoint* points,             // [out] массив точек многоугольника
+    int*            szPoints,           // [in,out] размер массива / количество точек
+    const char*     idGroup             // [in] группа, в координатах фигур которой возвращаются точки
+    )
+{
+  QSnpImageWidget* pw = (QSnpImageWidget*)pWidget;
+  if(!pw || !szPoints)
+      return QERR_ERROR;
+  if(!pw->userPolygonSet())
+      return QERR_ERROR;
+
+  const QPolygon& polygon = pw->userPolygon();
+  int szBuffer = points ? *szPoints : 0;
+  *szPoints = polygon.size();
+  if(szBuffer < polygon.size())
+    return QERR_ERROR; // в *szPoints - требуемый размер массива
+
+  // в координаты фигур группы
+  QTransform inv = userTransform(idGroup);
+  for(int i = 0; i < polygon.size(); i++)
+  {
+    QPoint pt = inv.map(polygon[i]);
+    points[i].x = pt.x();
+    points[i].y = pt.y();
+  }
+
+  return QERR_NO_ERROR;
 }
 
 // получение координат пользовательской точки
-QError QSnpImageView::getUserPoint(QSnp::SnpPoint* point)
+QError QSnpImageView::getUserPoint(
+    QSnp::SnpPoint* point,              // [out] координаты точки
+    const char*     idGroup             // [in] группа, в координатах фигур которой возвращается точка
+    )
 {
   QSnpImageWidget* pw = (QSnpImageWidget*)pWidget;
   if(!pw)
@@ -335,8 +895,7 @@ QError QSnpImageView::getUserPoint(QSnp::SnpPoint* point)
   if(!pw->userPointSet())
       return QERR_ERROR;
 
-  QPoint pt = pw->userPoint();
-  pt /= scaleFactors[""];
+  QPoint pt = userTransform(idGroup).map(pw->userPoint());
 
   point->x = pt.x();
   point->y = pt.y();
@@ -345,7 +904,10 @@ QError QSnpImageView::getUserPoint(QSnp::SnpPoint* point)
 }
 
 // получение координат пользовательского прямоугольника
-QError QSnpImageView::getUserRect(QSnp::SnpRect* rect)
+QError QSnpImageView::getUserRect(
+    QSnp::SnpRect*  rect,               // [out] координаты прямоугольника
+    const char*     idGroup             // [in] группа, в координатах фигур которой возвращается прямоугольник
+    )
 {
   QSnpImageWidget* pw = (QSnpImageWidget*)pWidget;
   if(!pw)
@@ -353,13 +915,12 @@ QError QSnpImageView::getUserRect(QSnp::SnpRect* rect)
   if(!pw->userRectSet())
       return QERR_ERROR;
 
-  QRect rc = pw->userRect();
-  double scale = scaleFactors[""];
+  QRect rc = userTransform(idGroup).mapRect(pw->userRect());
 
-  rect->x = rc.x()/scale;
-  rect->y = rc.y()/scale;
-  rect->width = rc.width()/scale;
-  rect->height = rc.height()/scale;
+  rect->x = rc.x();
+  rect->y = rc.y();
+  rect->width = rc.width();
+  rect->height = rc.height();
 
   return QERR_NO_ERROR;
 }
@@ -367,10 +928,9 @@ QError QSnpImageView::getUserRect(QSnp::SnpRect* rect)
 // функция удаления всех фигур в данном окне
 QError  QSnpImageView::clearFigures()
 {
-  foreach(QSnpFigure* pf, lsFigures)
-    delete pf;
+  foreach(QSnpFigureGroup* pGroup, lsGroups)
+    pGroup->clear();
 
-  lsFigures.clear();
   QWidget* pWidget = getWidget();
   if(pWidget)
     pWidget->update();
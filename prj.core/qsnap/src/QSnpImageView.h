@@ -13,7 +13,7 @@
 #include "QSnpImageWidget.h"
 
 #include <QScrollArea>
-#include <QMap>
+#include <QHash>
 
 class QSnpImageView : public QSnpView
 {
@@ -53,11 +53,55 @@ public:
     const char*     idGroup = 0         // [in] идентификатор группы фигур (для совместной работы)
     );
 
+  /// установка преобразования группы: масштаб, поворот и сдвиг
+  QError setGroupTransform(
+    double          scale,              // [in] коэффициент масштабирования
+    double          dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+    double          dy,                 // [in] сдвиг по вертикали (в координатах изображения)
+    double          rotation,           // [in] поворот вокруг начала координат, градусы
+    const char*     idGroup = 0         // [in] идентификатор группы фигур
+    );
+
   /// получение коэффициента масштабирования
   double getScaleFactor(
     const char*     idGroup = 0         // [in] идентификатор группы фигур (для совместной работы)
     );
 
+  /// перенос преобразования группы по умолчанию в группы без собственного преобразования
+  void applyDefaultTransform();
+
+  /// группа фигур по идентификатору (0 или "" - группа по умолчанию)
+  QSnpFigureGroup* getGroup(
+    const char*     idGroup,            // [in] идентификатор группы фигур
+    bool            bCreate = false     // [in] создать группу, если ее нет
+    );
+
+  /// добавление фигуры в группу (QHANDLE_NULL - хэндлы исчерпаны, фигура разрушается)
+  QHandle addFigure(
+    QSnpFigure*     pFigure,            // [in] фигура
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// показ/скрытие группы фигур
+  QError showGroup(
+    const char*     idGroup,            // [in] идентификатор группы фигур
+    bool            bShow               // [in] показать/скрыть
+    );
+
+  /// удаление всех фигур группы
+  QError clearGroup(
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// начало построения кадра оверлея: фигуры группы idGroup до commitOverlays
+  /// попадают в задний буфер, который окно не рисует (вызывается в потоке приложения)
+  QError beginOverlay(
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// подмена групп построенными задними буферами (вызывается в потоке окна)
+  QError commitOverlays();
+
   /// добавление точки для отрисовки
   QHandle addPoint(
     int             x,                  // [in] координата по горизонтали
@@ -76,7 +120,7 @@ public:
     int             lineWidth,          // [in] толщина линии
     QSnp::SnpColor  color,              // [in] цвет
     QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
-    const char*     idGrouphView
+    const char*     idGroup             // [in] идентификатор группы фигур
     );
 
   /// добавление прямоугольника для отрисовки
@@ -85,7 +129,7 @@ public:
     int             lineWidth,          // [in] толщина линии
     QSnp::SnpColor  color,              // [in] цвет
     QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
-    const char*     idGrouphView
+    const char*     idGroup             // [in] идентификатор группы фигур
     );
 
   /// добавление эллипса для отрисовки
@@ -94,7 +138,7 @@ public:
     int             lineWidth,          // [in] толщина линии
     QSnp::SnpColor  color,              // [in] цвет
     QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
-    const char*     idGrouphView
+    const char*     idGroup             // [in] идентификатор группы фигур
     );
 
   /// добавление текстового значения
@@ -107,11 +151,126 @@ public:
     const char*     idGroup             // [in] идентификатор группы фигур
     );
 
+  /// добавление массива точек (одна фигура на весь массив)
+  QHandle addPoints(
+    const QSnp::SnpPoint* points,       // [in] массив точек
+    int             nPoints,            // [in] количество точек
+    int             ptWidth,            // [in] толщина точки (диаметр)
+    QSnp::SnpColor  color,              // [in] цвет
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// добавление массива линий (одна фигура на весь массив)
+  QHandle addLines(
+    const QSnp::SnpPoint* points,       // [in] пары точек (начало, конец), 2*nLines элементов
+    int             nLines,             // [in] количество линий
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// добавление массива прямоугольников (одна фигура на весь массив)
+  QHandle addRects(
+    const QSnp::SnpRect* rects,         // [in] массив прямоугольников
+    int             nRects,             // [in] количество прямоугольников
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// добавление набора ломаных (одна фигура на весь набор)
+  QHandle addPolylines(
+    const QSnp::SnpPoint* points,       // [in] точки всех ломаных подряд
+    const int*      szPolylines,        // [in] количество точек в каждой ломаной
+    int             nPolylines,         // [in] количество ломаных
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::PolygonType type,             // [in] тип (замкнутый многоугольник, ломаная)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// добавление облака точек (рисуется растром плотности)
+  QHandle addPointCloud(
+    const QSnp::SnpPoint* points,       // [in] массив точек
+    int             nPoints,            // [in] количество точек
+    int             ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::PointCloudType type,          // [in] режим отрисовки (плотность, пятна)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// добавление траектории (точки добавляются appendPoint)
+  QHandle addTrajectory(
+    const QSnp::SnpPoint* points,       // [in] начальные точки (может быть 0)
+    int             nPoints,            // [in] количество точек
+    int             maxLength,          // [in] максимальное количество точек (0 - без ограничения)
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// добавление многоугольника (ломаной)
+  QHandle addPolygon(
+    const QSnp::SnpPoint* points,       // [in] массив точек многоугольника
+    int             nPoints,            // [in] количество точек
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::PolygonType type,             // [in] тип (замкнутый многоугольник, ломаная)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// добавление дуги эллипса (хранится как ломаная)
+  QHandle addArc(
+    QSnp::SnpRect*  pRect,              // [in] охватывающий прямоугольник эллипса
+    double          startAngle,         // [in] начальный угол, градусы (0 - направление "на 3 часа", против часовой стрелки)
+    double          spanAngle,          // [in] угловой размер дуги, градусы
+    int             lineWidth,          // [in] толщина линии
+    QSnp::SnpColor  color,              // [in] цвет
+    QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// установка полупрозрачного оверлея (маска меток, тепловая карта) группы фигур
+  QError setOverlayMat(
+    const cv::Mat&  mat,                // [in] CV_8UC1 (метки) или CV_32FC1 (значения 0..1), пустая - удаление
+    QSnp::OverlayColormap colormap,     // [in] палитра
+    const QSnp::SnpColor* pLut,         // [in] собственная палитра из 256 цветов (0 - палитра colormap)
+    double          alpha,              // [in] непрозрачность 0..1
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  /// показ/скрытие класса (значения) оверлея без пересчета пикселей
+  QError setOverlayClassVisible(
+    int             label,              // [in] значение (индекс палитры)
+    bool            bShow,              // [in] показать/скрыть
+    const char*     idGroup             // [in] идентификатор группы фигур
+    );
+
+  // преобразование координат изображения в координаты фигур группы (нет группы - группа по умолчанию)
+  QTransform userTransform(
+    const char*     idGroup = 0         // [in] идентификатор группы фигур
+    );
+
   // получение координат пользовательской точки
-  QError getUserPoint(QSnp::SnpPoint* point);
+  QError getUserPoint(
+    QSnp::SnpPoint* point,              // [out] координаты точки
+    const char*     idGroup = 0         // [in] группа, в координатах фигур которой возвращается точка
+    );
+
+  // получение координат пользовательского многоугольника
+  QError getUserPolygon(
+    QSnp::SnpPoint* points,             // [out] массив точек многоугольника
+    int*            szPoints,           // [in,out] размер массива / количество точек
+    const char*     idGroup = 0         // [in] группа, в координатах фигур которой возвращаются точки
+    );
 
   // получение координат пользовательского прямоугольника
-  QError getUserRect(QSnp::SnpRect* rect);
+  QError getUserRect(
+    QSnp::SnpRect*  rect,               // [out] координаты прямоугольника
+    const char*     idGroup = 0         // [in] группа, в координатах фигур которой возвращается прямоугольник
+    );
   
   // функция удаления всех фигур в данном окне
   QError  clearFigures();
@@ -129,14 +288,28 @@ public: // events
   virtual void onVerSliderMoved(int value);
 
 public: // members
-  QList<QSnpFigure*> lsFigures;         // массив фигур для прорисовки
+  QList<QSnpFigureGroup*> lsGroups;     // группы фигур в порядке создания (порядок прорисовки)
 protected: // members
   QScrollArea scrollArea;               // элемент скролирования
   
   int nStartHorSliderPos;
   int nStartVerSliderPos;
 
-  QMap<QString,double> scaleFactors;    // массив масштабов для каждой группы фигур
+  QHash<QString,QSnpFigureGroup*> hashGroups; // индекс групп фигур по идентификатору
+
+  // задние буферы оверлеев: beginOverlay работает в потоке приложения, поэтому
+  // буферы защищены мьютексом, а группы окна (lsGroups, hashGroups) в нем не меняются
+  QHash<QString,QSnpFigureGroup*> hashOverlays; // строящиеся задние буферы оверлеев
+  QHash<QString,QSnpFigureGroup*> hashSpares;   // прошлые кадры оверлеев для повторного использования
+  QMutex mutOverlays;                           // блокировка hashOverlays и hashSpares
+
+  // удаление буферов оверлеев
+  void destroyOverlays();
+
+  QHash<QString,QHandle> hashMatOverlays;     // оверлеи изображения по группам
+
+  // оверлей изображения группы (0 - нет)
+  QSnpMatOverlay* findMatOverlay(const char* idGroup);
 
 
 };
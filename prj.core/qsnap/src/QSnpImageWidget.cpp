@@ -53,6 +53,7 @@ QSnpImageWidget::QSnpImageWidget(QSnpImageView* pView)
   qApp->installEventFilter(new SiwEventFilter(this));
   pImageView = pView;
   pParentImageView = NULL;
+  plsGroups = NULL;
 }
 
 QSnpImageWidget::~QSnpImageWidget(void)
@@ -67,14 +68,22 @@ void	QSnpImageWidget::paintEvent(QPaintEvent* ev)
 
   painter.begin(this);
 
-  // отрисовка изображения
-  painter.drawImage(rect(), image, image.rect());
+  // отрисовка изображения (только перерисовываемая область)
+  QRect rcPaint = ev->rect();
+  if(width()>0 && height()>0)
+  {
+    qreal sx = qreal(image.width())/width();
+    qreal sy = qreal(image.height())/height();
+    QRectF rcSource(rcPaint.x()*sx, rcPaint.y()*sy, rcPaint.width()*sx, rcPaint.height()*sy);
+    painter.drawImage(QRectF(rcPaint), image, rcSource);
+  }
 
-  // отрисовка фигур
-  foreach (QSnpFigure* pf, *plsFigures)
+  // отрисовка фигур: каждая группа - кэшированный слой, при прокрутке 
+  // слой только копируется; скрытые группы пропускаются целиком
+  if(plsGroups)
   {
-    if(pf->bVisible)
-      pf->Draw(&painter, ratio);
+    foreach (QSnpFigureGroup* pGroup, *plsGroups)
+      pGroup->DrawCached(&painter, ratio, this, rcPaint);
   }
 
   // отрисовка пользовательской точки
@@ -95,6 +104,24 @@ void	QSnpImageWidget::paintEvent(QPaintEvent* ev)
     pPainter->drawEllipse(rcUserPt);
   }
   
+  // отрисовка пользовательского многоугольника
+  if(!polyUser.isEmpty())
+  {
+    pPainter->setPen(QPen(Qt::cyan, 2));
+    pPainter->setBrush(Qt::NoBrush);
+
+    QPolygon polyImage(polyUser.size());
+    for(int i = 0; i < polyUser.size(); i++)
+      polyImage[i] = QPoint(float_scale(float(polyUser[i].x())+0.5, ratio), float_scale(float(polyUser[i].y())+0.5, ratio));
+
+    if(polyImage.size() > 2)
+      pPainter->drawPolygon(polyImage);
+    else
+      pPainter->drawPolyline(polyImage);
+    for(int i = 0; i < polyImage.size(); i++)
+      pPainter->drawEllipse(polyImage[i], radusPt, radusPt);
+  }
+
   // отрисовка пользовательского прямоугольника
   if(bUserRectSet || bMouseIsDragging)
   {
@@ -143,6 +170,16 @@ void	QSnpImageWidget::mousePressEvent(QMouseEvent* ev)
 
   }
 
+  // обработка выставления вершин многоугольника (при нажатии ALT)
+  if(kbdModifiers & Qt::AltModifier)
+  {
+    if(ev->button() & Qt::LeftButton)
+      polyUser.append(QPoint(float(ev->pos().x())/ratio, float(ev->pos().y())/ratio));
+    else if(ev->button() & Qt::RightButton)
+      polyUser.clear();
+    update();
+  }
+
   // обработка начала выставления прямоугольника(при нажатии SHIFT)
   if( (kbdModifiers & Qt::ShiftModifier) &&
       (ev->button() & Qt::LeftButton)
@@ -289,4 +326,4 @@ void QSnpImageWidget::onHorSliderMoved ( int value )
 void QSnpImageWidget::onVerSliderMoved ( int value )
 {
   getView()->onVerSliderMoved(value);
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -22,7 +22,7 @@ public:
   QSnpImageWidget(QSnpImageView* pView = NULL);
   virtual ~QSnpImageWidget(void);
 
-  void setFigures(QList<QSnpFigure*>* pf) { plsFigures = pf; }
+  void setGroups(QList<QSnpFigureGroup*>* pg) { plsGroups = pg; }
 
   // информация о пользовательском прямоугольнике
   bool    userRectSet()   { return bUserRectSet; }
@@ -32,6 +32,13 @@ public:
   bool    userPointSet()  { return bUserPointSet; }
   QPoint  userPoint()     { return ptUserPoint; }
 
+  // информация о пользовательском многоугольнике
+  bool    userPolygonSet() { return !polyUser.isEmpty(); }
+  const QPolygon& userPolygon() { return polyUser; }
+
+  // коэффициент сжатия изображения
+  float   getRatio()      { return ratio; }
+
   QSnpImageView* getView() { return pImageView; }
   QSnpImageView* getParentView() { return pParentImageView; }
   void setParentView(QSnpImageView* pView) { pParentImageView = pView; }
@@ -51,7 +58,7 @@ protected slots:
 protected: // members
   QImage  image;                         ///< изображение
   float   ratio;                         ///< коэффициент сжатия изображения 
-  QList<QSnpFigure*>* plsFigures;
+  QList<QSnpFigureGroup*>* plsGroups;    ///< группы фигур (принадлежат view)
 
   // отображение пользовательского прямоугольника
   QRect   rcUserRect;
@@ -61,6 +68,9 @@ protected: // members
   QPoint  ptUserPoint;
   bool    bUserPointSet;
 
+  // пользовательский многоугольник (ALT+щелчок - вершина, ALT+правая кнопка - сброс)
+  QPolygon polyUser;
+
   bool    bMouseIsDragging;
   bool    bPictureDragging; // перетаскивание картинки
   QPoint  ptFirstDragPoint;
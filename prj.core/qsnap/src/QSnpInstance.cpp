@@ -7,6 +7,8 @@
 
 #include "QSnpInstance.h"
 
+QSNP_IMPLEMENT_POOLED(QSnpEvent)
+
 QSnpInstance::QSnpInstance(void)
 {
   pTreeView = NULL;
@@ -67,6 +69,10 @@ bool QSnpInstance::removeView(QSnpView* pView)
 // перерисовка всех view-окон инстанса
 bool QSnpInstance::updateViews()
 {
+  // отложенные строки дерева снепа показываются до перерисовки
+  if(pTreeView && pTreeView->getTreeModel())
+    pTreeView->getTreeModel()->flush();
+
   for(QList<QSnpView*>::iterator it=lstViews.begin(); it!=lstViews.end(); it++)
   {
     QSnpView* pView = *it;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "QSnpTreeView.h"
+#include "QSnpPool.h"
 #include <QList>
 
 class QSnpEvent;
@@ -69,7 +70,10 @@ public:
   QString   sParm;        ///< основной параметр
   void*     pParmEx;      ///< дополнительный параметр
 
+  // события (копии внутри QList) размещаются в пуле
+  QSNP_DECLARE_POOLED(QSnpEvent)
+
 protected:
   QHandle   hInstance;    ///< хэндл инстанса
 
-};
\ No newline at end of file
+};
\ No newline at end of file
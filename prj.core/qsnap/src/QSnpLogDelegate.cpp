@@ -0,0 +1,98 @@
+/**
+  \file   QSnpLogDelegate.cpp
+  \brief  Class function members for the text Log line delegate
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpLogDelegate.h"
+#include "QSnpLogModel.h"
+
+#include <QApplication>
+#include <QPainter>
+
+#include <qsnap/qsnap_types.h>
+
+// отступ текста от края строки
+#define QSNP_LOG_TEXT_MARGIN  3
+
+QSnpLogDelegate::QSnpLogDelegate(QObject* pParent) :
+  QStyledItemDelegate(pParent), nMaxWidth(0), nMaxChars(0)
+{
+}
+
+const QFont& QSnpLogDelegate::fontFor(quint32 attr, const QFont& fontView) const
+{
+  if(fontView != fontBase)
+  {
+    fontBase = fontView;
+    for(int i = 0; i < 8; i++)
+    {
+      fonts[i] = fontView;
+      fonts[i].setBold((i & 1) != 0);
+      fonts[i].setItalic((i & 2) != 0);
+      fonts[i].setUnderline((i & 4) != 0);
+    }
+  }
+  int i = ((attr & QSNP_LOG_ATTR_BOLD) ? 1 : 0) | ((attr & QSNP_LOG_ATTR_ITALIC) ? 2 : 0) |
+    ((attr & QSNP_LOG_ATTR_UNDERLINED) ? 4 : 0);
+  return fonts[i];
+}
+
+QColor QSnpLogDelegate::colorFor(quint32 attr, const QColor& colorText)
+{
+  if(attr & QSNP_LOG_ATTR_COLORED)
+    return QColor(QRgb(attr & QSNP_LOG_ATTR_COLOR));
+
+  // цвет по уровню сообщения, если цвет не задан явно
+  int level = int((attr & QSNP_LOG_ATTR_LEVEL) >> QSNP_LOG_ATTR_LEVEL_SHIFT) - 1;
+  switch(level)
+  {
+  case LL_DEBUG:    return QColor(128, 128, 128);
+  case LL_WARNING:  return QColor(176, 96, 0);
+  case LL_ERROR:    return QColor(200, 0, 0);
+  default:          return colorText;
+  }
+}
+
+void QSnpLogDelegate::paint(QPainter* pPainter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+  quint32 attr = index.data(QSNP_LOG_ATTR_ROLE).toUInt();
+  bool bSelected = (option.state & QStyle::State_Selected) != 0;
+
+  // фон (выделение, текущая строка) рисуется стилем, текст - напрямую без разбора разметки
+  QStyle* pStyle = option.widget ? option.widget->style() : QApplication::style();
+  pStyle->drawPrimitive(QStyle::PE_PanelItemViewItem, &option, pPainter, option.widget);
+
+  pPainter->save();
+  pPainter->setFont(fontFor(attr, option.font));
+  pPainter->setPen(bSelected ? option.palette.color(QPalette::HighlightedText) :
+    colorFor(attr, option.palette.color(QPalette::Text)));
+  pPainter->drawText(option.rect.adjusted(QSNP_LOG_TEXT_MARGIN, 0, 0, 0),
+    Qt::AlignLeft | Qt::AlignVCenter | Qt::TextSingleLine, index.data().toString());
+  pPainter->restore();
+}
+
+QSize QSnpLogDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+  quint32 attr = index.data(QSNP_LOG_ATTR_ROLE).toUInt();
+  QFontMetrics fm(fontFor(attr, option.font));
+  int width = qMax(nMaxWidth, fm.width(index.data().toString()));
+  return QSize(width + 2*QSNP_LOG_TEXT_MARGIN, QFontMetrics(option.font).height());
+}
+
+bool QSnpLogDelegate::measureLine(const QByteArray& text, quint32 attr, const QFont& fontView)
+{
+  // символов в строке UTF-8 не больше, чем байт: строка не длиннее самой
+  // длинной измеренной (моноширинный шрифт окна) не измеряется
+  if(text.size() <= nMaxChars)
+    return false;
+
+  QString str = QString::fromUtf8(text);
+  nMaxChars = qMax(nMaxChars, str.size());
+  int width = QFontMetrics(fontFor(attr, fontView)).width(str);
+  if(width <= nMaxWidth)
+    return false;
+  nMaxWidth = width;
+  return true;
+}
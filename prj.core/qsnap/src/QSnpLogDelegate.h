@@ -0,0 +1,48 @@
+/**
+  \file   QSnpLogDelegate.h
+  \brief  Item delegate drawing text Log lines with per-line attributes
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QStyledItemDelegate>
+#include <QFont>
+
+///////////////////////////////////////////////////////////
+////  Отрисовка строки лога по атрибутам строки (QSNP_LOG_ATTR_ROLE):
+////  цвет, жирный/курсив/подчеркнутый шрифт, цвет по уровню сообщения.
+////  Шрифты всех сочетаний признаков создаются один раз от шрифта окна,
+////  поэтому оформленная строка рисуется так же дешево, как обычная.
+////  Окно показывает строки одинакового размера (uniformItemSizes), поэтому
+////  ширина строки в sizeHint - ширина самой длинной учтенной строки лога
+
+class QSnpLogDelegate : public QStyledItemDelegate
+{
+  Q_OBJECT
+public:
+  QSnpLogDelegate(QObject* pParent = 0);
+
+  virtual void paint(QPainter* pPainter, const QStyleOptionViewItem& option, const QModelIndex& index) const;
+  virtual QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const;
+
+  /// учет ширины новой строки лога: true, если самая длинная строка стала шире
+  bool measureLine(const QByteArray& text, quint32 attr, const QFont& fontView);
+
+  /// сброс ширины строк (после очистки лога)
+  void resetWidth() { nMaxWidth = 0; nMaxChars = 0; }
+
+protected:
+  // шрифт для атрибутов строки
+  const QFont& fontFor(quint32 attr, const QFont& fontView) const;
+
+  // цвет текста для атрибутов строки
+  static QColor colorFor(quint32 attr, const QColor& colorText);
+
+protected:
+  mutable QFont fontBase;               // шрифт окна, от которого построены варианты
+  mutable QFont fonts[8];               // варианты шрифта по признакам bold | italic | underlined
+  int           nMaxWidth;              // ширина самой длинной учтенной строки
+  int           nMaxChars;              // количество символов самой длинной учтенной строки
+};
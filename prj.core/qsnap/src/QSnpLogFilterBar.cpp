@@ -0,0 +1,118 @@
+/**
+  \file   QSnpLogFilterBar.cpp
+  \brief  Class function members for the Log view filter toolbar
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpLogFilterBar.h"
+
+#include <QAction>
+#include <QComboBox>
+#include <QLineEdit>
+
+using namespace QSnp;
+
+QSnpLogFilterBar::QSnpLogFilterBar(LogFilter* _pFilter, QWidget* pParent) :
+  QToolBar(pParent), pFilter(_pFilter)
+{
+  pComboLevel = new QComboBox(this);
+  pComboLevel->addItem("Debug");
+  pComboLevel->addItem("Info");
+  pComboLevel->addItem("Warning");
+  pComboLevel->addItem("Error");
+  addWidget(pComboLevel);
+  addSeparator();
+
+  pEditSearch = new QLineEdit(this);
+  pEditSearch->setPlaceholderText("Search");
+  addWidget(pEditSearch);
+  pActRegExp = addAction(".*");
+  pActRegExp->setCheckable(true);
+  pActRegExp->setToolTip("Regular expression");
+  pActFilter = addAction("Filter");
+  pActFilter->setCheckable(true);
+  pActFilter->setToolTip("Show matching lines only");
+  QAction* pActPrev = addAction("<");
+  pActPrev->setToolTip("Previous match");
+  QAction* pActNext = addAction(">");
+  pActNext->setToolTip("Next match");
+  addSeparator();
+
+  // Ctrl+F - переход в строку поиска
+  QAction* pActFind = new QAction(this);
+  pActFind->setShortcut(QKeySequence::Find);
+  pActFind->setShortcutContext(Qt::WindowShortcut);
+  pEditSearch->addAction(pActFind);
+
+  updateState();
+  connect(pComboLevel, SIGNAL(currentIndexChanged(int)), this, SLOT(onLevelChanged(int)));
+  connect(pEditSearch, SIGNAL(textChanged(const QString&)), this, SLOT(onSearchChanged()));
+  connect(pEditSearch, SIGNAL(returnPressed()), this, SLOT(onFindNext()));
+  connect(pActRegExp, SIGNAL(toggled(bool)), this, SLOT(onSearchChanged()));
+  connect(pActFilter, SIGNAL(toggled(bool)), this, SLOT(onSearchChanged()));
+  connect(pActPrev, SIGNAL(triggered()), this, SLOT(onFindPrev()));
+  connect(pActNext, SIGNAL(triggered()), this, SLOT(onFindNext()));
+  connect(pActFind, SIGNAL(triggered()), pEditSearch, SLOT(setFocus()));
+}
+
+QSnpLogFilterBar::~QSnpLogFilterBar(void)
+{
+}
+
+void QSnpLogFilterBar::addChannel(int channel, const QString& sName)
+{
+  QAction* pAction = addAction(sName);
+  pAction->setCheckable(true);
+  pAction->setData(channel);
+  pAction->setChecked(((pFilter->channels.load() >> channel) & 1) != 0);
+  connect(pAction, SIGNAL(toggled(bool)), this, SLOT(onChannelToggled(bool)));
+  actChannels.push_back(pAction);
+}
+
+void QSnpLogFilterBar::updateState()
+{
+  pComboLevel->blockSignals(true);
+  pComboLevel->setCurrentIndex(qBound(LL_DEBUG, pFilter->level.load(), LL_ERROR));
+  pComboLevel->blockSignals(false);
+
+  unsigned long long channels = pFilter->channels.load();
+  for(int i = 0; i < actChannels.size(); i++)
+  {
+    actChannels[i]->blockSignals(true);
+    actChannels[i]->setChecked(((channels >> actChannels[i]->data().toInt()) & 1) != 0);
+    actChannels[i]->blockSignals(false);
+  }
+}
+
+void QSnpLogFilterBar::onLevelChanged(int level)
+{
+  pFilter->level.store(level);
+}
+
+void QSnpLogFilterBar::onChannelToggled(bool bChecked)
+{
+  QAction* pAction = qobject_cast<QAction*>(sender());
+  if(!pAction)
+    return;
+  unsigned long long bit = 1ull << pAction->data().toInt();
+  if(bChecked)
+    pFilter->channels.fetch_or(bit);
+  else
+    pFilter->channels.fetch_and(~bit);
+}
+
+void QSnpLogFilterBar::onSearchChanged()
+{
+  emit searchChanged(pEditSearch->text(), pActRegExp->isChecked(), pActFilter->isChecked());
+}
+
+void QSnpLogFilterBar::onFindNext()
+{
+  emit findRequested(false);
+}
+
+void QSnpLogFilterBar::onFindPrev()
+{
+  emit findRequested(true);
+}
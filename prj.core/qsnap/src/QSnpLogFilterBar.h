@@ -0,0 +1,60 @@
+/**
+  \file   QSnpLogFilterBar.h
+  \brief  Toolbar of the text Log view: log levels, channels and search
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QToolBar>
+#include <QVector>
+
+#include <qsnap/qsnap_types.h>
+
+class QComboBox;
+class QLineEdit;
+class QAction;
+
+///////////////////////////////////////////////////////////
+////  Панель фильтра лога: уровень сообщений и включение каналов.
+////  Изменения сразу записываются в общий с proxy фильтр, поэтому
+////  вызывающий перестает форматировать отключенные сообщения.
+////  Строка поиска ищет по мере ввода (подстрока или регулярное
+////  выражение), с фильтром или переходом к совпадениям
+
+class QSnpLogFilterBar : public QToolBar
+{
+  Q_OBJECT
+public:
+  QSnpLogFilterBar(QSnp::LogFilter* pFilter, QWidget* pParent = 0);
+  virtual ~QSnpLogFilterBar(void);
+
+  /// добавление кнопки канала
+  void addChannel(int channel, const QString& sName);
+
+  /// обновление состояния кнопок по фильтру (после изменения через API)
+  void updateState();
+
+signals:
+  /// изменено условие поиска
+  void searchChanged(const QString& sText, bool bRegExp, bool bFilter);
+
+  /// запрошен переход к следующему (предыдущему) совпадению
+  void findRequested(bool bBackward);
+
+protected slots:
+  void onLevelChanged(int level);
+  void onChannelToggled(bool bChecked);
+  void onSearchChanged();
+  void onFindNext();
+  void onFindPrev();
+
+protected:
+  QSnp::LogFilter*  pFilter;            // фильтр окна
+  QComboBox*        pComboLevel;        // выбор уровня
+  QLineEdit*        pEditSearch;        // строка поиска
+  QAction*          pActRegExp;         // поиск по регулярному выражению
+  QAction*          pActFilter;         // показывать только найденные строки
+  QVector<QAction*> actChannels;        // кнопки каналов (data - номер канала)
+};
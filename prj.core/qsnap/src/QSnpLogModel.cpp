@@ -0,0 +1,336 @@
+/**
+  \file   QSnpLogModel.cpp
+  \brief  Class function members for the ring-buffered text Log model
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpLogModel.h"
+#include "QSnpLogSpill.h"
+
+#include <qsnap/qsnap_types.h>
+
+#include <cstring>
+
+QSnpLogModel::QSnpLogModel(QObject* pParent) :
+  QAbstractListModel(pParent), ring(), nFirstSeq(0), nStart(0), nCount(0), nBytes(0), bLastOpen(false),
+  nMaxLines(QSNP_LOG_MAX_LINES), nMaxBytes(QSNP_LOG_MAX_BYTES), pSpill(0)
+{
+}
+
+QSnpLogModel::~QSnpLogModel(void)
+{
+  delete pSpill;
+}
+
+int QSnpLogModel::spillRows() const
+{
+  return pSpill ? int(pSpill->endSeq() - pSpill->firstSeq()) : 0;
+}
+
+qint64 QSnpLogModel::firstSeq() const
+{
+  return pSpill ? pSpill->firstSeq() : nFirstSeq;
+}
+
+QByteArray QSnpLogModel::line(int i) const
+{
+  int nSpill = spillRows();
+  if(i < nSpill)
+    return pSpill->line(pSpill->firstSeq() + i);
+  return lineAt(i - nSpill).text;
+}
+
+quint64 QSnpLogModel::lineSig(int i) const
+{
+  // сигнатуры выгруженных строк не хранятся и вычисляются при чтении
+  int nSpill = spillRows();
+  if(i < nSpill)
+  {
+    QByteArray str = line(i);
+    return signature(str.constData(), str.size());
+  }
+  return lineAt(i - nSpill).sig;
+}
+
+quint64 QSnpLogModel::signature(const char* str, int len)
+{
+  quint64 sig = 0;
+  for(int i = 1; i < len; i++)
+  {
+    unsigned a = (unsigned char)lowerAscii(str[i-1]);
+    unsigned b = (unsigned char)lowerAscii(str[i]);
+    sig |= 1ull << ((a*31 + b) & 63);
+  }
+  return sig;
+}
+
+quint32 QSnpLogModel::makeAttr(bool bColored, int color, int fontFlags, int level)
+{
+  quint32 attr = 0;
+  if(bColored)
+    attr |= QSNP_LOG_ATTR_COLORED | (quint32(color) & QSNP_LOG_ATTR_COLOR);
+  if(fontFlags & FF_BOLD)
+    attr |= QSNP_LOG_ATTR_BOLD;
+  if(fontFlags & FF_ITALIC)
+    attr |= QSNP_LOG_ATTR_ITALIC;
+  if(fontFlags & FF_UNDERLINED)
+    attr |= QSNP_LOG_ATTR_UNDERLINED;
+  if(level >= LL_DEBUG && level <= LL_ERROR)
+    attr |= quint32(level + 1) << QSNP_LOG_ATTR_LEVEL_SHIFT;
+  return attr;
+}
+
+int QSnpLogModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : count();
+}
+
+QVariant QSnpLogModel::data(const QModelIndex& index, int role) const
+{
+  if(!index.isValid() || index.row()>=count())
+    return QVariant();
+  if(role == Qt::DisplayRole)
+    return QString::fromUtf8(line(index.row()));
+  if(role == QSNP_LOG_ATTR_ROLE)
+  {
+    int nSpill = spillRows();
+    return index.row() < nSpill ? 0u : (uint)lineAt(index.row() - nSpill).attr;
+  }
+  return QVariant();
+}
+
+void QSnpLogModel::appendText(const char* str)
+{
+  appendText(str, 0, 0);
+}
+
+void QSnpLogModel::appendText(const char* str, const QSnpLogRun* runs, int nRuns)
+{
+  if(!str || !*str)
+    return;
+  if(pSpill && pSpill->failed())
+    stopFailedSpill();
+
+  // текст разбивается на строки, все новые строки добавляются одной вставкой
+  QVector<QSnpLogLine> lines;
+  bool bOpen = bLastOpen;
+  const char* pBegin = str;
+  int iRun = 0;
+  for(;;)
+  {
+    const char* pEnd = strchr(pBegin, '\n');
+    int len = pEnd ? int(pEnd - pBegin) : int(strlen(pBegin));
+    if(!pEnd && len == 0)
+      break;
+
+    // атрибуты строки - первые ненулевые атрибуты участков, пересекающихся со строкой
+    size_t offset = pBegin - str, offsetEnd = offset + len;
+    while(iRun + 1 < nRuns && runs[iRun+1].offset <= offset)
+      iRun++;
+    quint32 attr = 0;
+    for(int i = iRun; i < nRuns && (i == iRun || runs[i].offset < offsetEnd) && !attr; i++)
+      attr = runs[i].attr;
+
+    QByteArray piece(pBegin, len);
+    if(bOpen && lines.isEmpty())
+      extendLastLine(piece, attr);
+    else
+    {
+      QSnpLogLine lineNew;
+      lineNew.text = piece;
+      lineNew.attr = attr;
+      lines.push_back(lineNew);
+    }
+    bOpen = (pEnd == 0);
+
+    if(!pEnd)
+      break;
+    pBegin = pEnd + 1;
+  }
+
+  pushLines(lines);
+  bLastOpen = bOpen && nCount > 0;
+}
+
+void QSnpLogModel::pushLines(const QVector<QSnpLogLine>& lines)
+{
+  // из блока длиннее ограничения сохраняются последние строки
+  int nFirst = qMax(0, lines.size() - nMaxLines);
+  int nNew = lines.size() - nFirst;
+  if(nNew == 0)
+    return;
+
+  trim(nNew);
+  if(nCount + nNew > ring.size())
+    grow(nCount + nNew);
+
+  int nRow = count();
+  beginInsertRows(QModelIndex(), nRow, nRow + nNew - 1);
+  for(int i = nFirst; i < lines.size(); i++)
+  {
+    QSnpLogLine& lineNew = ring[(nStart+nCount) % ring.size()];
+    lineNew = lines[i];
+    lineNew.sig = signature(lineNew.text.constData(), lineNew.text.size());
+    nCount++;
+    nBytes += lineCost(lineNew.text);
+  }
+  endInsertRows();
+
+  trim(0);
+}
+
+void QSnpLogModel::extendLastLine(const QByteArray& str, quint32 attr)
+{
+  if(nCount == 0)
+  {
+    QSnpLogLine lineNew;
+    lineNew.text = str;
+    lineNew.attr = attr;
+    pushLines(QVector<QSnpLogLine>(1, lineNew));
+    return;
+  }
+
+  QSnpLogLine& last = lineAt(nCount-1);
+  nBytes += str.size();
+  last.text += str;
+  if(!last.attr)
+    last.attr = attr;
+  last.sig = signature(last.text.constData(), last.text.size());
+  QModelIndex index = createIndex(count()-1, 0);
+  emit dataChanged(index, index);
+
+  trim(0);
+}
+
+void QSnpLogModel::trim(int nReserve)
+{
+  // количество вытесняемых строк (без резервирования последняя строка остается всегда)
+  int nDrop = 0;
+  qint64 nBytesLeft = nBytes;
+  int nLimit = nMaxLines - nReserve;
+  while(nCount - nDrop > 0 && (nCount - nDrop > nLimit || nBytesLeft > nMaxBytes))
+  {
+    if(nReserve == 0 && nCount - nDrop == 1)
+      break;
+    nBytesLeft -= lineCost(lineAt(nDrop).text);
+    nDrop++;
+  }
+  if(nDrop == 0)
+  {
+    rotateSpill(nReserve);
+    return;
+  }
+
+  // при выгрузке строки остаются в логе (переходят в сегменты), номера строк не меняются
+  if(!pSpill)
+    beginRemoveRows(QModelIndex(), 0, nDrop-1);
+  for(int i = 0; i < nDrop; i++)
+  {
+    if(pSpill)
+      pSpill->append(ring[nStart].text);
+    ring[nStart] = QSnpLogLine();       // память строки освобождается сразу
+    nStart = (nStart+1) % ring.size();
+  }
+  nCount -= nDrop;
+  nFirstSeq += nDrop;
+  nBytes = nBytesLeft;
+  if(nCount == 0)
+  {
+    nStart = 0;
+    bLastOpen = false;
+  }
+  if(!pSpill)
+    endRemoveRows();
+
+  rotateSpill(nReserve);
+}
+
+void QSnpLogModel::rotateSpill(int nReserve)
+{
+  // самые старые сегменты удаляются вместе со строками при превышении количества
+  // сегментов, а без ограничения сегментов - при выходе количества строк за int
+  while(pSpill && pSpill->oldestSegmentLines() > 0 && (pSpill->overLimit() ||
+    pSpill->endSeq() - pSpill->firstSeq() + nCount + nReserve > QSNP_LOG_MAX_ROWS))
+  {
+    beginRemoveRows(QModelIndex(), 0, pSpill->oldestSegmentLines()-1);
+    pSpill->dropOldestSegment();
+    endRemoveRows();
+  }
+}
+
+void QSnpLogModel::grow(int nRequired)
+{
+  int nCapacity = qMin(qMax(qMax(ring.size()*2, 1024), nRequired), nMaxLines);
+  if(nCapacity <= ring.size())
+    return;
+
+  // строки переносятся в начало нового буфера (QByteArray копируется без данных)
+  QVector<QSnpLogLine> ringNew(nCapacity);
+  for(int i = 0; i < nCount; i++)
+    ringNew[i] = lineAt(i);
+  ring.swap(ringNew);
+  nStart = 0;
+}
+
+void QSnpLogModel::clear()
+{
+  beginResetModel();
+  ring.clear();
+  nFirstSeq += nCount;
+  if(pSpill)
+    pSpill->forget(nFirstSeq);
+  nStart = 0;
+  nCount = 0;
+  nBytes = 0;
+  bLastOpen = false;
+  endResetModel();
+}
+
+void QSnpLogModel::setLimits(int maxLines, qint64 maxBytes)
+{
+  nMaxLines = maxLines > 0 ? maxLines : QSNP_LOG_MAX_LINES;
+  nMaxBytes = maxBytes > 0 ? maxBytes : QSNP_LOG_MAX_BYTES;
+
+  trim(0);
+
+  // буфер больше нового ограничения строк уменьшается
+  if(ring.size() > nMaxLines)
+  {
+    QVector<QSnpLogLine> ringNew(qMax(nMaxLines, nCount));
+    for(int i = 0; i < nCount; i++)
+      ringNew[i] = lineAt(i);
+    ring.swap(ringNew);
+    nStart = 0;
+  }
+}
+
+void QSnpLogModel::stopFailedSpill()
+{
+  QString sError = pSpill->errorString();
+  setSpill(QString(), 0, 0);
+
+  QSnpLogLine lineError;
+  lineError.text = QString("Log spill stopped: %1").arg(sError).toUtf8();
+  lineError.attr = makeAttr(false, 0, 0, LL_ERROR);
+  bLastOpen = false;
+  pushLines(QVector<QSnpLogLine>(1, lineError));
+}
+
+void QSnpLogModel::setSpill(const QString& sDir, qint64 segmentBytes, int maxSegments)
+{
+  // выгруженные ранее строки удаляются из лога вместе с файлами:
+  // новая выгрузка пишет файлы с другим именем и старые не ротирует
+  int nSpill = spillRows();
+  if(nSpill > 0)
+    beginRemoveRows(QModelIndex(), 0, nSpill-1);
+  if(pSpill)
+    pSpill->forget(pSpill->endSeq());
+  delete pSpill;
+  pSpill = 0;
+  if(nSpill > 0)
+    endRemoveRows();
+
+  if(!sDir.isEmpty())
+    pSpill = new QSnpLogSpill(sDir, segmentBytes, maxSegments, nFirstSeq);
+}
@@ -0,0 +1,164 @@
+/**
+  \file   QSnpLogModel.h
+  \brief  Ring-buffered line store of the text Log exposed as a list model
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QVector>
+
+class QSnpLogSpill;
+
+// ограничения лога по умолчанию
+#define QSNP_LOG_MAX_LINES    1000000
+#define QSNP_LOG_MAX_BYTES    (128*1024*1024)
+
+// предел количества строк модели с учетом выгруженных (номер строки - int): при
+// неограниченном количестве сегментов сверх предела удаляются самые старые сегменты
+#define QSNP_LOG_MAX_ROWS     0x7fffffff
+
+// учитываемые накладные расходы на строку (заголовок QByteArray, сигнатура и атрибуты)
+#define QSNP_LOG_LINE_OVERHEAD  48
+
+// атрибуты строки лога, упакованные в 32 бита: цвет 0xRRGGBB, признаки шрифта и уровень
+#define QSNP_LOG_ATTR_COLOR       0x00ffffff  // цвет текста
+#define QSNP_LOG_ATTR_COLORED     0x01000000  // цвет задан
+#define QSNP_LOG_ATTR_BOLD        0x02000000  // жирный
+#define QSNP_LOG_ATTR_ITALIC      0x04000000  // курсив
+#define QSNP_LOG_ATTR_UNDERLINED  0x08000000  // подчеркнутый
+#define QSNP_LOG_ATTR_LEVEL_SHIFT 28          // уровень LL_* + 1 (0 - уровень не задан)
+#define QSNP_LOG_ATTR_LEVEL       0x70000000
+
+// роль модели: атрибуты строки (quint32)
+#define QSNP_LOG_ATTR_ROLE        (Qt::UserRole + 1)
+
+// строка лога с сигнатурой для поиска
+struct QSnpLogLine
+{
+  QByteArray  text;                     // текст строки (UTF-8)
+  quint64     sig;                      // множество пар соседних символов (см. QSnpLogModel::signature)
+  quint32     attr;                     // атрибуты QSNP_LOG_ATTR_*
+
+  QSnpLogLine() : sig(0), attr(0) {}
+};
+
+// начало участка текста с атрибутами attr (см. QSnpLogModel::appendText)
+struct QSnpLogRun
+{
+  size_t      offset;                   // смещение начала участка в тексте
+  quint32     attr;                     // атрибуты QSNP_LOG_ATTR_*
+};
+
+///////////////////////////////////////////////////////////
+////  Строки лога в кольцевом буфере.
+////  Добавление строки - O(1) (буфер растет удвоением до maxLines),
+////  при превышении maxLines строк или maxBytes байт вытесняются
+////  самые старые строки. Строки хранятся в UTF-8, QString строится
+////  только для видимых строк при отрисовке. Для каждой строки при
+////  добавлении вычисляется сигнатура - битовая маска пар соседних
+////  символов, по которой поиск подстроки отбрасывает строки без
+////  сравнения текста. При включенной выгрузке вытесненные строки
+////  не удаляются из лога, а дописываются в файлы-сегменты и читаются
+////  из них при прокрутке (строки выгрузки предшествуют строкам буфера).
+////  Оформление строки (цвет, шрифт, уровень) хранится 32-битными
+////  атрибутами рядом с текстом и применяется при отрисовке строки;
+////  выгруженные строки хранятся без атрибутов. При ошибке записи файлов
+////  выгрузка выключается, а в лог добавляется строка с описанием ошибки
+
+class QSnpLogModel : public QAbstractListModel
+{
+  Q_OBJECT
+public:
+  QSnpLogModel(QObject* pParent = 0);
+  virtual ~QSnpLogModel(void);
+
+  /// добавление текста: '\n' завершает строку, незавершенная строка дополняется следующим вызовом;
+  /// все новые строки добавляются одной вставкой (одно обновление окна на вызов)
+  void appendText(const char* str);
+
+  /// добавление текста с атрибутами: runs - участки по возрастанию смещений,
+  /// строка получает атрибуты первого участка с ненулевыми атрибутами
+  void appendText(const char* str, const QSnpLogRun* runs, int nRuns);
+
+  /// упаковка атрибутов строки (color - 0xRRGGBB, level < 0 - уровень не задан)
+  static quint32 makeAttr(bool bColored, int color, int fontFlags, int level);
+
+  /// удаление всех строк
+  void clear();
+
+  /// установка ограничений (0 - значение по умолчанию)
+  void setLimits(int maxLines, qint64 maxBytes);
+
+  /// включение выгрузки вытесненных строк в каталог sDir (пустой каталог - выключение)
+  void setSpill(const QString& sDir, qint64 segmentBytes, int maxSegments);
+
+  /// количество строк (с учетом выгруженных)
+  int count() const { return spillRows() + nCount; }
+
+  /// строка по номеру от начала лога (UTF-8)
+  QByteArray line(int i) const;
+
+  /// сигнатура строки по номеру от начала лога
+  quint64 lineSig(int i) const;
+
+  /// сквозной номер первой строки (количество строк, вытесненных и удаленных с начала работы)
+  qint64 firstSeq() const;
+
+  /// сигнатура текста: по биту на хэш каждой пары соседних символов (без учета регистра)
+  static quint64 signature(const char* str, int len);
+
+  /// байт UTF-8 в нижнем регистре: только латиница A-Z, байты многобайтных символов не меняются
+  /// (общее правило для сигнатур, строки поиска и сравнения)
+  static char lowerAscii(char c) { return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c; }
+
+  /// занятая строками память (с учетом накладных расходов)
+  qint64 bytes() const { return nBytes; }
+
+public: // QAbstractListModel
+  virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+protected:
+  // добавление новых строк в конец буфера одной вставкой
+  void pushLines(const QVector<QSnpLogLine>& lines);
+
+  // дописывание к последней (незавершенной) строке
+  void extendLastLine(const QByteArray& str, quint32 attr);
+
+  // вытеснение старых строк до выполнения ограничений (nReserve - освободить место под новые строки)
+  void trim(int nReserve);
+
+  // удаление старых сегментов выгрузки сверх ограничений (nReserve - место под новые строки)
+  void rotateSpill(int nReserve);
+
+  // размещение строк с начала буфера и увеличение его емкости (не менее nRequired)
+  void grow(int nRequired);
+
+  static qint64 lineCost(const QByteArray& str) { return str.size() + QSNP_LOG_LINE_OVERHEAD; }
+
+  QSnpLogLine& lineAt(int i) { return ring[(nStart+i) % ring.size()]; }
+  const QSnpLogLine& lineAt(int i) const { return ring[(nStart+i) % ring.size()]; }
+
+  // количество выгруженных строк
+  int spillRows() const;
+
+  // выключение выгрузки после ошибки записи с выводом ошибки строкой лога
+  void stopFailedSpill();
+
+protected:
+  QVector<QSnpLogLine> ring;            // кольцевой буфер строк
+  qint64    nFirstSeq;                  // сквозной номер первой строки
+  int       nStart;                     // позиция первой строки
+  int       nCount;                     // количество строк
+  qint64    nBytes;                     // память строк
+  bool      bLastOpen;                  // последняя строка не завершена '\n'
+
+  int       nMaxLines;                  // максимальное количество строк
+  qint64    nMaxBytes;                  // максимальный объем строк
+
+  QSnpLogSpill* pSpill;                 // выгрузка вытесненных строк (0 - выключена)
+};
@@ -0,0 +1,413 @@
+/**
+  \file   QSnpLogQueue.cpp
+  \brief  Class function members for per-thread binary buffering of Log output
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpLogQueue.h"
+#include "QSnpTextView.h"
+
+#include <QMetaObject>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace QSnp;
+
+// номер последней созданной очереди
+static std::atomic_int nQueueGeneration(0);
+
+// буфер потока-производителя; при завершении потока буфер отмечается
+// отсоединенным и удаляется очередью после вывода оставшегося текста
+struct QSnpLogThreadHolder
+{
+  std::shared_ptr<QSnpLogThreadBuffer> pBuffer;
+  int nGeneration;
+
+  QSnpLogThreadHolder() : nGeneration(-1) {}
+  ~QSnpLogThreadHolder()
+  {
+    if(pBuffer)
+      pBuffer->bDetached.store(true);
+  }
+};
+
+static thread_local QSnpLogThreadHolder threadHolder;
+
+QSnpLogQueue::QSnpLogQueue(void) : nGeneration(++nQueueGeneration)
+{
+  bScheduled.store(false);
+}
+
+QSnpLogQueue::~QSnpLogQueue(void)
+{
+}
+
+QSnpLogThreadBuffer* QSnpLogQueue::threadBuffer()
+{
+  if(threadHolder.nGeneration != nGeneration || !threadHolder.pBuffer)
+  {
+    if(threadHolder.pBuffer)
+      threadHolder.pBuffer->bDetached.store(true);
+    threadHolder.pBuffer = std::make_shared<QSnpLogThreadBuffer>();
+    threadHolder.nGeneration = nGeneration;
+
+    std::lock_guard<std::mutex> lk(mutBuffers);
+    buffers.push_back(threadHolder.pBuffer);
+  }
+  return threadHolder.pBuffer.get();
+}
+
+size_t QSnpLogQueue::append(QHandle hView, const char* str, unsigned int attr)
+{
+  QSnpLogThreadBuffer* pBuffer = threadBuffer();
+  size_t len = strlen(str);
+
+  std::lock_guard<std::mutex> lk(pBuffer->mut);
+  std::string& data = pBuffer->data;
+
+  // текст подряд идущих сообщений одному окну с одинаковыми атрибутами дописывается в одну запись
+  QSnpLogRecord rec;
+  if(pBuffer->nLastText != std::string::npos)
+  {
+    memcpy(&rec, &data[pBuffer->nLastText], sizeof(rec));
+    if(rec.hView == hView && rec.attr == attr)
+    {
+      rec.nSize += (unsigned int)len;
+      memcpy(&data[pBuffer->nLastText], &rec, sizeof(rec));
+      data.append(str, len);
+      return data.size();
+    }
+  }
+
+  rec.hView = hView;
+  rec.kind = QSNP_LOG_RECORD_TEXT;
+  rec.nSize = (unsigned int)len;
+  rec.attr = attr;
+  pBuffer->nLastText = data.size();
+  data.append((const char*)&rec, sizeof(rec));
+  data.append(str, len);
+  return data.size();
+}
+
+size_t QSnpLogQueue::appendFormat(QHandle hView, const char* format, const LogArg* args, int nArgs, bool bNewLine,
+  unsigned int attr)
+{
+  QSnpLogThreadBuffer* pBuffer = threadBuffer();
+
+  // аргументы копируются как есть, строки - в конец записи
+  size_t nStrings = 0;
+  for(int i = 0; i < nArgs; i++)
+    if(args[i].type == LA_STRING && args[i].s)
+      nStrings += strlen(args[i].s) + 1;
+
+  QSnpLogRecord rec;
+  rec.hView = hView;
+  rec.kind = QSNP_LOG_RECORD_FORMAT;
+  rec.nSize = (unsigned int)(sizeof(QSnpLogFormat) + nArgs*sizeof(LogArg) + nStrings);
+  rec.attr = attr;
+
+  QSnpLogFormat fmt;
+  fmt.format = format;
+  fmt.nArgs = nArgs;
+  fmt.bNewLine = bNewLine ? 1 : 0;
+
+  std::lock_guard<std::mutex> lk(pBuffer->mut);
+  std::string& data = pBuffer->data;
+  data.reserve(data.size() + sizeof(rec) + rec.nSize);
+  data.append((const char*)&rec, sizeof(rec));
+  data.append((const char*)&fmt, sizeof(fmt));
+
+  unsigned long long offString = 0;
+  for(int i = 0; i < nArgs; i++)
+  {
+    LogArg arg = args[i];
+    if(arg.type == LA_STRING)
+    {
+      // смещение строки в копиях, ~0 - нулевой указатель
+      arg.u = arg.s ? offString : ~0ull;
+      if(args[i].s)
+        offString += strlen(args[i].s) + 1;
+    }
+    data.append((const char*)&arg, sizeof(arg));
+  }
+  for(int i = 0; i < nArgs; i++)
+    if(args[i].type == LA_STRING && args[i].s)
+      data.append(args[i].s, strlen(args[i].s) + 1);
+
+  pBuffer->nLastText = std::string::npos;
+  return data.size();
+}
+
+// вывод одного преобразования printf с аргументом нужного типа
+template <typename T>
+static void formatArg(std::string& out, const std::string& spec, T value)
+{
+  char buf[64];
+  int len = snprintf(buf, sizeof(buf), spec.c_str(), value);
+  if(len < 0)
+    return;
+  if(len < (int)sizeof(buf))
+  {
+    out.append(buf, len);
+    return;
+  }
+  std::vector<char> bufLong(len + 1);
+  snprintf(&bufLong[0], bufLong.size(), spec.c_str(), value);
+  out.append(&bufLong[0], len);
+}
+
+static long long argInt(const LogArg& arg)
+{
+  switch(arg.type)
+  {
+  case LA_DOUBLE:  return (long long)arg.d;
+  case LA_POINTER: return (long long)(size_t)arg.p;
+  default:         return arg.i;
+  }
+}
+
+static double argDouble(const LogArg& arg)
+{
+  switch(arg.type)
+  {
+  case LA_INT:    return (double)arg.i;
+  case LA_UINT:   return (double)arg.u;
+  case LA_DOUBLE: return arg.d;
+  default:        return 0;
+  }
+}
+
+void QSnpLogQueue::format(std::string& out, const char* format, const LogArg* args, int nArgs)
+{
+  // модификаторы длины из строки формата отбрасываются: тип берется из аргумента,
+  // поэтому несоответствие формата и аргумента не приводит к чтению чужой памяти
+  int iArg = 0;
+  const char* p = format;
+  while(*p)
+  {
+    const char* pPercent = strchr(p, '%');
+    if(!pPercent)
+    {
+      out.append(p);
+      break;
+    }
+    out.append(p, pPercent - p);
+    p = pPercent + 1;
+    if(*p == '%')
+    {
+      out += '%';
+      p++;
+      continue;
+    }
+
+    std::string spec("%");
+    while(*p && strchr("-+ #0", *p))
+      spec += *p++;
+    for(int iPart = 0; iPart < 2; iPart++)  // ширина и точность
+    {
+      if(iPart == 1)
+      {
+        if(*p != '.')
+          break;
+        spec += *p++;
+      }
+      if(*p == '*')
+      {
+        char sNum[16];
+        sprintf(sNum, "%d", iArg < nArgs ? (int)argInt(args[iArg++]) : 0);
+        spec += sNum;
+        p++;
+      }
+      while(*p >= '0' && *p <= '9')
+        spec += *p++;
+    }
+    while(*p && strchr("hlLqjzt", *p))
+      p++;
+    if(p[0] == 'I' && p[1] == '6' && p[2] == '4')
+      p += 3;
+
+    char conv = *p;
+    if(!conv)
+      break;
+    p++;
+
+    if(iArg >= nArgs)
+    {
+      // аргументов меньше, чем преобразований: преобразование выводится как есть
+      out += spec;
+      out += conv;
+      continue;
+    }
+    const LogArg& arg = args[iArg++];
+
+    switch(conv)
+    {
+    case 'd': case 'i':
+      formatArg(out, spec + "lld", argInt(arg));
+      break;
+    case 'u': case 'o': case 'x': case 'X':
+      formatArg(out, spec + "ll" + conv, (unsigned long long)argInt(arg));
+      break;
+    case 'c':
+      formatArg(out, spec + "c", (int)argInt(arg));
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+      formatArg(out, spec + conv, argDouble(arg));
+      break;
+    case 's':
+      formatArg(out, spec + "s", arg.type == LA_STRING && arg.s ? arg.s : "(null)");
+      break;
+    case 'p':
+      formatArg(out, spec + "p", arg.type == LA_POINTER ? arg.p : (const void*)(size_t)argInt(arg));
+      break;
+    default:
+      // неизвестное преобразование (в т.ч. %n) не выполняется
+      break;
+    }
+  }
+}
+
+void QSnpLogQueue::render(const std::string& data, QHash<QHandle, QSnpLogBatch>& batches, std::vector<QHandle>& orderViews)
+{
+  size_t pos = 0;
+  std::vector<LogArg> args;
+  while(pos + sizeof(QSnpLogRecord) <= data.size())
+  {
+    QSnpLogRecord rec;
+    memcpy(&rec, &data[pos], sizeof(rec));
+    pos += sizeof(rec);
+    const char* pData = data.data() + pos;
+    pos += rec.nSize;
+
+    if(!batches.contains(rec.hView))
+      orderViews.push_back(rec.hView);
+    QSnpLogBatch& batch = batches[rec.hView];
+    std::string& text = batch.text;
+
+    // новый участок при смене атрибутов
+    if(batch.runs.empty() || batch.runs.back().attr != rec.attr)
+    {
+      QSnpLogRun run = { text.size(), rec.attr };
+      batch.runs.push_back(run);
+    }
+
+    if(rec.kind == QSNP_LOG_RECORD_TEXT)
+    {
+      text.append(pData, rec.nSize);
+      continue;
+    }
+
+    QSnpLogFormat fmt;
+    memcpy(&fmt, pData, sizeof(fmt));
+    args.resize(fmt.nArgs);
+    if(fmt.nArgs > 0)
+      memcpy(&args[0], pData + sizeof(fmt), fmt.nArgs*sizeof(LogArg));
+
+    // строковые аргументы указывают на копии в записи
+    const char* pStrings = pData + sizeof(fmt) + fmt.nArgs*sizeof(LogArg);
+    for(int i = 0; i < fmt.nArgs; i++)
+      if(args[i].type == LA_STRING)
+        args[i].s = args[i].u == ~0ull ? 0 : pStrings + args[i].u;
+
+    format(text, fmt.format, fmt.nArgs > 0 ? &args[0] : 0, fmt.nArgs);
+    if(fmt.bNewLine)
+      text += '\n';
+  }
+}
+
+void QSnpLogQueue::postFlush()
+{
+  QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+}
+
+void QSnpLogQueue::purge(QHandle hView)
+{
+  std::vector<std::shared_ptr<QSnpLogThreadBuffer> > buffersNow;
+  {
+    std::lock_guard<std::mutex> lk(mutBuffers);
+    buffersNow = buffers;
+  }
+
+  // записи остальных окон сохраняются в прежнем порядке
+  for(size_t i = 0; i < buffersNow.size(); i++)
+  {
+    QSnpLogThreadBuffer* pBuffer = buffersNow[i].get();
+    std::lock_guard<std::mutex> lk(pBuffer->mut);
+    std::string& data = pBuffer->data;
+
+    size_t pos = 0, posOut = 0;
+    size_t nLastText = std::string::npos;
+    while(pos + sizeof(QSnpLogRecord) <= data.size())
+    {
+      QSnpLogRecord rec;
+      memcpy(&rec, &data[pos], sizeof(rec));
+      size_t szRecord = sizeof(rec) + rec.nSize;
+      if(rec.hView != hView)
+      {
+        if(pos == pBuffer->nLastText)
+          nLastText = posOut;
+        if(posOut != pos)
+          memmove(&data[posOut], &data[pos], szRecord);
+        posOut += szRecord;
+      }
+      pos += szRecord;
+    }
+    data.resize(posOut);
+    pBuffer->nLastText = nLastText;
+  }
+}
+
+void QSnpLogQueue::flush()
+{
+  // сообщения, добавленные во время сброса, планируют следующий сброс
+  bScheduled.store(false);
+
+  // текст забирается из буферов потоков, блокировки держатся только на время обмена
+  std::vector<std::shared_ptr<QSnpLogThreadBuffer> > buffersNow;
+  {
+    std::lock_guard<std::mutex> lk(mutBuffers);
+    buffersNow = buffers;
+  }
+
+  // форматирование отложенных сообщений выполняется здесь, вне потоков-производителей
+  QHash<QHandle, QSnpLogBatch> batches;
+  std::vector<QHandle> orderViews;
+  std::string data;
+  for(size_t i = 0; i < buffersNow.size(); i++)
+  {
+    QSnpLogThreadBuffer* pBuffer = buffersNow[i].get();
+    {
+      std::lock_guard<std::mutex> lk(pBuffer->mut);
+      data.swap(pBuffer->data);
+      pBuffer->nLastText = std::string::npos;
+    }
+    render(data, batches, orderViews);
+    data.clear();
+  }
+
+  // один вызов на окно: одна вставка строк и одна прокрутка за такт
+  for(size_t i = 0; i < orderViews.size(); i++)
+  {
+    QSnpTextView* pText = (QSnpTextView*)orderViews[i];
+    const QSnpLogBatch& batch = batches[orderViews[i]];
+    pText->Log(batch.text.c_str(), batch.runs.empty() ? 0 : &batch.runs[0], (int)batch.runs.size());
+  }
+
+  // удаление буферов завершенных потоков
+  std::lock_guard<std::mutex> lk(mutBuffers);
+  for(size_t i = 0; i < buffers.size(); )
+  {
+    if(buffers[i]->bDetached.load())
+    {
+      std::lock_guard<std::mutex> lkBuffer(buffers[i]->mut);
+      if(buffers[i]->data.empty())
+      {
+        buffers.erase(buffers.begin() + i);
+        continue;
+      }
+    }
+    i++;
+  }
+}
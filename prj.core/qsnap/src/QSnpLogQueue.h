@@ -0,0 +1,118 @@
+/**
+  \file   QSnpLogQueue.h
+  \brief  Per-thread binary buffering of Log output flushed to text views in batches
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+
+#include <qsnap/qsnap_types.h>
+
+#include "QSnpLogModel.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// объем буфера потока, при превышении которого производитель ждет сброса
+#define QSNP_LOG_QUEUE_MAX_BYTES  (4*1024*1024)
+
+// виды записей буфера
+#define QSNP_LOG_RECORD_TEXT    0       // готовый текст
+#define QSNP_LOG_RECORD_FORMAT  1       // строка формата и аргументы, форматируются при сбросе
+
+// заголовок записи буфера (за ним следуют nSize байт данных)
+struct QSnpLogRecord
+{
+  QHandle       hView;                  // окно лога
+  unsigned int  kind;                   // вид записи QSNP_LOG_RECORD_*
+  unsigned int  nSize;                  // размер данных записи
+  unsigned int  attr;                   // атрибуты строк QSNP_LOG_ATTR_*
+};
+
+// текст одного окна за такт с участками атрибутов
+struct QSnpLogBatch
+{
+  std::string             text;         // текст
+  std::vector<QSnpLogRun> runs;         // участки с атрибутами
+};
+
+// данные записи QSNP_LOG_RECORD_FORMAT: за ними nArgs аргументов LogArg
+// и копии строковых аргументов (в LogArg::u смещение строки от начала копий)
+struct QSnpLogFormat
+{
+  const char*   format;                 // строка формата (должна существовать до сброса)
+  int           nArgs;                  // количество аргументов
+  int           bNewLine;               // завершить вывод переводом строки
+};
+
+// буфер одного потока-производителя: последовательность записей
+struct QSnpLogThreadBuffer
+{
+  std::mutex        mut;                // блокировка производителя и сброса (почти всегда свободна)
+  std::string       data;               // записи QSnpLogRecord с данными
+  size_t            nLastText;          // смещение последней текстовой записи (для склейки)
+  std::atomic_bool  bDetached;          // поток завершен, буфер удаляется после сброса
+
+  QSnpLogThreadBuffer() : nLastText(std::string::npos) { bDetached.store(false); }
+};
+
+///////////////////////////////////////////////////////////
+////  Очередь вывода в текстовые окна.
+////  Log/LogLn только дописывают текст в буфер своего потока и
+////  при необходимости планируют сброс; сброс выполняется в потоке
+////  QApplication один раз за такт: текст каждого окна добавляется
+////  одним вызовом (одна вставка строк и одна прокрутка)
+
+class QSnpLogQueue : public QObject
+{
+  Q_OBJECT
+public:
+  QSnpLogQueue(void);
+  virtual ~QSnpLogQueue(void);
+
+  /// добавление текста с атрибутами строк в буфер текущего потока; возвращает объем буфера потока
+  size_t append(QHandle hView, const char* str, unsigned int attr = 0);
+
+  /// добавление строки формата и аргументов без форматирования; возвращает объем буфера потока
+  size_t appendFormat(QHandle hView, const char* format, const QSnp::LogArg* args, int nArgs, bool bNewLine,
+    unsigned int attr = 0);
+
+  /// форматирование сообщения по строке формата printf и типизированным аргументам
+  static void format(std::string& out, const char* format, const QSnp::LogArg* args, int nArgs);
+
+  /// отметка о планировании сброса: true, если сброс еще не был запланирован
+  bool schedule() { return !bScheduled.exchange(true); }
+
+  /// есть текст, ожидающий сброса
+  bool scheduled() const { return bScheduled.load(); }
+
+  /// планирование сброса следующим тактом цикла событий потока очереди
+  void postFlush();
+
+  /// удаление из буферов всех записей окна (перед разрушением окна, поток QApplication)
+  void purge(QHandle hView);
+
+public slots:
+  /// вывод накопленного текста в окна (поток QApplication)
+  void flush();
+
+protected:
+  // буфер текущего потока (создается и регистрируется при первом вызове)
+  QSnpLogThreadBuffer* threadBuffer();
+
+  // вывод записей буфера в тексты окон
+  static void render(const std::string& data, QHash<QHandle, QSnpLogBatch>& batches, std::vector<QHandle>& orderViews);
+
+protected:
+  std::mutex  mutBuffers;                                   // блокировка списка буферов
+  std::vector<std::shared_ptr<QSnpLogThreadBuffer> > buffers; // буферы потоков
+  std::atomic_bool bScheduled;                              // сброс запланирован
+  int         nGeneration;                                  // номер очереди (буферы потоков привязаны к очереди)
+};
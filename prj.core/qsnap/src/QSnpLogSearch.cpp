@@ -0,0 +1,224 @@
+/**
+  \file   QSnpLogSearch.cpp
+  \brief  Class function members for incremental search over the text Log
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpLogSearch.h"
+#include "QSnpLogModel.h"
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////
+////  QSnpLogQuery
+
+QSnpLogQuery::QSnpLogQuery(void) : bRegExp(false), sig(0)
+{
+}
+
+QSnpLogQuery::QSnpLogQuery(const QString& _sText, bool _bRegExp) :
+  sText(_sText), bRegExp(_bRegExp), sig(0)
+{
+  if(bRegExp)
+  {
+    rx = QRegExp(sText, Qt::CaseInsensitive);
+    return;
+  }
+  // QByteArray::toLower меняет и байты UTF-8 старше 0x7f (как Latin-1)
+  textLower = sText.toUtf8();
+  for(int i = 0; i < textLower.size(); i++)
+    textLower[i] = QSnpLogModel::lowerAscii(textLower[i]);
+  sig = QSnpLogModel::signature(textLower.constData(), textLower.size());
+}
+
+static bool equalNoCase(char a, char b)
+{
+  return QSnpLogModel::lowerAscii(a) == QSnpLogModel::lowerAscii(b);
+}
+
+bool QSnpLogQuery::matches(const QByteArray& line) const
+{
+  if(isEmpty())
+    return true;
+  if(bRegExp)
+    return rx.isValid() && rx.indexIn(QString::fromUtf8(line)) >= 0;
+  return std::search(line.constBegin(), line.constEnd(),
+    textLower.constBegin(), textLower.constEnd(), equalNoCase) != line.constEnd();
+}
+
+bool QSnpLogQuery::refines(const QSnpLogQuery& prev) const
+{
+  // подстрока, содержащая прежнюю, находит только строки, найденные прежней
+  return !bRegExp && !prev.bRegExp && !prev.isEmpty() && textLower.contains(prev.textLower);
+}
+
+///////////////////////////////////////////////////////////
+////  QSnpLogFilterModel
+
+QSnpLogFilterModel::QSnpLogFilterModel(QSnpLogModel* _pSource, QObject* pParent) :
+  QAbstractListModel(pParent), pSource(_pSource)
+{
+  connect(pSource, SIGNAL(rowsInserted(const QModelIndex&, int, int)),
+    this, SLOT(onSourceRowsInserted(const QModelIndex&, int, int)));
+  connect(pSource, SIGNAL(rowsRemoved(const QModelIndex&, int, int)),
+    this, SLOT(onSourceRowsRemoved(const QModelIndex&, int, int)));
+  connect(pSource, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)),
+    this, SLOT(onSourceDataChanged(const QModelIndex&, const QModelIndex&)));
+  connect(pSource, SIGNAL(modelReset()), this, SLOT(onSourceReset()));
+}
+
+QSnpLogFilterModel::~QSnpLogFilterModel(void)
+{
+}
+
+bool QSnpLogFilterModel::lineMatches(int sourceRow) const
+{
+  return queryCur.mayMatch(pSource->lineSig(sourceRow)) && queryCur.matches(pSource->line(sourceRow));
+}
+
+void QSnpLogFilterModel::setQuery(const QSnpLogQuery& query)
+{
+  beginResetModel();
+  if(query.isEmpty())
+    seqs.clear();
+  else if(query.refines(queryCur))
+  {
+    // уточнение: проверяются только найденные строки
+    queryCur = query;
+    qint64 firstSeq = pSource->firstSeq();
+    int nKept = 0;
+    for(int i = 0; i < seqs.size(); i++)
+      if(lineMatches(int(seqs[i] - firstSeq)))
+        seqs[nKept++] = seqs[i];
+    seqs.resize(nKept);
+  }
+  else
+  {
+    // полный просмотр: большинство строк отбрасывается по сигнатуре
+    queryCur = query;
+    seqs.clear();
+    qint64 firstSeq = pSource->firstSeq();
+    int nCount = pSource->count();
+    for(int i = 0; i < nCount; i++)
+      if(lineMatches(i))
+        seqs.push_back(firstSeq + i);
+  }
+  queryCur = query;
+  endResetModel();
+}
+
+int QSnpLogFilterModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : seqs.size();
+}
+
+QVariant QSnpLogFilterModel::data(const QModelIndex& index, int role) const
+{
+  if(!index.isValid() || index.row() >= seqs.size())
+    return QVariant();
+  int row = sourceRow(index.row());
+  if(row < 0)
+    return QVariant();
+  return pSource->data(pSource->index(row), role);
+}
+
+int QSnpLogFilterModel::sourceRow(int row) const
+{
+  qint64 sourceRow = seqs[row] - pSource->firstSeq();
+  return sourceRow < 0 || sourceRow >= pSource->count() ? -1 : int(sourceRow);
+}
+
+int QSnpLogFilterModel::rowForSource(int sourceRow) const
+{
+  qint64 seq = pSource->firstSeq() + sourceRow;
+  return int(std::lower_bound(seqs.begin(), seqs.end(), seq) - seqs.begin());
+}
+
+int QSnpLogFilterModel::findNext(int sourceRow, bool bBackward) const
+{
+  if(seqs.isEmpty())
+    return -1;
+
+  qint64 seq = pSource->firstSeq() + sourceRow;
+  int row;
+  if(bBackward)
+    row = int(std::lower_bound(seqs.begin(), seqs.end(), seq) - seqs.begin()) - 1;
+  else
+    row = int(std::upper_bound(seqs.begin(), seqs.end(), seq) - seqs.begin());
+
+  // поиск продолжается с другого конца лога
+  if(row < 0)
+    row = seqs.size() - 1;
+  else if(row >= seqs.size())
+    row = 0;
+  return this->sourceRow(row);
+}
+
+void QSnpLogFilterModel::onSourceRowsInserted(const QModelIndex& parent, int first, int last)
+{
+  if(queryCur.isEmpty())
+    return;
+
+  // проверяются только добавленные строки
+  qint64 firstSeq = pSource->firstSeq();
+  QVector<qint64> seqsNew;
+  for(int i = first; i <= last; i++)
+    if(lineMatches(i))
+      seqsNew.push_back(firstSeq + i);
+  if(seqsNew.isEmpty())
+    return;
+
+  beginInsertRows(QModelIndex(), seqs.size(), seqs.size() + seqsNew.size() - 1);
+  seqs += seqsNew;
+  endInsertRows();
+}
+
+void QSnpLogFilterModel::onSourceRowsRemoved(const QModelIndex& parent, int first, int last)
+{
+  // строки вытесняются только с начала лога
+  qint64 firstSeq = pSource->firstSeq();
+  int nDrop = int(std::lower_bound(seqs.begin(), seqs.end(), firstSeq) - seqs.begin());
+  if(nDrop == 0)
+    return;
+
+  beginRemoveRows(QModelIndex(), 0, nDrop - 1);
+  seqs.remove(0, nDrop);
+  endRemoveRows();
+}
+
+void QSnpLogFilterModel::onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+  if(queryCur.isEmpty())
+    return;
+
+  // изменяется только дописываемая последняя строка
+  int sourceRow = bottomRight.row();
+  qint64 seq = pSource->firstSeq() + sourceRow;
+  bool bFound = !seqs.isEmpty() && seqs.last() == seq;
+  bool bMatches = lineMatches(sourceRow);
+  if(bMatches && !bFound)
+  {
+    beginInsertRows(QModelIndex(), seqs.size(), seqs.size());
+    seqs.push_back(seq);
+    endInsertRows();
+  }
+  else if(!bMatches && bFound)
+  {
+    beginRemoveRows(QModelIndex(), seqs.size() - 1, seqs.size() - 1);
+    seqs.pop_back();
+    endRemoveRows();
+  }
+  else if(bFound)
+  {
+    QModelIndex index = createIndex(seqs.size() - 1, 0);
+    emit dataChanged(index, index);
+  }
+}
+
+void QSnpLogFilterModel::onSourceReset()
+{
+  beginResetModel();
+  seqs.clear();
+  endResetModel();
+}
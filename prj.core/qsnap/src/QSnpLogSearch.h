@@ -0,0 +1,94 @@
+/**
+  \file   QSnpLogSearch.h
+  \brief  Incremental search and filtering over the ring-buffered text Log
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QRegExp>
+#include <QVector>
+
+class QSnpLogModel;
+
+///////////////////////////////////////////////////////////
+////  Условие поиска: подстрока без учета регистра или
+////  регулярное выражение
+
+class QSnpLogQuery
+{
+public:
+  QSnpLogQuery(void);
+  QSnpLogQuery(const QString& sText, bool bRegExp);
+
+  /// пустое условие (подходит любая строка)
+  bool isEmpty() const { return sText.isEmpty(); }
+
+  /// строка может подойти по сигнатуре (без сравнения текста)
+  bool mayMatch(quint64 sigLine) const { return (sigLine & sig) == sig; }
+
+  /// строка подходит
+  bool matches(const QByteArray& line) const;
+
+  /// найденные этим условием строки - подмножество найденных prev (уточнение ввода)
+  bool refines(const QSnpLogQuery& prev) const;
+
+protected:
+  QString     sText;                    // текст условия
+  bool        bRegExp;                  // регулярное выражение
+  QByteArray  textLower;                // подстрока в UTF-8, латиница в нижнем регистре
+  quint64     sig;                      // сигнатура подстроки (0 для регулярного выражения)
+  QRegExp     rx;                       // регулярное выражение
+};
+
+///////////////////////////////////////////////////////////
+////  Строки лога, удовлетворяющие условию поиска.
+////  Хранит сквозные номера найденных строк; при добавлении строк
+////  проверяются только новые, при вытеснении отбрасывается начало
+////  списка, при уточнении условия просматриваются только уже
+////  найденные строки. Используется и как модель фильтра окна,
+////  и для перехода к следующему совпадению в полном логе
+
+class QSnpLogFilterModel : public QAbstractListModel
+{
+  Q_OBJECT
+public:
+  QSnpLogFilterModel(QSnpLogModel* pSource, QObject* pParent = 0);
+  virtual ~QSnpLogFilterModel(void);
+
+  /// установка условия поиска (при пустом условии список пуст)
+  void setQuery(const QSnpLogQuery& query);
+
+  /// условие поиска
+  const QSnpLogQuery& query() const { return queryCur; }
+
+  /// строка исходного лога по строке фильтра (-1, если строка вытеснена)
+  int sourceRow(int row) const;
+
+  /// первая строка фильтра, соответствующая строке исходного лога >= sourceRow
+  int rowForSource(int sourceRow) const;
+
+  /// следующее совпадение в исходном логе после (перед) строкой sourceRow, -1 если нет
+  int findNext(int sourceRow, bool bBackward) const;
+
+public: // QAbstractListModel
+  virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+protected slots:
+  void onSourceRowsInserted(const QModelIndex& parent, int first, int last);
+  void onSourceRowsRemoved(const QModelIndex& parent, int first, int last);
+  void onSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+  void onSourceReset();
+
+protected:
+  // строка исходного лога удовлетворяет условию
+  bool lineMatches(int sourceRow) const;
+
+protected:
+  QSnpLogModel*   pSource;              // исходный лог
+  QSnpLogQuery    queryCur;             // условие поиска
+  QVector<qint64> seqs;                 // сквозные номера найденных строк по возрастанию
+};
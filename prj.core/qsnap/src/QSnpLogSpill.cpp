@@ -0,0 +1,344 @@
+/**
+  \file   QSnpLogSpill.cpp
+  \brief  Class function members for memory-mapped text Log spill files
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpLogSpill.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+
+QSnpLogSpill::QSnpLogSpill(
+    const QString&  _sDir,              // [in] каталог файлов
+    qint64          segmentBytes,       // [in] размер сегмента (0 - по умолчанию)
+    int             maxSegments,        // [in] максимальное количество сегментов (0 - без ограничения)
+    qint64          firstSeq            // [in] сквозной номер первой выгружаемой строки
+    ) :
+  sDir(_sDir), nSegmentBytes(segmentBytes > 0 ? segmentBytes : QSNP_SPILL_SEGMENT_BYTES),
+  nMaxSegments(qMax(maxSegments, 0)), nSegmentNumber(0), nFirstSeq(firstSeq), nEndSeq(firstSeq),
+  pBlockSeg(0), iBlock(-1), bStop(false)
+{
+  bFailed.store(false);
+  QDir().mkpath(sDir);
+  sPrefix = QString("qsnap_log_%1_%2")
+    .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"))
+    .arg((qulonglong)(quintptr)this, 0, 16);
+
+  writer = std::thread(&QSnpLogSpill::writerLoop, this);
+}
+
+QSnpLogSpill::~QSnpLogSpill(void)
+{
+  // поток записи дописывает накопленные данные и завершается
+  {
+    std::lock_guard<std::mutex> lk(mut);
+    bStop = true;
+  }
+  cond.notify_one();
+  writer.join();
+
+  while(!mapped.isEmpty())
+    unmapSegment(mapped.first());
+  for(size_t i = 0; i < segments.size(); i++)
+    delete segments[i];
+}
+
+void QSnpLogSpill::startSegment()
+{
+  QSnpSpillSegment* pSeg = new QSnpSpillSegment;
+  pSeg->sPath = QString("%1/%2_%3.log").arg(sDir).arg(sPrefix).arg(nSegmentNumber++, 4, 10, QChar('0'));
+  pSeg->firstSeq = nEndSeq;
+  segments.push_back(pSeg);
+}
+
+void QSnpLogSpill::append(const QByteArray& line)
+{
+  if(segments.empty() || segments.back()->nBytes >= nSegmentBytes)
+    startSegment();
+  QSnpSpillSegment* pSeg = segments.back();
+
+  if(pSeg->nLines % QSNP_SPILL_INDEX_STEP == 0)
+    pSeg->index.push_back(pSeg->nBytes);
+  pSeg->nLines++;
+  pSeg->nBytes += line.size() + 1;
+  nEndSeq++;
+
+  // последний блок сегмента в кэше устаревает
+  if(pBlockSeg == pSeg && iBlock == pSeg->index.size() - 1)
+    pBlockSeg = 0;
+
+  bool bNotify = false;
+  {
+    std::lock_guard<std::mutex> lk(mut);
+    pSeg->pending.append(line.constData(), line.size());
+    pSeg->pending += '\n';
+    if(!pSeg->bQueued)
+    {
+      pSeg->bQueued = true;
+      queueWrite.push_back(pSeg);
+      bNotify = true;
+    }
+  }
+  if(bNotify)
+    cond.notify_one();
+}
+
+QByteArray QSnpLogSpill::line(qint64 seq)
+{
+  if(seq < nFirstSeq || seq >= nEndSeq)
+    return QByteArray();
+
+  // сегмент строки: последний с firstSeq <= seq
+  size_t lo = 0, hi = segments.size();
+  while(hi - lo > 1)
+  {
+    size_t mid = (lo + hi)/2;
+    if(segments[mid]->firstSeq <= seq)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  QSnpSpillSegment* pSeg = segments[lo];
+  int k = int(seq - pSeg->firstSeq);
+
+  int iBlockLine = k / QSNP_SPILL_INDEX_STEP;
+  if(pBlockSeg != pSeg || iBlock != iBlockLine)
+    readBlock(pSeg, iBlockLine);
+  int iLine = k % QSNP_SPILL_INDEX_STEP;
+  return iLine < blockLines.size() ? blockLines[iLine] : QByteArray();
+}
+
+void QSnpLogSpill::readBlock(QSnpSpillSegment* pSeg, int _iBlock)
+{
+  qint64 offset = pSeg->index[_iBlock];
+  qint64 offsetEnd = _iBlock + 1 < pSeg->index.size() ? pSeg->index[_iBlock + 1] : pSeg->nBytes;
+
+  QByteArray data;
+  readBytes(pSeg, offset, offsetEnd - offset, data);
+
+  blockLines.clear();
+  int pos = 0;
+  for(;;)
+  {
+    int posEnd = data.indexOf('\n', pos);
+    if(posEnd < 0)
+      break;
+    blockLines.push_back(data.mid(pos, posEnd - pos));
+    pos = posEnd + 1;
+  }
+  pBlockSeg = pSeg;
+  iBlock = _iBlock;
+}
+
+void QSnpLogSpill::readBytes(QSnpSpillSegment* pSeg, qint64 offset, qint64 len, QByteArray& out)
+{
+  out.resize(int(len));
+
+  // незаписанная часть - из буферов записи; nWritten только растет, поэтому
+  // все, что было записано к моменту чтения буферов, читается из файла
+  qint64 nWritten;
+  {
+    std::lock_guard<std::mutex> lk(mut);
+    nWritten = pSeg->nWritten;
+    qint64 pos = qMax(offset, nWritten);
+    qint64 nInFlight = (qint64)pSeg->inFlight.size();
+    for(; pos < offset + len; pos++)
+    {
+      qint64 posBuffer = pos - nWritten;
+      out[int(pos - offset)] = posBuffer < nInFlight ?
+        pSeg->inFlight[size_t(posBuffer)] : pSeg->pending[size_t(posBuffer - nInFlight)];
+    }
+  }
+
+  // записанная часть - через отображение файла
+  if(offset < nWritten)
+  {
+    qint64 n = qMin(len, nWritten - offset);
+    if(!mapSegment(pSeg, offset + n))
+    {
+      out.clear();
+      return;
+    }
+    memcpy(out.data(), pSeg->pMap + offset, size_t(n));
+  }
+}
+
+bool QSnpLogSpill::mapSegment(QSnpSpillSegment* pSeg, qint64 offsetEnd)
+{
+  if(pSeg->pMap && pSeg->nMapped >= offsetEnd)
+  {
+    mapped.removeOne(pSeg);
+    mapped.push_back(pSeg);
+    return true;
+  }
+
+  // файл дописан после отображения: отображение обновляется
+  unmapSegment(pSeg);
+  pSeg->pFile = new QFile(pSeg->sPath);
+  if(!pSeg->pFile->open(QIODevice::ReadOnly) || pSeg->pFile->size() < offsetEnd)
+  {
+    unmapSegment(pSeg);
+    return false;
+  }
+  pSeg->nMapped = pSeg->pFile->size();
+  pSeg->pMap = pSeg->pFile->map(0, pSeg->nMapped);
+  if(!pSeg->pMap)
+  {
+    unmapSegment(pSeg);
+    return false;
+  }
+
+  mapped.push_back(pSeg);
+  while(mapped.size() > QSNP_SPILL_MAPPED)
+    unmapSegment(mapped.first());
+  return true;
+}
+
+void QSnpLogSpill::unmapSegment(QSnpSpillSegment* pSeg)
+{
+  mapped.removeOne(pSeg);
+  if(!pSeg->pFile)
+    return;
+  if(pSeg->pMap)
+    pSeg->pFile->unmap(pSeg->pMap);
+  delete pSeg->pFile;
+  pSeg->pFile = 0;
+  pSeg->pMap = 0;
+  pSeg->nMapped = 0;
+}
+
+void QSnpLogSpill::releaseSegment(QSnpSpillSegment* pSeg, bool bRemoveFile)
+{
+  unmapSegment(pSeg);
+  if(pBlockSeg == pSeg)
+    pBlockSeg = 0;
+
+  // сегмент освобождается потоком записи после записи накопленных данных;
+  // при удалении файла незаписанные данные не нужны
+  std::lock_guard<std::mutex> lk(mut);
+  pSeg->bDropped = true;
+  pSeg->bRemove = bRemoveFile;
+  if(bRemoveFile)
+    pSeg->pending.clear();
+  if(!pSeg->bQueued)
+  {
+    pSeg->bQueued = true;
+    queueWrite.push_back(pSeg);
+  }
+}
+
+void QSnpLogSpill::dropOldestSegment()
+{
+  if(segments.empty())
+    return;
+  QSnpSpillSegment* pSeg = segments.front();
+  segments.pop_front();
+  nFirstSeq = segments.empty() ? nEndSeq : segments.front()->firstSeq;
+
+  releaseSegment(pSeg, true);
+  cond.notify_one();
+}
+
+void QSnpLogSpill::forget(qint64 seq)
+{
+  for(size_t i = 0; i < segments.size(); i++)
+    releaseSegment(segments[i], true);
+  segments.clear();
+  nFirstSeq = nEndSeq = seq;
+  cond.notify_one();
+}
+
+QString QSnpLogSpill::errorString()
+{
+  std::lock_guard<std::mutex> lk(mut);
+  return sError;
+}
+
+void QSnpLogSpill::writerLoop()
+{
+  QFile fileWrite;
+  std::unique_lock<std::mutex> lk(mut);
+  for(;;)
+  {
+    cond.wait(lk, [this]{ return bStop || !queueWrite.empty(); });
+
+    while(!queueWrite.empty())
+    {
+      QSnpSpillSegment* pSeg = queueWrite.front();
+      queueWrite.pop_front();
+      pSeg->bQueued = false;
+      bool bDropped = pSeg->bDropped;
+
+      // после ошибки данные не пишутся и остаются в буферах (строки читаются из памяти),
+      // освобождаются только удаленные из лога сегменты
+      if(bFailed.load())
+      {
+        if(bDropped)
+        {
+          lk.unlock();
+          if(pSeg->bRemove)
+            QFile::remove(pSeg->sPath);
+          lk.lock();
+          delete pSeg;
+        }
+        continue;
+      }
+      pSeg->inFlight.swap(pSeg->pending);
+
+      // запись выполняется без блокировки, inFlight в это время только читается
+      lk.unlock();
+      bool bWritten = true;
+      QString sWriteError;
+      if(!pSeg->inFlight.empty())
+      {
+        if(fileWrite.fileName() != pSeg->sPath || !fileWrite.isOpen())
+        {
+          fileWrite.close();
+          fileWrite.setFileName(pSeg->sPath);
+          bWritten = fileWrite.open(QIODevice::WriteOnly | QIODevice::Append);
+        }
+        if(bWritten)
+          bWritten = fileWrite.write(pSeg->inFlight.data(), pSeg->inFlight.size()) == (qint64)pSeg->inFlight.size() &&
+            fileWrite.flush();
+        if(!bWritten)
+        {
+          sWriteError = QString("%1: %2").arg(pSeg->sPath).arg(fileWrite.errorString());
+          fileWrite.close();
+          fileWrite.setFileName(QString());
+        }
+      }
+      if(bDropped && pSeg->bRemove)
+      {
+        if(fileWrite.fileName() == pSeg->sPath)
+        {
+          fileWrite.close();
+          fileWrite.setFileName(QString());
+        }
+        QFile::remove(pSeg->sPath);
+      }
+      lk.lock();
+
+      // незаписанные данные остаются в inFlight, nWritten не меняется
+      if(!bWritten)
+      {
+        sError = sWriteError;
+        bFailed.store(true);
+        if(bDropped)
+          delete pSeg;
+        continue;
+      }
+      pSeg->nWritten += pSeg->inFlight.size();
+      pSeg->inFlight.clear();
+
+      // удаленный из лога сегмент больше не читается и не попадет в очередь
+      if(bDropped)
+        delete pSeg;
+    }
+
+    if(bStop)
+      break;
+  }
+}
@@ -0,0 +1,156 @@
+/**
+  \file   QSnpLogSpill.h
+  \brief  Memory-mapped segment files keeping text Log lines evicted from memory
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QList>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class QFile;
+
+// размер сегмента по умолчанию
+#define QSNP_SPILL_SEGMENT_BYTES  (64*1024*1024)
+
+// шаг разреженного индекса строк сегмента
+#define QSNP_SPILL_INDEX_STEP     256
+
+// количество одновременно отображенных в память сегментов
+#define QSNP_SPILL_MAPPED         4
+
+// сегмент файла выгрузки
+struct QSnpSpillSegment
+{
+  QString         sPath;                // путь к файлу
+  qint64          firstSeq;             // сквозной номер первой строки
+  int             nLines;               // количество строк
+  qint64          nBytes;               // размер с учетом еще не записанных данных
+  QVector<qint64> index;                // смещения строк с шагом QSNP_SPILL_INDEX_STEP
+
+  // данные записи (под блокировкой QSnpLogSpill::mut)
+  qint64          nWritten;             // записано в файл
+  std::string     inFlight;             // записывается сейчас, следует за nWritten
+  std::string     pending;              // ожидает записи, следует за inFlight
+  bool            bQueued;              // сегмент в очереди записи
+  bool            bDropped;             // сегмент удален из лога, освобождается потоком записи
+  bool            bRemove;              // при освобождении удалить файл
+
+  // отображение для чтения (поток окна)
+  QFile*          pFile;                // файл, открытый для отображения
+  uchar*          pMap;                 // отображенная часть файла
+  qint64          nMapped;              // размер отображенной части
+
+  QSnpSpillSegment() : firstSeq(0), nLines(0), nBytes(0), nWritten(0), bQueued(false),
+    bDropped(false), bRemove(false), pFile(0), pMap(0), nMapped(0) {}
+};
+
+///////////////////////////////////////////////////////////
+////  Выгрузка вытесненных строк лога в файлы-сегменты.
+////  Строки добавляются в поток окна и сразу доступны для чтения;
+////  запись в файлы выполняет фоновый поток. Старые строки читаются
+////  через отображение файла в память: по разреженному индексу
+////  находится блок строк, последний прочитанный блок кэшируется,
+////  поэтому прокрутка не требует чтения файла на каждую строку.
+////  При превышении количества сегментов старые сегменты удаляются.
+////  После ошибки открытия или записи файла запись прекращается,
+////  незаписанные строки остаются в буферах до выключения выгрузки
+
+class QSnpLogSpill
+{
+public:
+  QSnpLogSpill(
+    const QString&  sDir,               // [in] каталог файлов
+    qint64          segmentBytes,       // [in] размер сегмента (0 - по умолчанию)
+    int             maxSegments,        // [in] максимальное количество сегментов (0 - без ограничения)
+    qint64          firstSeq            // [in] сквозной номер первой выгружаемой строки
+    );
+  ~QSnpLogSpill(void);
+
+  /// добавление строки (без '\n'), строке присваивается номер endSeq()
+  void append(const QByteArray& line);
+
+  /// строка по сквозному номеру из [firstSeq(), endSeq())
+  QByteArray line(qint64 seq);
+
+  /// сквозной номер первой строки
+  qint64 firstSeq() const { return nFirstSeq; }
+
+  /// сквозной номер, следующий за последней строкой
+  qint64 endSeq() const { return nEndSeq; }
+
+  /// количество сегментов превышает ограничение
+  bool overLimit() const { return nMaxSegments > 0 && int(segments.size()) > nMaxSegments; }
+
+  /// количество строк самого старого сегмента
+  int oldestSegmentLines() const { return segments.empty() ? 0 : segments.front()->nLines; }
+
+  /// удаление самого старого сегмента вместе с файлом
+  void dropOldestSegment();
+
+  /// удаление всех строк вместе с файлами, следующая строка получит номер seq
+  void forget(qint64 seq);
+
+  /// запись прекращена ошибкой файла
+  bool failed() const { return bFailed.load(); }
+
+  /// описание ошибки записи
+  QString errorString();
+
+protected:
+  // начало нового сегмента
+  void startSegment();
+
+  // чтение блока строк сегмента, начинающегося со строки индекса iBlock
+  void readBlock(QSnpSpillSegment* pSeg, int iBlock);
+
+  // байты сегмента [offset, offset+len) из файла и буферов записи
+  void readBytes(QSnpSpillSegment* pSeg, qint64 offset, qint64 len, QByteArray& out);
+
+  // отображение файла сегмента не менее чем до offsetEnd
+  bool mapSegment(QSnpSpillSegment* pSeg, qint64 offsetEnd);
+  void unmapSegment(QSnpSpillSegment* pSeg);
+
+  // передача сегмента потоку записи для освобождения
+  void releaseSegment(QSnpSpillSegment* pSeg, bool bRemoveFile);
+
+  // фоновый поток записи
+  void writerLoop();
+
+protected:
+  QString   sDir;                       // каталог файлов
+  QString   sPrefix;                    // начало имени файлов
+  qint64    nSegmentBytes;              // размер сегмента
+  int       nMaxSegments;               // максимальное количество сегментов
+  int       nSegmentNumber;             // номер следующего сегмента в имени файла
+
+  qint64    nFirstSeq;                  // номер первой строки
+  qint64    nEndSeq;                    // номер за последней строкой
+  std::deque<QSnpSpillSegment*> segments;   // сегменты по возрастанию номеров строк
+  QList<QSnpSpillSegment*> mapped;          // отображенные сегменты, последний - недавно использованный
+
+  // кэш последнего прочитанного блока
+  QSnpSpillSegment* pBlockSeg;          // сегмент блока
+  int       iBlock;                     // номер блока в индексе сегмента
+  QVector<QByteArray> blockLines;       // строки блока
+
+  // фоновая запись
+  std::mutex                mut;        // блокировка буферов записи и очереди
+  std::condition_variable   cond;       // появление работы для потока записи
+  std::deque<QSnpSpillSegment*> queueWrite;  // сегменты с данными для записи или освобождения
+  bool                      bStop;      // завершение потока
+  std::atomic_bool          bFailed;    // ошибка записи, запись прекращена
+  QString                   sError;     // описание ошибки записи (под блокировкой mut)
+  std::thread               writer;     // поток записи
+};
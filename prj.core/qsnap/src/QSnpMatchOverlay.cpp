@@ -0,0 +1,140 @@
+/**
+  \file   QSnpMatchOverlay.cpp
+  \brief  Class function members for the cross-pane match overlay of QSnpSyncImageView
+  \author Sholomov D.
+  \date   05.8.2013
+*/
+
+#include "QSnpMatchOverlay.h"
+#include "QSnpImageWidget.h"
+
+#include <QEvent>
+#include <QPainter>
+
+#include <algorithm>
+
+static bool scoreGreater(const QSnpMatch& a, const QSnpMatch& b)
+{
+  return a.score > b.score;
+}
+
+QSnpMatchOverlay::QSnpMatchOverlay(
+    QWidget*          pParent,          // [in] рамка окна (оверлей занимает ее целиком)
+    QWidget*          _pClip,           // [in] область отсечения (сплиттер окон)
+    QSnpImageWidget*  pFrom,            // [in] первое окно
+    QSnpImageWidget*  pTo               // [in] второе окно
+    ) :
+  QWidget(pParent), nVisible(0), fThreshold(0), lineWidth(1), pClip(_pClip), pwFrom(pFrom), pwTo(pTo)
+{
+  setAttribute(Qt::WA_TransparentForMouseEvents);
+  setAttribute(Qt::WA_NoSystemBackground);
+  setGeometry(pParent->rect());
+
+  // окна сдвигаются при прокрутке и меняют размер при масштабировании
+  pParent->installEventFilter(this);
+  pFrom->installEventFilter(this);
+  pTo->installEventFilter(this);
+}
+
+QSnpMatchOverlay::~QSnpMatchOverlay(void)
+{
+}
+
+void QSnpMatchOverlay::setMatches(const QVector<QSnpMatch>& _matches, int _lineWidth)
+{
+  matches = _matches;
+  std::stable_sort(matches.begin(), matches.end(), scoreGreater);
+  lineWidth = qMax(_lineWidth, 1);
+  updateVisible();
+  raise();
+  update();
+}
+
+void QSnpMatchOverlay::setThreshold(float threshold)
+{
+  fThreshold = threshold;
+  int nVisiblePrev = nVisible;
+  updateVisible();
+  if(nVisible != nVisiblePrev)
+    update();
+}
+
+int QSnpMatchOverlay::thresholdPos(float threshold) const
+{
+  if(matches.isEmpty())
+    return 0;
+  float maxScore = matches.first().score, minScore = matches.last().score;
+  if(maxScore <= minScore)
+    return 0;
+  return qBound(0, int((threshold - minScore)/(maxScore - minScore)*QSNP_MATCH_SLIDER_STEPS + 0.5), QSNP_MATCH_SLIDER_STEPS);
+}
+
+void QSnpMatchOverlay::setThresholdPos(int pos)
+{
+  if(matches.isEmpty())
+    return;
+  float maxScore = matches.first().score, minScore = matches.last().score;
+  setThreshold(minScore + (maxScore - minScore)*pos/QSNP_MATCH_SLIDER_STEPS);
+}
+
+void QSnpMatchOverlay::updateVisible()
+{
+  // первое соответствие с оценкой ниже порога: в префиксе оценки >= порога
+  QSnpMatch key;
+  key.score = fThreshold;
+  nVisible = int(std::upper_bound(matches.begin(), matches.end(), key, scoreGreater) - matches.begin());
+}
+
+void QSnpMatchOverlay::paintEvent(QPaintEvent* ev)
+{
+  if(nVisible == 0 || !pwFrom || !pwTo || !parentWidget())
+    return;
+
+  QPainter painter(this);
+  if(pClip)
+    painter.setClipRect(pClip->geometry());
+  painter.setRenderHint(QPainter::Antialiasing, true);
+
+  // начало координат окон в координатах рамки (оверлей совпадает с рамкой)
+  QPointF orgFrom = pwFrom->mapTo(parentWidget(), QPoint(0, 0));
+  QPointF orgTo = pwTo->mapTo(parentWidget(), QPoint(0, 0));
+  float ratioFrom = pwFrom->getRatio();
+  float ratioTo = pwTo->getRatio();
+
+  // подряд идущие линии одного цвета выводятся одним вызовом
+  QVector<QLineF> lines;
+  lines.reserve(nVisible);
+  QRgb colorRun = matches[0].color;
+  for(int i = 0; i <= nVisible; i++)
+  {
+    if(i == nVisible || matches[i].color != colorRun)
+    {
+      painter.setPen(QPen(QColor::fromRgba(colorRun), lineWidth));
+      painter.drawLines(lines);
+      lines.resize(0);
+      if(i == nVisible)
+        break;
+      colorRun = matches[i].color;
+    }
+
+    const QSnpMatch& m = matches[i];
+    lines.push_back(QLineF(
+      orgFrom + QPointF(m.ptFrom.x() + 0.5, m.ptFrom.y() + 0.5)*ratioFrom,
+      orgTo + QPointF(m.ptTo.x() + 0.5, m.ptTo.y() + 0.5)*ratioTo));
+  }
+}
+
+bool QSnpMatchOverlay::eventFilter(QObject* pObject, QEvent* ev)
+{
+  if(ev->type() == QEvent::Resize || ev->type() == QEvent::Move)
+  {
+    if(pObject == parentWidget())
+    {
+      setGeometry(parentWidget()->rect());
+      raise();
+    }
+    if(!matches.isEmpty())
+      update();
+  }
+  return QWidget::eventFilter(pObject, ev);
+}
@@ -0,0 +1,86 @@
+/**
+  \file   QSnpMatchOverlay.h
+  \brief  Transparent widget drawing matches across the panes of QSnpSyncImageView
+  \author Sholomov D.
+  \date   05.8.2013
+*/
+
+#pragma once
+
+#include <QWidget>
+#include <QVector>
+#include <QPointer>
+
+class QSnpImageWidget;
+
+// количество шагов ползунка порога оценки
+#define QSNP_MATCH_SLIDER_STEPS  1000
+
+// соответствие точек двух окон
+struct QSnpMatch
+{
+  QPoint    ptFrom;                     // точка первого окна (координаты изображения)
+  QPoint    ptTo;                       // точка второго окна (координаты изображения)
+  QRgb      color;                      // цвет линии
+  float     score;                      // оценка соответствия
+};
+
+///////////////////////////////////////////////////////////
+////  Прозрачный виджет поверх окон QSnpSyncImageView: линии
+////  соответствий рисуются за один проход в координатах рамки.
+////  Соответствия хранятся по убыванию оценки, поэтому отсечение
+////  по порогу - поиск длины видимого префикса, без перестроения
+
+class QSnpMatchOverlay : public QWidget
+{
+  Q_OBJECT
+public:
+  QSnpMatchOverlay(
+    QWidget*          pParent,          // [in] рамка окна (оверлей занимает ее целиком)
+    QWidget*          pClip,            // [in] область отсечения (сплиттер окон)
+    QSnpImageWidget*  pFrom,            // [in] первое окно
+    QSnpImageWidget*  pTo               // [in] второе окно
+    );
+  virtual ~QSnpMatchOverlay(void);
+
+  // установка соответствий (сортируются по убыванию оценки)
+  void setMatches(const QVector<QSnpMatch>& matches, int lineWidth);
+
+  // установка порога оценки
+  void setThreshold(float threshold);
+
+  // порог оценки
+  float threshold() const { return fThreshold; }
+
+  // положение ползунка для порога
+  int thresholdPos(float threshold) const;
+
+  // количество соответствий
+  int count() const { return matches.size(); }
+
+  // количество соответствий выше порога
+  int visibleCount() const { return nVisible; }
+
+public slots:
+  // установка порога по положению ползунка 0..QSNP_MATCH_SLIDER_STEPS
+  void setThresholdPos(int pos);
+
+protected:
+  virtual void paintEvent(QPaintEvent* ev);
+
+  // слежение за прокруткой, масштабом и размером окон
+  virtual bool eventFilter(QObject* pObject, QEvent* ev);
+
+  // пересчет количества видимых соответствий
+  void updateVisible();
+
+protected:
+  QVector<QSnpMatch> matches;           // соответствия по убыванию оценки
+  int       nVisible;                   // длина видимого префикса matches
+  float     fThreshold;                 // порог оценки
+  int       lineWidth;                  // толщина линий
+
+  QPointer<QWidget>         pClip;
+  QPointer<QSnpImageWidget> pwFrom;
+  QPointer<QSnpImageWidget> pwTo;
+};
@@ -7,11 +7,73 @@
 
 #include "QSnpNode.h"
 #include "QSnpInstance.h"
+#include "QSnpTreeModel.h"
 
 #include <QSettings>
 
 using namespace QSnp;
 
+QSNP_IMPLEMENT_POOLED(QSnpNode)
+
+/////////////////////////////////////////////////////////////////
+////  QSnpNodeArena
+
+QSnpNodeArena::QSnpNodeArena(void) : pRegistered(0)
+{
+}
+
+QSnpNodeArena::~QSnpNodeArena(void)
+{
+  foreach(QSnpNode* pNode, vecNodes)
+    delete pNode;
+}
+
+QSnpNode* QSnpNodeArena::create(const char* pId, const char* pCaption)
+{
+  QSnpNode* pNode = new QSnpNode(pId, pCaption);
+  vecNodes.push_back(pNode);
+  pNode->nNumber = vecNodes.size();
+  index(pNode);
+  return pNode;
+}
+
+void QSnpNodeArena::registerNode(QSnpNode* pNode)
+{
+  pRegistered = pNode;
+  index(pNode);
+}
+
+void QSnpNodeArena::index(QSnpNode* pNode)
+{
+  if(!hashIds.contains(pNode->sId))
+    hashIds.insert(pNode->sId, pNode);
+}
+
+void QSnpNodeArena::rename(QSnpNode* pNode, const QString& sIdOld)
+{
+  if(hashIds.value(sIdOld, 0) == pNode)
+  {
+    // старый id переходит к следующей по порядку добавления вершине с тем же id
+    hashIds.remove(sIdOld);
+    if(pRegistered && pRegistered != pNode && pRegistered->sId == sIdOld)
+      hashIds.insert(sIdOld, pRegistered);
+    else
+    {
+      foreach(QSnpNode* pOther, vecNodes)
+      {
+        if(pOther != pNode && pOther->sId == sIdOld)
+        {
+          hashIds.insert(sIdOld, pOther);
+          break;
+        }
+      }
+    }
+  }
+  index(pNode);
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpNode
 
 QSnpNode::QSnpNode(const char* pId, const char* pCaption)
 {
@@ -21,57 +83,77 @@ QSnpNode::QSnpNode(const char* pId, const char* pCaption)
     sId=pId;
   if(pCaption)
     sCaption=pCaption;
-  pWidgetItem = new QTreeWidgetItem;
   pInstance = NULL;
   bSelected = false;
   bExpanded = false;
+  pParentNode = NULL;
+  pRootNode = NULL;
+  nNumber = 0;
+  nRow = 0;
+  nRowsShown = 0;
+  bShown = false;
+  bDirty = false;
+  state.flags.store(SF_ENABLED);
 }
 
 QSnpNode::~QSnpNode()
 {
-  /*
-  foreach(QSnpNode pl, lstChildNode)
-    pl.~QSnpNode();
-  lstChildNode.clear();
-
-  if(pWidgetItem)
-  {
-    pWidgetItem->parent()->removeChild(pWidgetItem);
-    //delete pWidgetItem;
-    pWidgetItem = NULL;
-  }
-  */
 }
 
 QSnpNode* QSnpNode::addChildNode(NodeInfo& nodeInfo)
 {
-  // создание новой вершины и добавление в список дочерних
-  QSnpNode node(nodeInfo.szId, nodeInfo.szDescription);
-  lstChildNode.push_back(node);
-  QSnpNode* pNode = &lstChildNode.back();
+  // создание новой вершины в хранилище дерева и добавление в список дочерних
+  QSnpNode* pNode = pRootNode->getArena().create(nodeInfo.szId, nodeInfo.szDescription);
+  pNode->pParentNode = this;
+  pNode->pRootNode = pRootNode;
+  pNode->nRow = lstChildNode.size();
+  lstChildNode.push_back(pNode);
   pNode->setInstance(pInstance);
 
-  // сохранение в вершине ссыки на GUI-вершину 
-  QTreeWidgetItem* pcwi = pNode->pWidgetItem;
-  pcwi->setText(0,nodeInfo.szDescription);
+  // окно узнает о новой вершине отложенной вставкой строк
+  QSnpTreeModel* pModel = pRootNode->getModel();
+  if(pModel)
+    pModel->nodeAdded(this);
+
+  return pNode;
+}
 
-  // сохранение в GUI-вершине ссылки на вершинв QSnpNode 
-  QVariant qData((QHandle)pNode);
-  pcwi->setData(0, TID_QNODE_REF, qData);
-  pWidgetItem->addChild(pcwi);
+// окно дерева (0 - окно не создано)
+QSnpTreeWidget* QSnpNode::treeWidget()
+{
+  QSnpTreeView* pView = getInstance() ? getInstance()->getTreeView() : 0;
+  return pView ? pView->getTreeWidget() : 0;
+}
 
-  return &lstChildNode.back();
+void QSnpNode::setId(const char* pId)
+{
+  QString sIdOld = sId;
+  sId = pId;
+  if(pRootNode && sId != sIdOld)
+    pRootNode->getArena().rename(this, sIdOld);
 }
 
-// поиск вершины с данным id (первой попавшейся)
+// поиск вершины с данным id (первой добавленной)
 QSnpNode* QSnpNode::findNode(const char* pId)
 {
-  if(sId == pId)
+  QString sIdFind = pId;
+  if(sId == sIdFind)
     return this;
 
-  for(QList<QSnpNode>::iterator i = lstChildNode.begin(); i!=lstChildNode.end(); i++)
+  // поиск по индексу хранилища; вершина должна лежать в поддереве этой вершины
+  QSnpNode* pNode = pRootNode ? pRootNode->getArena().find(sIdFind) : 0;
+  if(!pNode)
+    return 0;
+  for(QSnpNode* p = pNode; p; p = p->pParentNode)
   {
-    QSnpNode* pNode = (*i).findNode(pId);
+    if(p == this)
+      return pNode;
+  }
+
+  // в индексе вершина из другого поддерева: обход поддерева
+  for(QList<QSnpNode*>::iterator i = lstChildNode.begin(); i!=lstChildNode.end(); i++)
+  {
+    pNode = (*i)->findNode(pId);
     if(pNode)
       return pNode;
   }
@@ -81,13 +163,15 @@ QSnpNode* QSnpNode::findNode(const char* pId)
 void QSnpNode::setSelected(bool _bSelected)
 { 
   bSelected = _bSelected;
+  state.set(SF_CHECKED, bSelected);
 }
 
 void QSnpNode::setExpanded(bool _bExpanded)
 { 
   bExpanded = _bExpanded; 
-  if(pWidgetItem)
-    pWidgetItem->setExpanded(bExpanded); 
+  QSnpTreeWidget* pWidget = treeWidget();
+  if(pWidget)
+    pWidget->applyExpanded(this);
 }
 
 
@@ -103,17 +187,18 @@ void QSnpNode::loadState(bool bChildren)
   bExpanded = sett.value(QString("expanded")).toBool();
   sett.endGroup();
 
-  setSelected(bSelected);
-  QSnpTreeView* pView = getInstance() ? getInstance()->getTreeView() : 0;
-  if(pView && pView->getTreeWidget())
-    pView->getTreeWidget()->selectItem(pWidgetItem, bSelected, false);
+  QSnpTreeWidget* pWidget = treeWidget();
+  if(pWidget)
+    pWidget->selectNode(this, bSelected, false);
+  else
+    setSelected(bSelected);
 
   setExpanded(bExpanded);
 
   if(bChildren)
   {
-    for(QList<QSnpNode>::iterator it=lstChildNode.begin(); it!=lstChildNode.end(); it++)
-      it->loadState(bChildren);
+    for(QList<QSnpNode*>::iterator it=lstChildNode.begin(); it!=lstChildNode.end(); it++)
+      (*it)->loadState(bChildren);
   }
 }
 
@@ -131,7 +216,7 @@ void QSnpNode::saveState(bool bChildren)
 
   if(bChildren)
   {
-    for(QList<QSnpNode>::iterator it=lstChildNode.begin(); it!=lstChildNode.end(); it++)
-      it->saveState(bChildren);
+    for(QList<QSnpNode*>::iterator it=lstChildNode.begin(); it!=lstChildNode.end(); it++)
+      (*it)->saveState(bChildren);
   }
 }
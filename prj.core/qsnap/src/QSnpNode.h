@@ -9,13 +9,64 @@
 
 #include <qsnap/qsnap.h>
 
+#include "QSnpPool.h"
+#include "QSnpPropertyStore.h"
+
 #include <QString>
 #include <QList>
 #include <QVector>
-#include <QTreeWidget>
+#include <QHash>
 
 class QSnpInstance;
 class QSnpRootNode;
+class QSnpNode;
+class QSnpTreeModel;
+class QSnpTreeWidget;
+
+///////////////////////////////////////////////////////////
+////  Хранилище вершин дерева снепа.
+////  Вершины создаются по одной в пуле блоков QSnpNode и не перемещаются
+////  до разрушения дерева, поэтому указатель (хэндл) вершины остается
+////  действительным при любом количестве вершин. Каждая вершина получает
+////  постоянный номер; индекс по текстовому id дает поиск за O(1)
+
+class QSnpNodeArena
+{
+public:
+  QSnpNodeArena(void);
+  ~QSnpNodeArena(void);
+
+  /// создание вершины, принадлежащей хранилищу
+  QSnpNode* create(const char* pId, const char* pCaption);
+
+  /// включение в индекс вершины, созданной вне хранилища (корневой)
+  void registerNode(QSnpNode* pNode);
+
+  /// вершина по постоянному номеру (0 - нет такой)
+  QSnpNode* node(int nNumber) const { return nNumber > 0 && nNumber <= vecNodes.size() ? vecNodes[nNumber-1] : 0; }
+
+  /// первая добавленная вершина с данным id (0 - нет такой)
+  QSnpNode* find(const QString& sId) const { return hashIds.value(sId, 0); }
+
+  /// обновление индекса при смене id вершины
+  void rename(QSnpNode* pNode, const QString& sIdOld);
+
+  /// количество созданных вершин
+  int count() const { return vecNodes.size(); }
+
+protected:
+  // добавление вершины в индекс, если вершины с таким id еще нет
+  void index(QSnpNode* pNode);
+
+protected:
+  QVector<QSnpNode*>        vecNodes;   // созданные вершины по номерам (номер = позиция + 1)
+  QHash<QString, QSnpNode*> hashIds;    // первая вершина с данным id
+  QSnpNode*                 pRegistered;// вершина, зарегистрированная вне хранилища
+
+private:
+  QSnpNodeArena(const QSnpNodeArena&);
+  QSnpNodeArena& operator=(const QSnpNodeArena&);
+};
 
 class QSnpNode
 {
@@ -32,21 +83,23 @@ public:
   // добавление дочерней вершины
   QSnpNode* addChildNode(QSnp::NodeInfo& nodeInfo);
   
-  // получение/установка виджета древа снепа
-  QTreeWidgetItem* getTreeWidgetItem() { return pWidgetItem; }
-  void setTreeWidgetItem(QTreeWidgetItem* _pWidgetItem) { pWidgetItem=_pWidgetItem; }
-
   // информация о селекции
   bool isSelected() { return bSelected; }
   void setSelected(bool _bSelected);
+
+  // состояние вершины, публикуемое для чтения без вызова библиотеки
+  const QSnp::SnapState* getState() const { return &state; }
  
   // информация о раскрытии
-  bool isExpanded() { return pWidgetItem ? pWidgetItem->isExpanded() : false; }
+  bool isExpanded() { return bExpanded; }
   void setExpanded(bool _bExpanded);
 
+  // отметка о раскрытии в окне (без изменения окна)
+  void setExpandedFlag(bool _bExpanded) { bExpanded = _bExpanded; }
+
   // получение/установка ID вершины
   QString id() { return sId; }
-  void setId(const char* pId) { sId = pId; }
+  void setId(const char* pId);
 
   // получение/установка заголовка
   QString caption() { return sCaption; }
@@ -55,7 +108,17 @@ public:
   // хэндл вершины
   QHandle handle() { return (QHandle)this; }
 
-  // поиск вершины с данным id (первой попавшейся)
+  // постоянный номер вершины в хранилище дерева (0 - корневая)
+  int number() { return nNumber; }
+
+  // родительская вершина (0 - корневая)
+  QSnpNode* parentNode() { return pParentNode; }
+
+  // дочерние вершины
+  int childCount() { return lstChildNode.size(); }
+  QSnpNode* childNode(int nChild) { return lstChildNode[nChild]; }
+
+  // поиск вершины с данным id (первой добавленной)
   QSnpNode* findNode(const char* pId);
 
   // загрузка состояния вершины
@@ -64,8 +127,11 @@ public:
   // сохранение состояния вершины
   void saveState(bool bChildren = false);
 
+  // вершины размещаются в пуле блоков и не перемещаются
+  QSNP_DECLARE_POOLED(QSnpNode)
+
 public: // Node Properties
-  QVector<QSnp::NodePropertyInfo> vProperties;
+  QSnpPropertyStore properties;
 
 protected:
   QString sId;
@@ -73,13 +139,31 @@ protected:
   bool bSelected;
   bool bExpanded;
 
-  QList<QSnpNode> lstChildNode;
-  QSnpRootNode* pRootNode;
+  QList<QSnpNode*> lstChildNode;        // дочерние вершины (принадлежат хранилищу дерева)
+  QSnpNode* pParentNode;                // родительская вершина
+  QSnpRootNode* pRootNode;              // корневая вершина дерева (хранилище вершин)
+  int nNumber;                          // постоянный номер в хранилище
+  QSnp::SnapState state;                // опубликованное состояние (копия bSelected)
+
+  // состояние в модели окна (QSnpTreeModel)
+  int nRow;                             // номер в списке детей родителя
+  int nRowsShown;                       // количество показанных окну детей
+  bool bShown;                          // вершина показана окну
+  bool bDirty;                          // есть непоказанные дети (вершина в очереди модели)
+
+  friend class QSnpNodeArena;
+  friend class QSnpTreeModel;
+
+protected:
+  // окно дерева (0 - окно не создано)
+  QSnpTreeWidget* treeWidget();
 
 protected:
   QSnpInstance* pInstance;
-  QTreeWidgetItem* pWidgetItem;
 
+private:
+  QSnpNode(const QSnpNode&);
+  QSnpNode& operator=(const QSnpNode&);
 };
                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                       
 const int TID_QNODE_REF = 15;
@@ -87,6 +171,17 @@ const int TID_QNODE_REF = 15;
 class QSnpRootNode : public QSnpNode
 {
 public:
-  QSnpRootNode() : QSnpNode("Root", "Root") { ; }
+  QSnpRootNode() : QSnpNode("Root", "Root"), pModel(0) { pRootNode = this; arena.registerNode(this); }
   virtual ~QSnpRootNode() { ; }
+
+  // хранилище вершин дерева
+  QSnpNodeArena& getArena() { return arena; }
+
+  // модель окна дерева (0 - окно не создано)
+  QSnpTreeModel* getModel() { return pModel; }
+  void setModel(QSnpTreeModel* _pModel) { pModel = _pModel; }
+
+protected:
+  QSnpNodeArena arena;
+  QSnpTreeModel* pModel;
 };
@@ -0,0 +1,259 @@
+/**
+  \file   QSnpPool.cpp
+  \brief  Class function members for free-list pools of frequently created objects
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpPool.h"
+
+#include <QMutexLocker>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/////////////////////////////////////////////////////////////////
+////  Кэши потоков
+
+// кэш свободных блоков одного пула в потоке
+struct QSnpPoolCache
+{
+  QSnpFreeBlock*  pList;                // свободные блоки
+  int             nBlocks;              // количество блоков
+};
+
+// пулы по номерам кэшей (пулы не разрушаются, поэтому указатели всегда действительны)
+static std::atomic<QSnpFixedPool*> poolsBySlot[QSNP_POOL_CACHE_SLOTS];
+static std::atomic<int> nextSlot(0);
+
+// кэши текущего потока; при завершении потока блоки возвращаются в пулы
+struct QSnpPoolThreadCaches
+{
+  QSnpPoolCache caches[QSNP_POOL_CACHE_SLOTS];
+
+  QSnpPoolThreadCaches()
+  {
+    for(int i = 0; i < QSNP_POOL_CACHE_SLOTS; i++)
+    {
+      caches[i].pList = 0;
+      caches[i].nBlocks = 0;
+    }
+  }
+  ~QSnpPoolThreadCaches()
+  {
+    for(int i = 0; i < QSNP_POOL_CACHE_SLOTS; i++)
+    {
+      QSnpFixedPool* pPool = poolsBySlot[i].load();
+      if(pPool && caches[i].pList)
+        pPool->releaseBatch(caches[i].pList, caches[i].nBlocks);
+      caches[i].pList = 0;
+      caches[i].nBlocks = 0;
+    }
+  }
+};
+
+static thread_local QSnpPoolThreadCaches threadCaches;
+
+/////////////////////////////////////////////////////////////////
+////  QSnpFixedPool
+
+QSnpFixedPool::QSnpFixedPool(size_t _szBlock, int _nBlocksPerPage)
+{
+  // блок вмещает указатель списка свободных и выровнен на 16 байт
+  size_t sz = _szBlock < sizeof(QSnpFreeBlock) ? sizeof(QSnpFreeBlock) : _szBlock;
+  szBlock = (sz + 15) & ~size_t(15);
+  nBlocksPerPage = _nBlocksPerPage > 0 ? _nBlocksPerPage : 1;
+  pFree = 0;
+  nUsed = 0;
+
+  nSlot = nextSlot.fetch_add(1);
+  if(nSlot < QSNP_POOL_CACHE_SLOTS)
+    poolsBySlot[nSlot].store(this);
+  else
+    nSlot = -1;
+}
+
+QSnpFixedPool::~QSnpFixedPool(void)
+{
+  foreach(char* pPage, vecPages)
+    free(pPage);
+}
+
+QSnpFreeBlock* QSnpFixedPool::takeBatch(int nBlocks)
+{
+  QMutexLocker lock(&mutex);
+  QSnpFreeBlock* pList = 0;
+  for(int n = 0; n < nBlocks; n++)
+  {
+    if(!pFree)
+    {
+      // новая страница нарезается на блоки и целиком уходит в список свободных
+      char* pPage = (char*)malloc(szBlock*nBlocksPerPage);
+      if(!pPage)
+      {
+        if(pList)
+          break;
+        throw std::bad_alloc();
+      }
+      vecPages.push_back(pPage);
+      for(int i = nBlocksPerPage-1; i >= 0; i--)
+      {
+        QSnpFreeBlock* pBlock = (QSnpFreeBlock*)(pPage + i*szBlock);
+        pBlock->pNext = pFree;
+        pFree = pBlock;
+      }
+    }
+
+    QSnpFreeBlock* pBlock = pFree;
+    pFree = pBlock->pNext;
+    pBlock->pNext = pList;
+    pList = pBlock;
+    nUsed++;
+  }
+  return pList;
+}
+
+void QSnpFixedPool::releaseBatch(QSnpFreeBlock* pList, int nBlocks)
+{
+  if(!pList)
+    return;
+  QSnpFreeBlock* pLast = pList;
+  while(pLast->pNext)
+    pLast = pLast->pNext;
+
+  QMutexLocker lock(&mutex);
+  pLast->pNext = pFree;
+  pFree = pList;
+  nUsed -= nBlocks;
+}
+
+void* QSnpFixedPool::allocate()
+{
+  if(nSlot < 0)
+    return takeBatch(1);
+
+  // быстрый путь - кэш потока без блокировки
+  QSnpPoolCache& cache = threadCaches.caches[nSlot];
+  if(!cache.pList)
+  {
+    cache.pList = takeBatch(QSNP_POOL_CACHE_BATCH);
+    cache.nBlocks = 0;
+    for(QSnpFreeBlock* pBlock = cache.pList; pBlock; pBlock = pBlock->pNext)
+      cache.nBlocks++;
+  }
+
+  QSnpFreeBlock* pBlock = cache.pList;
+  cache.pList = pBlock->pNext;
+  cache.nBlocks--;
+  return pBlock;
+}
+
+void QSnpFixedPool::release(void* p)
+{
+  if(!p)
+    return;
+  QSnpFreeBlock* pBlock = (QSnpFreeBlock*)p;
+  if(nSlot < 0)
+  {
+    pBlock->pNext = 0;
+    releaseBatch(pBlock, 1);
+    return;
+  }
+
+  QSnpPoolCache& cache = threadCaches.caches[nSlot];
+  pBlock->pNext = cache.pList;
+  cache.pList = pBlock;
+  cache.nBlocks++;
+
+  // избыток кэша (блоки, выделенные другим потоком) возвращается в общий список
+  if(cache.nBlocks >= 2*QSNP_POOL_CACHE_BATCH)
+  {
+    QSnpFreeBlock* pKeep = cache.pList;
+    for(int i = 1; i < QSNP_POOL_CACHE_BATCH; i++)
+      pKeep = pKeep->pNext;
+    QSnpFreeBlock* pRest = pKeep->pNext;
+    pKeep->pNext = 0;
+    releaseBatch(pRest, cache.nBlocks - QSNP_POOL_CACHE_BATCH);
+    cache.nBlocks = QSNP_POOL_CACHE_BATCH;
+  }
+}
+
+/////////////////////////////////////////////////////////////////
+////  QSnpObjectPool
+
+// заголовок блока (выровнен, чтобы объект за ним остался выровненным на 16 байт)
+union QSnpPoolHeader
+{
+  struct
+  {
+    QSnpFixedPool*  pClassPool;         // пул класса размера (0 - системный аллокатор)
+  } info;
+  char align[QSNP_POOL_GRANULARITY];
+};
+
+// пулы классов размеров, общие для процесса
+static std::atomic<QSnpFixedPool*> classPools[QSNP_POOL_CLASSES];
+static QMutex mutClassPools;
+
+QSnpFixedPool* QSnpObjectPool::classPool(int nClass)
+{
+  QSnpFixedPool* pClassPool = classPools[nClass].load(std::memory_order_acquire);
+  if(pClassPool)
+    return pClassPool;
+
+  QMutexLocker lock(&mutClassPools);
+  pClassPool = classPools[nClass].load(std::memory_order_relaxed);
+  if(!pClassPool)
+  {
+    pClassPool = new QSnpFixedPool((nClass+1)*QSNP_POOL_GRANULARITY);
+    classPools[nClass].store(pClassPool, std::memory_order_release);
+  }
+  return pClassPool;
+}
+
+void* QSnpObjectPool::allocate(size_t sz)
+{
+  size_t szTotal = sz + sizeof(QSnpPoolHeader);
+  QSnpPoolHeader* pHeader = 0;
+  QSnpFixedPool* pClassPool = 0;
+
+  if(szTotal <= QSNP_POOL_MAX_OBJECT)
+  {
+    int nClass = int((szTotal + QSNP_POOL_GRANULARITY - 1)/QSNP_POOL_GRANULARITY) - 1;
+    pClassPool = classPool(nClass);
+    pHeader = (QSnpPoolHeader*)pClassPool->allocate();
+  }
+  else
+  {
+    pHeader = (QSnpPoolHeader*)malloc(szTotal);
+    if(!pHeader)
+      throw std::bad_alloc();
+  }
+
+  pHeader->info.pClassPool = pClassPool;
+  return pHeader + 1;
+}
+
+void QSnpObjectPool::release(void* p)
+{
+  if(!p)
+    return;
+  QSnpPoolHeader* pHeader = (QSnpPoolHeader*)p - 1;
+  if(pHeader->info.pClassPool)
+    pHeader->info.pClassPool->release(pHeader);
+  else
+    free(pHeader);
+}
+
+int QSnpObjectPool::used()
+{
+  int nUsed = 0;
+  for(int i = 0; i < QSNP_POOL_CLASSES; i++)
+  {
+    QSnpFixedPool* pClassPool = classPools[i].load(std::memory_order_acquire);
+    if(pClassPool)
+      nUsed += pClassPool->used();
+  }
+  return nUsed;
+}
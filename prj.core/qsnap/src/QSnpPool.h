@@ -0,0 +1,140 @@
+/**
+  \file   QSnpPool.h
+  \brief  Free-list pools for frequently created objects (figures, nodes, events)
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QVector>
+#include <QMutex>
+
+#include <cstddef>
+
+// количество пулов с кэшами потоков (остальные пулы работают только под блокировкой)
+#define QSNP_POOL_CACHE_SLOTS   64
+// блоков, переносимых между кэшем потока и общим списком за одну блокировку
+#define QSNP_POOL_CACHE_BATCH   32
+
+// свободный блок пула
+struct QSnpFreeBlock
+{
+  QSnpFreeBlock* pNext;
+};
+
+///////////////////////////////////////////////////////////
+////  Пул блоков одного размера.
+////  Память берется страницами, освобожденные блоки идут в список
+////  свободных и переиспользуются без обращения к системному аллокатору.
+////  Каждый поток держит небольшой кэш свободных блоков и обращается к
+////  общему списку под блокировкой только пачками по QSNP_POOL_CACHE_BATCH.
+////  Пул создается через new и не разрушается: блоки могут освобождаться
+////  после выхода из main (статические объекты, завершение потоков)
+
+class QSnpFixedPool
+{
+public:
+  QSnpFixedPool(size_t szBlock, int nBlocksPerPage = 256);
+
+  /// выделение блока
+  void* allocate();
+
+  /// возврат блока в пул
+  void release(void* p);
+
+  /// размер блока
+  size_t blockSize() const { return szBlock; }
+
+  /// количество блоков, выданных из общего списка (включая кэши потоков)
+  int used() const { return nUsed; }
+
+  /// количество выделенных блоков (занятых и свободных)
+  int capacity() const { return vecPages.size()*nBlocksPerPage; }
+
+  /// возврат списка блоков из кэша потока в общий список
+  void releaseBatch(QSnpFreeBlock* pList, int nBlocks);
+
+private:
+  // перенос до nBlocks блоков из общего списка (страницы добавляются по необходимости)
+  QSnpFreeBlock* takeBatch(int nBlocks);
+
+  size_t      szBlock;                  // размер блока (выровненный)
+  int         nBlocksPerPage;           // блоков на странице
+  int         nSlot;                    // номер кэша в потоках (-1 - без кэша)
+  QSnpFreeBlock* pFree;                 // список свободных блоков
+  QVector<char*> vecPages;              // страницы памяти
+  int         nUsed;                    // блоки вне общего списка
+  QMutex      mutex;
+
+  ~QSnpFixedPool(void);
+  QSnpFixedPool(const QSnpFixedPool&);
+  QSnpFixedPool& operator=(const QSnpFixedPool&);
+};
+
+///////////////////////////////////////////////////////////
+////  Общий для процесса аллокатор объектов разного размера (наследники одного класса).
+////  Это не арена окна: блоки раздаются из списков свободных по классам размеров
+////  с шагом QSNP_POOL_GRANULARITY, общих для всех окон и потоков; перед каждым
+////  блоком хранится заголовок с указателем на пул, поэтому освобождение не
+////  требует знать, из какого пула выделен объект. Пулы не разрушаются, память
+////  освобожденных объектов переиспользуется, но системе не возвращается.
+////  Объекты больше QSNP_POOL_MAX_OBJECT выделяются системным аллокатором
+
+#define QSNP_POOL_GRANULARITY   16
+#define QSNP_POOL_MAX_OBJECT    512
+#define QSNP_POOL_CLASSES       (QSNP_POOL_MAX_OBJECT/QSNP_POOL_GRANULARITY)
+
+class QSnpObjectPool
+{
+public:
+  /// выделение памяти под объект
+  static void* allocate(size_t sz);
+
+  /// освобождение памяти, выделенной allocate
+  static void release(void* p);
+
+  /// количество занятых блоков во всех классах размеров
+  static int used();
+
+private:
+  // пул класса размера (создается при первом обращении)
+  static QSnpFixedPool* classPool(int nClass);
+
+  // экземпляры не создаются
+  QSnpObjectPool(void);
+};
+
+///////////////////////////////////////////////////////////
+////  Перенаправление new/delete класса в статический пул блоков.
+////  Используется для объектов, которые Qt-контейнеры (QList) создают
+////  через new T(t), например QSnpNode и QSnpEvent.
+////  Пул намеренно не разрушается: объекты статических контейнеров
+////  освобождаются после разрушения локальных статических переменных
+
+#define QSNP_DECLARE_POOLED(ClassName)                                  \
+  public:                                                               \
+    static void* operator new(size_t sz);                               \
+    static void  operator delete(void* p, size_t sz);
+
+#define QSNP_IMPLEMENT_POOLED(ClassName)                                \
+  static QSnpFixedPool& ClassName##_pool()                              \
+  {                                                                     \
+    static QSnpFixedPool* pPool = new QSnpFixedPool(sizeof(ClassName)); \
+    return *pPool;                                                      \
+  }                                                                     \
+  void* ClassName::operator new(size_t sz)                              \
+  {                                                                     \
+    if(sz != sizeof(ClassName))                                         \
+      return ::operator new(sz);                                        \
+    return ClassName##_pool().allocate();                               \
+  }                                                                     \
+  void ClassName::operator delete(void* p, size_t sz)                   \
+  {                                                                     \
+    if(!p)                                                              \
+      return;                                                           \
+    if(sz != sizeof(ClassName))                                         \
+      ::operator delete(p);                                             \
+    else                                                                \
+      ClassName##_pool().release(p);                                    \
+  }
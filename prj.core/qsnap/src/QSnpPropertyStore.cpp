@@ -0,0 +1,469 @@
+/**
+  \file   QSnpPropertyStore.cpp
+  \brief  Class function members for the typed node property store
+  \author Sholomov D.
+  \date   27.8.2013
+*/
+
+#include "QSnpPropertyStore.h"
+
+#include <QMutexLocker>
+
+#include <cmath>
+#include <cstring>
+
+using namespace QSnp;
+
+///////////////////////////////////////////////////////////
+////  QSnpBindingQueue
+
+QSnpBindingQueue::QSnpBindingQueue(void)
+{
+  bPending.store(false);
+}
+
+QSnpBindingQueue& QSnpBindingQueue::instance()
+{
+  static QSnpBindingQueue queue;
+  return queue;
+}
+
+void QSnpBindingQueue::post(QSnpPropertyStore* pStore)
+{
+  QMutexLocker lock(&mutex);
+  if(pStore->bQueued)
+    return;
+  pStore->bQueued = true;
+  stores.push_back(pStore);
+  bPending.store(true, std::memory_order_release);
+}
+
+void QSnpBindingQueue::cancel(QSnpPropertyStore* pStore)
+{
+  QMutexLocker lock(&mutex);
+  if(!pStore->bQueued)
+    return;
+  pStore->bQueued = false;
+  stores.remove(stores.indexOf(pStore));
+  bPending.store(!stores.isEmpty(), std::memory_order_release);
+}
+
+int QSnpBindingQueue::apply()
+{
+  if(!bPending.load(std::memory_order_acquire))
+    return 0;
+
+  // хранилище блокируется под блокировкой очереди (обратного порядка нет,
+  // см. QSnpPropertyStore::postBindings), поэтому не может быть разрушено во время записи
+  QMutexLocker lock(&mutex);
+  int nApplied = 0;
+  foreach(QSnpPropertyStore* pStore, stores)
+  {
+    pStore->bQueued = false;
+    nApplied += pStore->applyBindings();
+  }
+  stores.clear();
+  bPending.store(false, std::memory_order_release);
+  return nApplied;
+}
+
+///////////////////////////////////////////////////////////
+////  QSnpPropertyStore
+
+QSnpPropertyStore::QSnpPropertyStore(void) : bPost(false), bQueued(false)
+{
+  nVersion.store(0);
+}
+
+QSnpPropertyStore::~QSnpPropertyStore(void)
+{
+  QSnpBindingQueue::instance().cancel(this);
+  foreach(PropValue* pValue, values)
+    delete pValue;
+}
+
+int QSnpPropertyStore::count() const
+{
+  QMutexLocker lock(&mutex);
+  return props.size();
+}
+
+bool QSnpPropertyStore::get(int nProperty, NodePropertyInfo* pInfo) const
+{
+  QMutexLocker lock(&mutex);
+  if(nProperty < 0 || nProperty >= props.size())
+    return false;
+  memset(pInfo, 0, sizeof(NodePropertyInfo));
+  strncpy(pInfo->sKey, props[nProperty].key.constData(), sizeof(pInfo->sKey)-1);
+  strncpy(pInfo->sValue, props[nProperty].text.constData(), sizeof(pInfo->sValue)-1);
+  return true;
+}
+
+bool QSnpPropertyStore::set(int nProperty, const NodePropertyInfo& info)
+{
+  QMutexLocker lock(&mutex);
+  if(nProperty < 0 || nProperty >= props.size())
+    return false;
+
+  QSnpProperty& prop = props[nProperty];
+  QByteArray key(info.sKey);
+  if(key != prop.key)
+  {
+    if(index.value(prop.key, -1) == nProperty)
+      index.remove(prop.key);
+    prop = QSnpProperty();
+    prop.key = key;
+    prop.pValue = valueFor(key);
+    index.insert(key, nProperty);
+  }
+  assign(prop, QByteArray(info.sValue));
+  lock.unlock();
+
+  postBindings();
+  return true;
+}
+
+bool QSnpPropertyStore::value(const char* sKey, QByteArray& text) const
+{
+  QMutexLocker lock(&mutex);
+  int nProperty = index.value(QByteArray(sKey), -1);
+  if(nProperty < 0)
+    return false;
+  text = props[nProperty].text;
+  return true;
+}
+
+bool QSnpPropertyStore::setValue(const char* sKey, const char* sValue)
+{
+  QMutexLocker lock(&mutex);
+  QByteArray key(sKey);
+  int nProperty = index.value(key, -1);
+  bool bExisted = nProperty >= 0;
+  if(!bExisted)
+  {
+    // если свойство не существует, то добавить его
+    QSnpProperty prop;
+    prop.key = key;
+    prop.pValue = valueFor(key);
+    props.push_back(prop);
+    nProperty = props.size()-1;
+    index.insert(key, nProperty);
+  }
+  bool bAssigned = assign(props[nProperty], QByteArray(sValue ? sValue : ""));
+  lock.unlock();
+
+  postBindings();
+  return bExisted && bAssigned;
+}
+
+void QSnpPropertyStore::define(const PropertyDef& def)
+{
+  if(!def.sKey)
+    return;
+
+  QMutexLocker lock(&mutex);
+  QByteArray key(def.sKey);
+  int nProperty = index.value(key, -1);
+  if(nProperty < 0)
+  {
+    QSnpProperty prop;
+    prop.key = key;
+    prop.pValue = valueFor(key);
+    props.push_back(prop);
+    nProperty = props.size()-1;
+    index.insert(key, nProperty);
+  }
+
+  QSnpProperty& prop = props[nProperty];
+  QByteArray textOld = prop.text;
+  prop.type = def.type;
+  prop.dMin = def.dMin;
+  prop.dMax = def.dMax;
+  prop.enumNames = def.type == PROP_ENUM && def.sEnum ? QByteArray(def.sEnum).split('|') : QList<QByteArray>();
+
+  // уже заданное (например, загруженное) значение сохраняется, если подходит к типу
+  if(textOld.isEmpty() || !assign(prop, textOld))
+  {
+    prop.text.clear();
+    if(!assign(prop, QByteArray(def.sDefault ? def.sDefault : "")))
+      assign(prop, QByteArray(prop.type == PROP_ENUM && !prop.enumNames.isEmpty() ? prop.enumNames[0] : "0"));
+  }
+  lock.unlock();
+
+  postBindings();
+}
+
+const PropValue* QSnpPropertyStore::typedValue(const char* sKey)
+{
+  QMutexLocker lock(&mutex);
+  return valueFor(QByteArray(sKey));
+}
+
+void QSnpPropertyStore::remove(const char* sKey)
+{
+  QMutexLocker lock(&mutex);
+  int nProperty = index.value(QByteArray(sKey), -1);
+  if(nProperty < 0)
+    return;
+  props.remove(nProperty);
+  reindex();
+  nVersion.fetch_add(1);
+}
+
+void QSnpPropertyStore::removeAll(bool bKeepDefined)
+{
+  QMutexLocker lock(&mutex);
+  QVector<QSnpProperty> propsNew;
+  if(bKeepDefined)
+  {
+    foreach(const QSnpProperty& prop, props)
+    {
+      if(prop.type != PROP_STRING)
+        propsNew.push_back(prop);
+    }
+  }
+  props.swap(propsNew);
+  reindex();
+  nVersion.fetch_add(1);
+}
+
+PropValue* QSnpPropertyStore::valueFor(const QByteArray& key)
+{
+  PropValue* pValue = values.value(key, 0);
+  if(!pValue)
+  {
+    pValue = new PropValue;
+    pValue->i.store(0);
+    pValue->d.store(0);
+    pValue->version.store(0);
+    values.insert(key, pValue);
+  }
+  return pValue;
+}
+
+void QSnpPropertyStore::reindex()
+{
+  index.clear();
+  for(int i = props.size()-1; i >= 0; i--)
+    index.insert(props[i].key, i);
+}
+
+// разбор логического значения
+static bool parseBool(const QByteArray& text, bool* pOk)
+{
+  QByteArray t = text.trimmed().toLower();
+  *pOk = true;
+  if(t == "1" || t == "true" || t == "yes" || t == "on")
+    return true;
+  if(t == "0" || t == "false" || t == "no" || t == "off")
+    return false;
+  double d = t.toDouble(pOk);
+  return *pOk && d != 0;
+}
+
+bool QSnpPropertyStore::assign(QSnpProperty& prop, const QByteArray& text)
+{
+  bool bOk = true;
+  long long i = 0;
+  double d = 0;
+  QByteArray textNew = text;
+  bool bRange = prop.dMin < prop.dMax;
+
+  switch(prop.type)
+  {
+  case PROP_INT:
+    i = text.trimmed().toLongLong(&bOk);
+    if(!bOk)
+    {
+      d = text.trimmed().toDouble(&bOk);
+      i = (long long)floor(d + 0.5);
+    }
+    if(!bOk)
+      return false;
+    if(bRange)
+      i = (long long)qBound(ceil(prop.dMin), (double)i, floor(prop.dMax));
+    d = (double)i;
+    textNew = QByteArray::number(i);
+    break;
+
+  case PROP_DOUBLE:
+    d = text.trimmed().toDouble(&bOk);
+    if(!bOk)
+      return false;
+    if(bRange)
+      d = qBound(prop.dMin, d, prop.dMax);
+    i = (long long)d;
+    textNew = QByteArray::number(d, 'g', 17);
+    break;
+
+  case PROP_BOOL:
+    i = parseBool(text, &bOk) ? 1 : 0;
+    if(!bOk)
+      return false;
+    d = (double)i;
+    textNew = i ? "true" : "false";
+    break;
+
+  case PROP_ENUM:
+    i = prop.enumNames.indexOf(text.trimmed());
+    if(i < 0)
+    {
+      // номер варианта
+      i = text.trimmed().toLongLong(&bOk);
+      if(!bOk || i < 0 || i >= prop.enumNames.size())
+        return false;
+    }
+    d = (double)i;
+    textNew = prop.enumNames[int(i)];
+    break;
+
+  default:
+    // строка: числовое значение публикуется, если строка - число
+    d = text.trimmed().toDouble(&bOk);
+    if(!bOk)
+      d = 0;
+    i = (long long)d;
+    bOk = true;
+    break;
+  }
+
+  prop.text = textNew;
+  prop.pValue->i.store(i, std::memory_order_relaxed);
+  prop.pValue->d.store(d, std::memory_order_relaxed);
+  prop.pValue->version.fetch_add(1, std::memory_order_release);
+  nVersion.fetch_add(1, std::memory_order_release);
+  notifyBinding(prop);
+  return true;
+}
+
+void QSnpPropertyStore::notifyBinding(const QSnpProperty& prop)
+{
+  if(bindings.isEmpty())
+    return;
+  QHash<QByteArray, QSnpBinding>::iterator it = bindings.find(prop.key);
+  if(it == bindings.end())
+    return;
+
+  switch(it->type)
+  {
+  case BIND_ATOMIC_INT:
+  case BIND_ATOMIC_DOUBLE:
+  case BIND_ATOMIC_BOOL:
+    writeVar(*it, prop.pValue);
+    break;
+  default:
+    it->bPending = true;
+    bPost = true;
+    break;
+  }
+}
+
+void QSnpPropertyStore::writeVar(const QSnpBinding& binding, const PropValue* pValue)
+{
+  switch(binding.type)
+  {
+  case BIND_INT:
+    *(int*)binding.pVar = pValue->toInt();
+    break;
+  case BIND_DOUBLE:
+    *(double*)binding.pVar = pValue->toDouble();
+    break;
+  case BIND_BOOL:
+    *(bool*)binding.pVar = pValue->toBool();
+    break;
+  case BIND_ATOMIC_INT:
+    ((std::atomic<int>*)binding.pVar)->store(pValue->toInt());
+    break;
+  case BIND_ATOMIC_DOUBLE:
+    ((std::atomic<double>*)binding.pVar)->store(pValue->toDouble());
+    break;
+  case BIND_ATOMIC_BOOL:
+    ((std::atomic<bool>*)binding.pVar)->store(pValue->toBool());
+    break;
+  }
+}
+
+void QSnpPropertyStore::postBindings()
+{
+  // блокировка очереди берется без блокировки хранилища
+  QMutexLocker lock(&mutex);
+  bool bPostNow = bPost;
+  bPost = false;
+  lock.unlock();
+
+  if(bPostNow)
+    QSnpBindingQueue::instance().post(this);
+}
+
+void QSnpPropertyStore::bind(const char* sKey, SnpBindType type, void* pVar)
+{
+  if(!sKey)
+    return;
+
+  QMutexLocker lock(&mutex);
+  QByteArray key(sKey);
+  if(!pVar)
+  {
+    bindings.remove(key);
+    return;
+  }
+
+  QSnpBinding binding;
+  binding.type = type;
+  binding.pVar = pVar;
+
+  // тип свойства без описания определяется переменной
+  SnpPropType typeProp = type == BIND_INT || type == BIND_ATOMIC_INT ? PROP_INT :
+                         type == BIND_BOOL || type == BIND_ATOMIC_BOOL ? PROP_BOOL : PROP_DOUBLE;
+  int nProperty = index.value(key, -1);
+  if(nProperty < 0)
+  {
+    // свойство создается со значением переменной
+    QByteArray text;
+    switch(type)
+    {
+    case BIND_INT:            text = QByteArray::number(*(int*)pVar); break;
+    case BIND_DOUBLE:         text = QByteArray::number(*(double*)pVar, 'g', 17); break;
+    case BIND_BOOL:           text = *(bool*)pVar ? "true" : "false"; break;
+    case BIND_ATOMIC_INT:     text = QByteArray::number(((std::atomic<int>*)pVar)->load()); break;
+    case BIND_ATOMIC_DOUBLE:  text = QByteArray::number(((std::atomic<double>*)pVar)->load(), 'g', 17); break;
+    case BIND_ATOMIC_BOOL:    text = ((std::atomic<bool>*)pVar)->load() ? "true" : "false"; break;
+    }
+    QSnpProperty prop;
+    prop.key = key;
+    prop.type = typeProp;
+    prop.pValue = valueFor(key);
+    props.push_back(prop);
+    index.insert(key, props.size()-1);
+    assign(props.back(), text);
+  }
+  else
+  {
+    QSnpProperty& prop = props[nProperty];
+    if(prop.type == PROP_STRING)
+    {
+      prop.type = typeProp;
+      if(!assign(prop, prop.text))
+        assign(prop, QByteArray("0"));
+    }
+  }
+
+  // переменная получает текущее значение в потоке вызывающего
+  bindings.insert(key, binding);
+  writeVar(binding, props[index.value(key)].pValue);
+}
+
+int QSnpPropertyStore::applyBindings()
+{
+  QMutexLocker lock(&mutex);
+  int nApplied = 0;
+  for(QHash<QByteArray, QSnpBinding>::iterator it = bindings.begin(); it != bindings.end(); ++it)
+  {
+    if(!it->bPending)
+      continue;
+    it->bPending = false;
+    writeVar(*it, valueFor(it.key()));
+    nApplied++;
+  }
+  return nApplied;
+}
@@ -0,0 +1,168 @@
+/**
+  \file   QSnpPropertyStore.h
+  \brief  Typed node property store hashed by key
+  \author Sholomov D.
+  \date   27.8.2013
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+
+#include <qsnap/qsnap_types.h>
+
+#include <atomic>
+
+// свойство вершины
+struct QSnpProperty
+{
+  QByteArray        key;                // название
+  QByteArray        text;               // значение в виде строки
+  QSnp::SnpPropType type;               // тип
+  double            dMin;               // диапазон числового значения (dMin >= dMax - без ограничения)
+  double            dMax;
+  QList<QByteArray> enumNames;          // варианты перечисления
+  QSnp::PropValue*  pValue;             // опубликованное типизированное значение
+
+  QSnpProperty() : type(QSnp::PROP_STRING), dMin(0), dMax(0), pValue(0) {}
+};
+
+// переменная приложения, связанная со свойством
+struct QSnpBinding
+{
+  QSnp::SnpBindType type;               // тип переменной
+  void*             pVar;               // адрес переменной
+  bool              bPending;           // значение изменено и ожидает записи в переменную
+
+  QSnpBinding() : type(QSnp::BIND_INT), pVar(0), bPending(false) {}
+};
+
+class QSnpPropertyStore;
+
+///////////////////////////////////////////////////////////
+////  Очередь хранилищ свойств с изменениями, ожидающими записи
+////  в связанные переменные. Записи в обычные переменные выполняются
+////  в потоке приложения в безопасной точке (ApplyNodeBindings,
+////  завершение WaitUserInput); проверка наличия изменений - одно
+////  чтение атомарного флага без блокировки
+
+class QSnpBindingQueue
+{
+public:
+  /// очередь библиотеки
+  static QSnpBindingQueue& instance();
+
+  /// постановка хранилища в очередь
+  void post(QSnpPropertyStore* pStore);
+
+  /// удаление хранилища из очереди
+  void cancel(QSnpPropertyStore* pStore);
+
+  /// запись изменений в переменные; возвращает количество записанных значений
+  int apply();
+
+protected:
+  QSnpBindingQueue(void);
+
+protected:
+  QMutex                      mutex;    // блокировка списка
+  QVector<QSnpPropertyStore*> stores;   // хранилища с изменениями
+  std::atomic<bool>           bPending; // список не пуст
+};
+
+///////////////////////////////////////////////////////////
+////  Свойства вершины.
+////  Свойства хранятся в порядке добавления (доступ по номеру для
+////  окна свойств) с индексом по названию. Значение задается строкой,
+////  проверяется и приводится к типу свойства при установке, а
+////  типизированное значение публикуется в PropValue, который читается
+////  вызывающим без разбора строки. PropValue по названию создается один
+////  раз и не удаляется до разрушения хранилища, даже при удалении
+////  свойства, поэтому закэшированные указатели остаются действительными.
+////  Счетчик версий увеличивается при любом изменении свойств.
+////  Свойство можно связать с переменной приложения: изменение значения
+////  (например, в окне свойств) записывается в нее без опроса и разбора
+////  строк - в атомарную сразу, в обычную через QSnpBindingQueue
+
+class QSnpPropertyStore
+{
+public:
+  QSnpPropertyStore(void);
+  ~QSnpPropertyStore(void);
+
+  /// количество свойств
+  int count() const;
+
+  /// свойство по номеру
+  bool get(int nProperty, QSnp::NodePropertyInfo* pInfo) const;
+
+  /// замена свойства по номеру (при смене названия свойство становится строковым)
+  bool set(int nProperty, const QSnp::NodePropertyInfo& info);
+
+  /// копия значения свойства (false - свойства нет); значение может изменить окно свойств,
+  /// поэтому строка копируется под блокировкой
+  bool value(const char* sKey, QByteArray& text) const;
+
+  /// установка значения, свойство добавляется при отсутствии;
+  /// false - свойство добавлено или значение не подходит к типу (остается прежним)
+  bool setValue(const char* sKey, const char* sValue);
+
+  /// описание типа свойства: текущее значение приводится к типу, отсутствующее - берется по умолчанию
+  void define(const QSnp::PropertyDef& def);
+
+  /// опубликованное значение свойства (создается при первом запросе, даже до добавления свойства)
+  const QSnp::PropValue* typedValue(const char* sKey);
+
+  /// удаление свойства
+  void remove(const char* sKey);
+
+  /// удаление всех свойств (bKeepDefined - оставить свойства с описанным типом)
+  void removeAll(bool bKeepDefined);
+
+  /// счетчик изменений свойств
+  const std::atomic<unsigned>* version() const { return &nVersion; }
+
+  /// связывание свойства с переменной приложения (pVar = 0 - отмена связи);
+  /// вызывается в потоке приложения: переменная сразу получает значение свойства
+  /// или, если свойства нет, свойство создается со значением переменной
+  void bind(const char* sKey, QSnp::SnpBindType type, void* pVar);
+
+  /// запись ожидающих изменений в обычные переменные (поток приложения)
+  int applyBindings();
+
+protected:
+  // разбор значения по типу свойства и публикация; false - значение не подходит к типу
+  bool assign(QSnpProperty& prop, const QByteArray& text);
+
+  // передача значения связанной переменной: атомарные записываются сразу,
+  // обычные отмечаются для записи в безопасной точке
+  void notifyBinding(const QSnpProperty& prop);
+
+  // запись значения в переменную
+  static void writeVar(const QSnpBinding& binding, const QSnp::PropValue* pValue);
+
+  // постановка в очередь связанных переменных после изменения (без блокировки хранилища)
+  void postBindings();
+
+  // опубликованное значение по названию
+  QSnp::PropValue* valueFor(const QByteArray& key);
+
+  // перестроение индекса после удаления свойств
+  void reindex();
+
+protected:
+  QVector<QSnpProperty>               props;    // свойства в порядке добавления
+  QHash<QByteArray, int>              index;    // номер свойства по названию
+  QHash<QByteArray, QSnp::PropValue*> values;   // опубликованные значения по названию
+  QHash<QByteArray, QSnpBinding>      bindings; // связанные переменные по названию
+  bool                                bPost;    // есть изменения для очереди связанных переменных
+  bool                                bQueued;  // хранилище в очереди (под блокировкой очереди)
+  std::atomic<unsigned>               nVersion; // счетчик изменений
+  mutable QMutex                      mutex;
+
+  friend class QSnpBindingQueue;
+};
@@ -10,6 +10,7 @@
 
 #include <QScrollBar>
 #include <QSettings>
+#include <QVBoxLayout>
 
 #include "opencv2/highgui/highgui.hpp"
 
@@ -22,6 +23,7 @@ QSnpSyncImageView::QSnpSyncImageView(SyncViewOrientation orient) :
   eViewType = VT_SYNC_IMAGE_VIEW;
   tOrient = orient;
   tLayoutType = SVL_DEFAULT;
+  pMatchOverlay = NULL;
 }
 
 QSnpSyncImageView::~QSnpSyncImageView(void)
@@ -38,10 +40,10 @@ QHandle QSnpSyncImageView::Create(QSnpInstance* _pInstance)
     return QHANDLE_INVALID;
 
   QSnpImageWidget* pWidget1 = new QSnpImageWidget(this);
-  pWidget1->setFigures(&lsFigures);
+  pWidget1->setGroups(&lsGroups);
 
   QSnpImageWidget* pWidget2 = new QSnpImageWidget(this);
-  pWidget2->setFigures(&lsFigures);
+  pWidget2->setGroups(&lsGroups);
 
   scrollArea[0].setWidget(pWidget1);
   scrollArea[1].setWidget(pWidget2);
@@ -73,6 +75,22 @@ QHandle QSnpSyncImageView::Create(QSnpInstance* _pInstance)
     pWidget2, SLOT(onVerSliderMoved(int))
     );
 
+  // рамка: сплиттер и ползунок порога, поверх - прозрачный виджет соответствий
+  QVBoxLayout* pLayout = new QVBoxLayout(&frameWidget);
+  pLayout->setContentsMargins(0, 0, 0, 0);
+  pLayout->setSpacing(0);
+  pLayout->addWidget(&splitterMain);
+  pLayout->addWidget(&sliderScore);
+
+  sliderScore.setOrientation(Qt::Horizontal);
+  sliderScore.setRange(0, QSNP_MATCH_SLIDER_STEPS);
+  sliderScore.setToolTip("Match score threshold");
+  sliderScore.hide();
+
+  pMatchOverlay = new QSnpMatchOverlay(&frameWidget, &splitterMain, pWidget1, pWidget2);
+  QObject::connect(&sliderScore, SIGNAL(valueChanged(int)), pMatchOverlay, SLOT(setThresholdPos(int)));
+
+  frameWidget.show();
   splitterMain.show();
   pWidget1->show();
   pWidget2->show();
@@ -91,9 +109,10 @@ QHandle QSnpSyncImageView::Create(QSnpInstance* _pInstance)
 
 bool QSnpSyncImageView::Destroy(void)
 {
-  foreach(QSnpFigure* pf, lsFigures)
-    delete pf;
-  lsFigures.clear();
+  destroyOverlays();
+  qDeleteAll(lsGroups);
+  lsGroups.clear();
+  hashGroups.clear();
 
   if(!pWidget)
     return true;
@@ -262,9 +281,8 @@ QHandle QSnpSyncImageView::addPoint(
 {
   QSnpFigure* pSnpFigure = new QSnpPoint(this, x, y, ptWidth);
   pSnpFigure->color = QColor_cast(color);
-  lsFigures.push_back(pSnpFigure);
 
-  return (QHandle)pSnpFigure;
+  return addFigure(pSnpFigure, idGroup);
 }
 
 QHandle QSnpSyncImageView::addLine(
@@ -275,7 +293,7 @@ QHandle QSnpSyncImageView::addLine(
     int             lineWidth,          // [in] толщина линии
     QSnp::SnpColor  color,              // [in] цвет
     QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
-    const char*     idGrouphView
+    const char*     idGroup
     )
 {
   QSnpLine* pSnpFigure = new QSnpLine(this);
@@ -284,9 +302,8 @@ QHandle QSnpSyncImageView::addLine(
   pSnpFigure->lineWidth = lineWidth;
   pSnpFigure->color = QColor_cast(color);
   pSnpFigure->rc = QRect(xFrom,yFrom,1,1).united(QRect(xTo,yTo,1,1)); // охватывающий прямоугольник
-  lsFigures.push_back(pSnpFigure);
 
-  return (QHandle)pSnpFigure;
+  return addFigure(pSnpFigure, idGroup);
 }
 
 QHandle QSnpSyncImageView::addRect(
@@ -294,16 +311,15 @@ QHandle QSnpSyncImageView::addRect(
     int             lineWidth,          // [in] толщина линии
     QSnp::SnpColor  color,              // [in] цвет
     QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
-    const char*     idGrouphView
+    const char*     idGroup
     )
 {
   QSnpFigure* pSnpFigure = new QSnpRect(this);
   pSnpFigure->rc = QRect(pRect->x, pRect->y, pRect->width, pRect->height);
   pSnpFigure->lineWidth = lineWidth;
   pSnpFigure->color = QColor_cast(color);
-  lsFigures.push_back(pSnpFigure);
-  
-  return (QHandle)pSnpFigure;
+
+  return addFigure(pSnpFigure, idGroup);
 }
 
 QHandle QSnpSyncImageView::addEllipse(
@@ -311,16 +327,65 @@ QHandle QSnpSyncImageView::addEllipse(
     int             lineWidth,          // [in] толщина линии
     QSnp::SnpColor  color,              // [in] цвет
     QSnp::LineType  type,               // [in] тип линии (линия, пунктир и т.д.)
-    const char*     idGrouphView
+    const char*     idGroup
     )
 {
   QSnpFigure* pSnpFigure = new QSnpEllipse(this);
   pSnpFigure->rc = QRect(pRect->x, pRect->y, pRect->width, pRect->height);
   pSnpFigure->lineWidth = lineWidth;
   pSnpFigure->color = QColor_cast(color);
-  lsFigures.push_back(pSnpFigure);
-  
-  return (QHandle)pSnpFigure;
+
+  return addFigure(pSnpFigure, idGroup);
+}
+
+QError QSnpSyncImageView::setMatches(
+    const QSnp::SnpPoint* ptsFrom,      // [in] точки первого окна
+    const QSnp::SnpPoint* ptsTo,        // [in] точки второго окна
+    const float*    scores,             // [in] оценки соответствий (0 - все 1.0)
+    const QSnp::SnpColor* colors,       // [in] цвета соответствий (0 - цвет color)
+    int             nMatches,           // [in] количество соответствий (0 - удаление)
+    int             lineWidth,          // [in] толщина линий
+    QSnp::SnpColor  color               // [in] цвет по умолчанию
+    )
+{
+  if(!pMatchOverlay)
+    return QERR_ERROR;
+  if(nMatches>0 && (!ptsFrom || !ptsTo))
+    return QERR_ERROR;
+
+  QVector<QSnpMatch> matches(qMax(nMatches, 0));
+  QRgb rgbDefault = QColor_cast(color).rgb();
+  for(int i = 0; i < matches.size(); i++)
+  {
+    QSnpMatch& m = matches[i];
+    m.ptFrom = QPoint(ptsFrom[i].x, ptsFrom[i].y);
+    m.ptTo = QPoint(ptsTo[i].x, ptsTo[i].y);
+    m.color = colors ? QColor_cast(colors[i]).rgb() : rgbDefault;
+    m.score = scores ? scores[i] : 1.0f;
+  }
+  pMatchOverlay->setMatches(matches, lineWidth);
+
+  // ползунок нужен, только если оценки различаются
+  bool bSlider = nMatches>0 && scores!=0;
+  sliderScore.blockSignals(true);
+  sliderScore.setValue(pMatchOverlay->thresholdPos(pMatchOverlay->threshold()));
+  sliderScore.blockSignals(false);
+  sliderScore.setVisible(bSlider);
+  return QERR_NO_ERROR;
+}
+
+QError QSnpSyncImageView::setMatchThreshold(
+    float           threshold           // [in] порог оценки
+    )
+{
+  if(!pMatchOverlay)
+    return QERR_ERROR;
+
+  pMatchOverlay->setThreshold(threshold);
+  sliderScore.blockSignals(true);
+  sliderScore.setValue(pMatchOverlay->thresholdPos(threshold));
+  sliderScore.blockSignals(false);
+  return QERR_NO_ERROR;
 }
 
 // получение координат пользовательской точки
@@ -360,11 +425,16 @@ QError QSnpSyncImageView::getUserRect(QSnp::SnpRect* rect)
 // функция удаления всех фигур в данном окне
 QError  QSnpSyncImageView::clearFigures()
 {
-  foreach(QSnpFigure* pf, lsFigures)
-    delete pf;
+  foreach(QSnpFigureGroup* pGroup, lsGroups)
+    pGroup->clear();
 
-  lsFigures.clear();
-  getWidget(0)->update();
+  // фигуры групп рисуются в обеих панелях
+  for(int nWidget = 0; nWidget<widgetCount(); nWidget++)
+  {
+    QSnpImageWidget* pw = getWidget(nWidget);
+    if(pw)
+      pw->update();
+  }
 
   return QERR_NO_ERROR;
 }
@@ -372,7 +442,7 @@ QError  QSnpSyncImageView::clearFigures()
 // получение frame-окна
 QWidget* QSnpSyncImageView::getFrameWidget()
 {
-  return &splitterMain;
+  return &frameWidget;
 }
 
 void QSnpSyncImageView::showWidget(bool bShow)
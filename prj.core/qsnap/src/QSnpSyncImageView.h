@@ -12,9 +12,11 @@
 #include "QSnpFigure.h"
 #include "QSnpImageWidget.h"
 #include "QSnpImageView.h"
+#include "QSnpMatchOverlay.h"
 
 #include <QSplitter>
 #include <QScrollArea>
+#include <QSlider>
 
 class QSnpSyncImageView :
   public QSnpImageView
@@ -95,6 +97,22 @@ public:
     const char*     idGroup
     );
 
+  /// установка соответствий точек первого и второго окна (линии поверх окон)
+  QError setMatches(
+    const QSnp::SnpPoint* ptsFrom,      // [in] точки первого окна
+    const QSnp::SnpPoint* ptsTo,        // [in] точки второго окна
+    const float*    scores,             // [in] оценки соответствий (0 - все 1.0)
+    const QSnp::SnpColor* colors,       // [in] цвета соответствий (0 - цвет color)
+    int             nMatches,           // [in] количество соответствий (0 - удаление)
+    int             lineWidth,          // [in] толщина линий
+    QSnp::SnpColor  color               // [in] цвет по умолчанию
+    );
+
+  /// установка порога оценки показываемых соответствий
+  QError setMatchThreshold(
+    float           threshold           // [in] порог оценки
+    );
+
   // получение координат пользовательской точки
   QError getUserPoint(QSnp::SnpPoint* point);
 
@@ -139,6 +157,7 @@ public: // events
 
 protected: // members
 
+  QWidget   frameWidget;                // рамка: сплиттер окон и ползунок порога соответствий
   QSplitter splitterMain;               // основной сплиттер
   QSplitter splitter1, splitter2;       // дополнительные сплиттеры
   
@@ -147,5 +166,8 @@ protected: // members
   QSnp::SyncViewOrientation tOrient;    // тип ориентации вертик/горизонт
   QSnp::SyncViewLayoutType tLayoutType; // тип размещения внутренних окон (см. SyncViewLayoutType)
 
+  QSlider   sliderScore;                // порог оценки соответствий
+  QSnpMatchOverlay* pMatchOverlay;      // линии соответствий (дочерний виджет рамки)
+
 protected: // service functions
 };
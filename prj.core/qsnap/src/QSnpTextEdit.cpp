@@ -6,11 +6,153 @@
 */
 
 #include "QSnpTextEdit.h"
+#include "QSnpLogModel.h"
+#include "QSnpLogSearch.h"
+#include "QSnpLogDelegate.h"
 
-QSnpTextEdit::QSnpTextEdit(void)
+#include <QApplication>
+#include <QClipboard>
+#include <QKeyEvent>
+#include <QScrollBar>
+
+#include <algorithm>
+
+QSnpTextEdit::QSnpTextEdit(QSnpLogModel* pModel) :
+  bAtBottom(true), bFiltered(false), pSource(pModel)
 {
+  pFilter = new QSnpLogFilterModel(pModel, this);
+  setModel(pModel);
+  pDelegate = new QSnpLogDelegate(this);
+  setItemDelegate(pDelegate);
+  setUniformItemSizes(true);
+  setSelectionMode(QAbstractItemView::ExtendedSelection);
+  setEditTriggers(QAbstractItemView::NoEditTriggers);
+  setFont(QFont("Courier"));
+
+  connect(pModel, SIGNAL(rowsAboutToBeInserted(const QModelIndex&, int, int)), this, SLOT(onRowsAboutToBeInserted()));
+  connect(pModel, SIGNAL(rowsInserted(const QModelIndex&, int, int)), this, SLOT(onRowsInserted(const QModelIndex&, int, int)));
+  connect(pModel, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)), this, SLOT(onDataChanged(const QModelIndex&, const QModelIndex&)));
+  connect(pModel, SIGNAL(modelReset()), this, SLOT(onModelReset()));
+  connect(pFilter, SIGNAL(rowsAboutToBeInserted(const QModelIndex&, int, int)), this, SLOT(onRowsAboutToBeInserted()));
+  connect(pFilter, SIGNAL(rowsInserted(const QModelIndex&, int, int)), this, SLOT(onRowsInserted(const QModelIndex&, int, int)));
 }
 
 QSnpTextEdit::~QSnpTextEdit(void)
 {
 }
+
+void QSnpTextEdit::onRowsAboutToBeInserted()
+{
+  if(sender() != model())
+    return;
+  QScrollBar* pVerScroll = verticalScrollBar();
+  bAtBottom = pVerScroll->value() >= pVerScroll->maximum();
+}
+
+void QSnpTextEdit::onRowsInserted(const QModelIndex&, int first, int last)
+{
+  // строки фильтра уже учтены при добавлении в лог
+  if(sender() == pSource)
+    measureRows(first, last);
+
+  // не сбивать прокрутку, если пользователь просматривает старые строки
+  if(sender() == model() && bAtBottom)
+    scrollToBottom();
+}
+
+void QSnpTextEdit::onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+  measureRows(topLeft.row(), bottomRight.row());
+}
+
+void QSnpTextEdit::measureRows(int first, int last)
+{
+  // ширина строк растет до самой длинной строки
+  bool bWider = false;
+  for(int i = first; i <= last; i++)
+  {
+    quint32 attr = pSource->index(i).data(QSNP_LOG_ATTR_ROLE).toUInt();
+    bWider |= pDelegate->measureLine(pSource->line(i), attr, font());
+  }
+  if(bWider)
+    scheduleDelayedItemsLayout();
+}
+
+void QSnpTextEdit::onModelReset()
+{
+  pDelegate->resetWidth();
+  scheduleDelayedItemsLayout();
+}
+
+void QSnpTextEdit::keyPressEvent(QKeyEvent* ev)
+{
+  if(ev->matches(QKeySequence::Copy))
+  {
+    QModelIndexList indexes = selectionModel()->selectedRows();
+    std::sort(indexes.begin(), indexes.end());
+    QString text;
+    for(int i = 0; i < indexes.size(); i++)
+      text += indexes[i].data().toString() + '\n';
+    QApplication::clipboard()->setText(text);
+    return;
+  }
+  QListView::keyPressEvent(ev);
+}
+
+int QSnpTextEdit::currentSourceRow() const
+{
+  QModelIndex index = currentIndex();
+  if(!index.isValid())
+    return -1;
+  return bFiltered ? pFilter->sourceRow(index.row()) : index.row();
+}
+
+void QSnpTextEdit::jumpToSource(int sourceRow)
+{
+  if(sourceRow < 0)
+    return;
+  QModelIndex index = bFiltered ? pFilter->index(pFilter->rowForSource(sourceRow)) : pSource->index(sourceRow);
+  if(!index.isValid())
+    return;
+  setCurrentIndex(index);
+  scrollTo(index, QAbstractItemView::PositionAtCenter);
+}
+
+void QSnpTextEdit::showModel(QAbstractItemModel* pModel)
+{
+  // setModel создает новую модель выделения, прежняя удаляется
+  QItemSelectionModel* pSelectionOld = selectionModel();
+  setModel(pModel);
+  delete pSelectionOld;
+}
+
+void QSnpTextEdit::setSearch(const QString& sText, bool bRegExp, bool bFilter)
+{
+  int sourceRowCur = currentSourceRow();
+  pFilter->setQuery(QSnpLogQuery(sText, bRegExp));
+
+  bool bShowFilter = bFilter && !pFilter->query().isEmpty();
+  if(bShowFilter != bFiltered)
+  {
+    bFiltered = bShowFilter;
+    showModel(bFiltered ? (QAbstractItemModel*)pFilter : (QAbstractItemModel*)pSource);
+    if(!bFiltered)
+    {
+      // после снятия фильтра остается выбранная строка
+      jumpToSource(sourceRowCur);
+      return;
+    }
+  }
+
+  // ближайшее совпадение начиная с текущей строки
+  if(!pFilter->query().isEmpty())
+    jumpToSource(pFilter->findNext(sourceRowCur - 1, false));
+}
+
+void QSnpTextEdit::findNext(bool bBackward)
+{
+  int sourceRowCur = currentSourceRow();
+  if(sourceRowCur < 0 && bBackward)
+    sourceRowCur = pSource->count();
+  jumpToSource(pFilter->findNext(sourceRowCur, bBackward));
+}
@@ -7,12 +7,68 @@
 
 #pragma once
 
-#include <QTextEdit>
+#include <QListView>
 
-class QSnpTextEdit : public QTextEdit
+class QSnpLogModel;
+class QSnpLogFilterModel;
+class QSnpLogDelegate;
+
+///////////////////////////////////////////////////////////
+////  Окно лога: строки QSnpLogModel показываются списком
+////  с одинаковой высотой строк, поэтому отрисовываются и
+////  измеряются только видимые строки. Ширина строк - ширина самой
+////  длинной добавленной строки (горизонтальная прокрутка), она
+////  обновляется при добавлении строк. При включенном фильтре
+////  показываются только строки, найденные QSnpLogFilterModel
+
+class QSnpTextEdit : public QListView
 {
   Q_OBJECT
 public:
-  QSnpTextEdit(void);
+  QSnpTextEdit(QSnpLogModel* pModel);
   ~QSnpTextEdit(void);
+
+public slots:
+  // установка условия поиска: при bFilter показываются только найденные строки,
+  // иначе выполняется переход к ближайшему совпадению
+  void setSearch(const QString& sText, bool bRegExp, bool bFilter);
+
+  // переход к следующему (предыдущему) совпадению
+  void findNext(bool bBackward);
+
+protected slots:
+  // запоминание положения прокрутки перед добавлением строк
+  void onRowsAboutToBeInserted();
+
+  // учет ширины новых строк и прокрутка вниз, если окно было прокручено до конца
+  void onRowsInserted(const QModelIndex& parent, int first, int last);
+
+  // учет ширины дописанной последней строки
+  void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+
+  // сброс ширины строк после очистки лога
+  void onModelReset();
+
+protected:
+  // копирование выделенных строк по Ctrl+C
+  virtual void keyPressEvent(QKeyEvent* ev);
+
+  // строка лога под текущим элементом (-1 - нет текущего элемента)
+  int currentSourceRow() const;
+
+  // учет ширины строк лога first..last
+  void measureRows(int first, int last);
+
+  // переход к строке лога
+  void jumpToSource(int sourceRow);
+
+  // замена показываемой модели
+  void showModel(QAbstractItemModel* pModel);
+
+protected:
+  bool      bAtBottom;                  // окно прокручено до последней строки
+  bool      bFiltered;                  // показываются только найденные строки
+  QSnpLogModel*       pSource;          // строки лога
+  QSnpLogFilterModel* pFilter;          // найденные строки
+  QSnpLogDelegate*    pDelegate;        // отрисовка строк
 };
@@ -7,15 +7,24 @@
 
 #include "QSnpTextView.h"
 #include "QSnpTextEdit.h"
+#include "QSnpLogModel.h"
+#include "QSnpLogFilterBar.h"
 
-#include <QScrollBar>
+#include <QVBoxLayout>
 
 using namespace QSnp;
 
 QSnpTextView::QSnpTextView(void)
 {
   pWidget = NULL;
+  pModel = NULL;
+  pFilterBar = NULL;
   eViewType = VT_TEXT_VIEW;
+
+  // все каналы включены, выводятся сообщения всех уровней
+  filter.channels.store(~0ull);
+  filter.level.store(LL_DEBUG);
+  channelNames.append("default");
 }
 
 QSnpTextView::~QSnpTextView(void)
@@ -28,12 +37,27 @@ QHandle QSnpTextView::Create(QSnpInstance* _pInstance)
   if(pWidget)
     return (QHandle)this;
   
-  QSnpTextEdit* pWidget = new QSnpTextEdit();
+  QWidget* pWidget = new QWidget();
+  QVBoxLayout* pLayout = new QVBoxLayout(pWidget);
+  pLayout->setContentsMargins(0, 0, 0, 0);
+  pLayout->setSpacing(0);
+
+  pFilterBar = new QSnpLogFilterBar(&filter, pWidget);
+  for(int i = 0; i < channelNames.size(); i++)
+    pFilterBar->addChannel(i, channelNames[i]);
+  pLayout->addWidget(pFilterBar);
+
+  pModel = new QSnpLogModel();
+  QSnpTextEdit* pTextEdit = new QSnpTextEdit(pModel);
+  pModel->setParent(pTextEdit);
+  pLayout->addWidget(pTextEdit);
+
+  QObject::connect(pFilterBar, SIGNAL(searchChanged(const QString&, bool, bool)),
+    pTextEdit, SLOT(setSearch(const QString&, bool, bool)));
+  QObject::connect(pFilterBar, SIGNAL(findRequested(bool)), pTextEdit, SLOT(findNext(bool)));
+
   pWidget->resize(500,300);
   pWidget->show();
-  pWidget->setPlainText("");
-  pWidget->setReadOnly(true);
-  pWidget->setFontFamily("Courier");
 
   QSnpView::pWidget = pWidget;
 
@@ -46,6 +70,8 @@ bool QSnpTextView::Destroy(void)
     return true;
   delete pWidget;
   pWidget = 0;
+  pModel = 0;
+  pFilterBar = 0;
   return true;
 }
 
@@ -53,20 +79,73 @@ void QSnpTextView::Log(const char* str)
 {
   if(!pWidget)
     return;
-  QSnpTextEdit* pWidget = (QSnpTextEdit*)QSnpView::pWidget;
-  pWidget->insertPlainText(str);
-  
-  // скроллировать вниз 
-  QScrollBar* pVerScroll = pWidget->verticalScrollBar();
-  pVerScroll->setSliderPosition(pVerScroll->maximum());
+  // прокрутка вниз выполняется окном при добавлении строк
+  pModel->appendText(str);
+}
+
+void QSnpTextView::Log(const char* str, const QSnpLogRun* runs, int nRuns)
+{
+  if(!pWidget)
+    return;
+  pModel->appendText(str, runs, nRuns);
 }
 
 void QSnpTextView::Clear()
 {
   if(!pWidget)
     return;
-  QSnpTextEdit* pWidget = (QSnpTextEdit*)QSnpView::pWidget;
-  pWidget->clear();
+  pModel->clear();
+}
+
+void QSnpTextView::SetLimits(int maxLines, long long maxBytes)
+{
+  if(!pWidget)
+    return;
+  pModel->setLimits(maxLines, maxBytes);
+}
+
+void QSnpTextView::SetSpill(const char* sDir, long long segmentBytes, int maxSegments)
+{
+  if(!pWidget)
+    return;
+  pModel->setSpill(sDir ? QString::fromLocal8Bit(sDir) : QString(), segmentBytes, maxSegments);
+}
+
+int QSnpTextView::RegisterChannel(const char* sName, bool bEnabled)
+{
+  QString sChannel = QString::fromUtf8(sName);
+  int channel = channelNames.indexOf(sChannel);
+  if(channel < 0)
+  {
+    if(channelNames.size() >= LOG_MAX_CHANNELS)
+      return -1;
+    channel = channelNames.size();
+    channelNames.append(sChannel);
+    EnableChannel(channel, bEnabled);
+    if(pFilterBar)
+      pFilterBar->addChannel(channel, sChannel);
+  }
+  return channel;
+}
+
+void QSnpTextView::EnableChannel(int channel, bool bEnable)
+{
+  if(channel < 0 || channel >= LOG_MAX_CHANNELS)
+    return;
+  unsigned long long bit = 1ull << channel;
+  if(bEnable)
+    filter.channels.fetch_or(bit);
+  else
+    filter.channels.fetch_and(~bit);
+  if(pFilterBar)
+    pFilterBar->updateState();
+}
+
+void QSnpTextView::SetLevel(LogLevel level)
+{
+  filter.level.store(level);
+  if(pFilterBar)
+    pFilterBar->updateState();
 }
   
 
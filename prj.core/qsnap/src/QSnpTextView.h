@@ -8,6 +8,12 @@
 #include <qsnap/qsnap.h>
 #include "QSnpView.h"
 
+#include <QStringList>
+
+class QSnpLogModel;
+struct QSnpLogRun;
+class QSnpLogFilterBar;
+
 class QSnpTextView :
   public QSnpView
 {
@@ -24,13 +30,39 @@ public:
   /// вывод лога
   void Log(const char* str);
 
+  /// вывод лога с атрибутами строк (участки по возрастанию смещений в str)
+  void Log(const char* str, const QSnpLogRun* runs, int nRuns);
+
   /// очистка текста
   void Clear();
 
+  /// установка ограничений лога по количеству строк и объему (0 - по умолчанию)
+  void SetLimits(int maxLines, long long maxBytes);
+
+  /// выгрузка вытесненных строк в файлы каталога sDir (NULL или "" - выключение)
+  void SetSpill(const char* sDir, long long segmentBytes, int maxSegments);
+
+  /// регистрация именованного канала лога, возвращает номер канала (-1 - каналов больше нет)
+  int RegisterChannel(const char* sName, bool bEnabled);
+
+  /// включение/отключение канала
+  void EnableChannel(int channel, bool bEnable);
+
+  /// установка минимального уровня выводимых сообщений
+  void SetLevel(QSnp::LogLevel level);
+
+  /// фильтр лога (читается вызывающими без блокировок)
+  const QSnp::LogFilter* getFilter() const { return &filter; }
+
  // virtual QWidget* getWidget() { return pWidget; }
 
 protected:
  // QSnpTextEdit* pWidget;
+  QSnpLogModel* pModel;                 // строки лога
+  QSnpLogFilterBar* pFilterBar;         // панель уровня и каналов
+
+  QSnp::LogFilter filter;               // фильтр, общий с proxy
+  QStringList   channelNames;           // имена каналов по номерам
 
 
 };
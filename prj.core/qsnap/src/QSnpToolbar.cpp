@@ -20,6 +20,37 @@ QSnpToolBar::QSnpToolBar(void)
 
 QSnpToolBar::~QSnpToolBar(void)
 {
+  foreach(QSnp::SnapState* pState, states)
+    delete pState;
+}
+
+void QSnpToolBar::addState(QAction* pAction)
+{
+  if(states.contains(pAction))
+    return;
+  SnapState* pState = new SnapState;
+  pState->flags.store(0);
+  states.insert(pAction, pState);
+
+  pAction->connect(pAction, SIGNAL(changed()), this, SLOT(onActionChanged()));
+  pAction->connect(pAction, SIGNAL(toggled(bool)), this, SLOT(onActionChanged()));
+  updateState(pAction);
+}
+
+void QSnpToolBar::onActionChanged()
+{
+  QAction *pAction = qobject_cast<QAction*>(sender());
+  if(pAction)
+    updateState(pAction);
+}
+
+void QSnpToolBar::updateState(QAction* pAction)
+{
+  SnapState* pState = states.value(pAction, 0);
+  if(!pState)
+    return;
+  pState->flags.store((pAction->isChecked() ? SF_CHECKED : 0) | (pAction->isEnabled() ? SF_ENABLED : 0),
+    std::memory_order_relaxed);
 }
 
 void QSnpToolBar::onAction()
@@ -9,6 +9,9 @@
 
 #include <QToolBar>
 #include <QAction>
+#include <QHash>
+
+#include <qsnap/qsnap_types.h>
 
 class QSnpToolBar : public QToolBar
 {
@@ -17,7 +20,22 @@ public:
   QSnpToolBar(void);
   ~QSnpToolBar(void);
 
+  // публикация состояния элемента управления (выделен/доступен)
+  void addState(QAction* pAction);
+
+  // опубликованное состояние элемента управления (0 - элемент не с этой панели)
+  const QSnp::SnapState* getState(QAction* pAction) const { return states.value(pAction, 0); }
+
 public slots:
   void onAction();
 
+  // обновление опубликованного состояния элемента
+  void onActionChanged();
+
+protected:
+  // запись состояния элемента в опубликованное
+  void updateState(QAction* pAction);
+
+protected:
+  QHash<QAction*, QSnp::SnapState*> states;   // состояния элементов управления
 };
@@ -0,0 +1,152 @@
+/**
+  \file   QSnpTreeModel.cpp
+  \brief  Class function members for the snap tree item model
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#include "QSnpTreeModel.h"
+#include "QSnpNode.h"
+
+#include <QFont>
+
+QSnpTreeModel::QSnpTreeModel(QSnpRootNode* _pRoot, QObject* pParent) :
+  QAbstractItemModel(pParent), pRoot(_pRoot)
+{
+  showNode(pRoot);
+
+  timer.setSingleShot(true);
+  timer.setInterval(0);
+  connect(&timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+QSnpTreeModel::~QSnpTreeModel(void)
+{
+}
+
+QSnpNode* QSnpTreeModel::node(const QModelIndex& index) const
+{
+  return index.isValid() ? (QSnpNode*)index.internalPointer() : 0;
+}
+
+QModelIndex QSnpTreeModel::indexFor(QSnpNode* pNode) const
+{
+  return pNode ? createIndex(pNode->nRow, 0, pNode) : QModelIndex();
+}
+
+QModelIndex QSnpTreeModel::indexOf(QSnpNode* pNode)
+{
+  if(!pNode)
+    return QModelIndex();
+  if(!pNode->bShown)
+    flush();
+  return indexFor(pNode);
+}
+
+void QSnpTreeModel::nodeAdded(QSnpNode* pParentNode)
+{
+  if(!pParentNode->bDirty)
+  {
+    pParentNode->bDirty = true;
+    dirty.push_back(pParentNode);
+  }
+  if(!timer.isActive())
+    timer.start();
+}
+
+void QSnpTreeModel::nodeChanged(QSnpNode* pNode)
+{
+  if(!pNode || !pNode->bShown)
+    return;
+  QModelIndex index = indexFor(pNode);
+  emit dataChanged(index, index);
+}
+
+void QSnpTreeModel::showNode(QSnpNode* pNode)
+{
+  pNode->bShown = true;
+  pNode->nRowsShown = pNode->lstChildNode.size();
+  foreach(QSnpNode* pChild, pNode->lstChildNode)
+    showNode(pChild);
+}
+
+void QSnpTreeModel::flush()
+{
+  timer.stop();
+
+  QVector<QSnpNode*> parents;
+  parents.swap(dirty);
+  foreach(QSnpNode* pParentNode, parents)
+  {
+    pParentNode->bDirty = false;
+
+    // непоказанная вершина будет показана целиком вместе с предком
+    if(!pParentNode->bShown)
+      continue;
+    int nShown = pParentNode->nRowsShown;
+    int nCount = pParentNode->lstChildNode.size();
+    if(nCount <= nShown)
+      continue;
+
+    beginInsertRows(indexFor(pParentNode), nShown, nCount-1);
+    for(int i = nShown; i < nCount; i++)
+      showNode(pParentNode->lstChildNode[i]);
+    pParentNode->nRowsShown = nCount;
+    endInsertRows();
+  }
+}
+
+QModelIndex QSnpTreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+  if(column != 0 || row < 0)
+    return QModelIndex();
+  if(!parent.isValid())
+    return row == 0 ? indexFor(pRoot) : QModelIndex();
+
+  QSnpNode* pParentNode = node(parent);
+  if(row >= pParentNode->nRowsShown)
+    return QModelIndex();
+  return indexFor(pParentNode->lstChildNode[row]);
+}
+
+QModelIndex QSnpTreeModel::parent(const QModelIndex& index) const
+{
+  QSnpNode* pNode = node(index);
+  return pNode ? indexFor(pNode->pParentNode) : QModelIndex();
+}
+
+int QSnpTreeModel::rowCount(const QModelIndex& parent) const
+{
+  if(!parent.isValid())
+    return 1;
+  return parent.column() == 0 ? node(parent)->nRowsShown : 0;
+}
+
+int QSnpTreeModel::columnCount(const QModelIndex& parent) const
+{
+  return 1;
+}
+
+QVariant QSnpTreeModel::data(const QModelIndex& index, int role) const
+{
+  QSnpNode* pNode = node(index);
+  if(!pNode)
+    return QVariant();
+
+  switch(role)
+  {
+  case Qt::DisplayRole:
+    return pNode->caption();
+  case Qt::FontRole:
+    if(pNode->isSelected())
+    {
+      QFont font;
+      font.setBold(true);
+      return font;
+    }
+    return QVariant();
+  case TID_QNODE_REF:
+    return QVariant((QHandle)pNode);
+  }
+  return QVariant();
+}
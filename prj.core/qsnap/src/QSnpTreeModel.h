@@ -0,0 +1,67 @@
+/**
+  \file   QSnpTreeModel.h
+  \brief  Item model exposing the snap tree node arena to QTreeView
+  \author Sholomov D.
+  \date   15.5.2013
+*/
+
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QTimer>
+#include <QVector>
+
+class QSnpNode;
+class QSnpRootNode;
+
+///////////////////////////////////////////////////////////
+////  Модель дерева снепа поверх вершин хранилища.
+////  Элементы окна не создаются: QTreeView запрашивает только
+////  видимые строки раскрытых вершин, индекс ссылается на QSnpNode.
+////  Добавление вершин не сообщается окну сразу: родитель отмечается
+////  и все новые строки показываются одной вставкой на родителя в
+////  следующем такте цикла событий. Вершина, родитель которой еще не
+////  показан, становится видимой вместе со всеми своими детьми
+
+class QSnpTreeModel : public QAbstractItemModel
+{
+  Q_OBJECT
+public:
+  QSnpTreeModel(QSnpRootNode* pRoot, QObject* pParent = 0);
+  virtual ~QSnpTreeModel(void);
+
+  /// вершина по индексу (0 для пустого индекса)
+  QSnpNode* node(const QModelIndex& index) const;
+
+  /// индекс вершины (ожидающие вставки строки показываются сразу)
+  QModelIndex indexOf(QSnpNode* pNode);
+
+  /// у вершины добавлены дети (вставка строк откладывается до сброса)
+  void nodeAdded(QSnpNode* pParentNode);
+
+  /// изменилось отображение вершины (заголовок, выделение)
+  void nodeChanged(QSnpNode* pNode);
+
+public slots:
+  /// показ отложенных строк
+  void flush();
+
+public: // QAbstractItemModel
+  virtual QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const;
+  virtual QModelIndex parent(const QModelIndex& index) const;
+  virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+  virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+protected:
+  // индекс показанной вершины
+  QModelIndex indexFor(QSnpNode* pNode) const;
+
+  // отметка вершины и ее поддерева как показанных
+  static void showNode(QSnpNode* pNode);
+
+protected:
+  QSnpRootNode*       pRoot;            // корневая вершина (единственная строка верхнего уровня)
+  QVector<QSnpNode*>  dirty;            // вершины с неотображенными детьми в порядке добавления
+  QTimer              timer;            // сброс в следующем такте
+};
@@ -12,6 +12,7 @@ using namespace QSnp;
 QSnpTreeView::QSnpTreeView(void)
 {
   pTreeWidget = NULL;
+  pTreeModel = NULL;
   eViewType = VT_SNAPTREE_VIEW;
 }
 
@@ -25,22 +26,20 @@ QHandle QSnpTreeView::Create(QSnpInstance* _pInstance)
   if(pTreeWidget)
     return (QHandle)this;
 
-  // настройка окна дерева снепа
+  // настройка окна дерева снепа: окно показывает модель поверх вершин дерева
   pTreeWidget = new QSnpTreeWidget();
-  QTreeWidget* pw = pTreeWidget;
+  QTreeView* pw = pTreeWidget;
   pw->setHeaderHidden(true);
   pw->setItemsExpandable(true);
   pw->setRootIsDecorated(true);
 
-  QTreeWidgetItem* pri = new QTreeWidgetItem();
-  pri->setText(0, getRootNode()->caption());
-  pw->addTopLevelItem(pri);
-  pTreeWidget->setQSnpNode(getRootNode(), pri, 0);
+  pTreeModel = new QSnpTreeModel(getRootNode(), this);
+  pTreeWidget->setTreeModel(pTreeModel);
 
-  rootNode.setTreeWidgetItem(pri);
+  rootNode.setModel(pTreeModel);
   rootNode.setInstance(_pInstance);
  
-  pri->setExpanded(true);
+  pw->expand(pTreeModel->indexOf(getRootNode()));
 
   // настройка окна свойств
   pPropWidget = new QSnpPropertyWidget();
@@ -60,7 +59,7 @@ QHandle QSnpTreeView::Create(QSnpInstance* _pInstance)
   pPropWidget->show();
 
   pTreeWidget->connect(
-    pTreeWidget, SIGNAL(itemSelectionChanged()),
+    pTreeWidget->selectionModel(), SIGNAL(currentChanged(const QModelIndex&, const QModelIndex&)),
     this, SLOT(onUpdateProperties())
     );
 
@@ -79,8 +78,11 @@ bool QSnpTreeView::Destroy(void)
 {
   if(!pTreeWidget)
     return true;
+  rootNode.setModel(0);
   delete pTreeWidget;
   pTreeWidget = 0;
+  delete pTreeModel;
+  pTreeModel = 0;
   return true;
 
 }
@@ -12,6 +12,7 @@
 #include "QSnpView.h"
 #include "QSnpNode.h"
 #include "QSnpTreeWidget.h"
+#include "QSnpTreeModel.h"
 #include "QSnpPropertyWidget.h"
 
 #include <QSplitter>
@@ -47,6 +48,9 @@ public:
   /// получение виджета
   virtual QSnpTreeWidget* getTreeWidget() { return pTreeWidget; }
 
+  /// получение модели дерева
+  QSnpTreeModel* getTreeModel() { return pTreeModel; }
+
   // загрузить состояние вершин
   void LoadState();
 
@@ -64,6 +68,7 @@ public slots:
 private:
   // Widgets
   QSnpTreeWidget* pTreeWidget;      // Qt widget для работы с деревом
+  QSnpTreeModel* pTreeModel;        // модель дерева для виджета
   QSnpPropertyWidget* pPropWidget;  // Qt widget для свойств
   QSplitter splitter;
 
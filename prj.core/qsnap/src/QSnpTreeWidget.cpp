@@ -44,15 +44,26 @@ private:
 //////////////////////////////////////////////////////////////////////////////
 //// Класс QSnpTreeWidget 
 
-QSnpTreeWidget::QSnpTreeWidget(void)
+QSnpTreeWidget::QSnpTreeWidget(void) : pTreeModel(0)
 {
   connect(
-    this, SIGNAL(itemDoubleClicked( QTreeWidgetItem * , int  )), 
-    this, SLOT(onItemDoubleClicked( QTreeWidgetItem * , int  ))
+    this, SIGNAL(doubleClicked(const QModelIndex&)), 
+    this, SLOT(onDoubleClicked(const QModelIndex&))
+    );
+  connect(
+    this, SIGNAL(expanded(const QModelIndex&)), 
+    this, SLOT(onExpanded(const QModelIndex&))
+    );
+  connect(
+    this, SIGNAL(collapsed(const QModelIndex&)), 
+    this, SLOT(onCollapsed(const QModelIndex&))
     );
 
   setExpandsOnDoubleClick(false);
 
+  // все строки одной высоты: окну не нужно измерять строки при прокрутке
+  setUniformRowHeights(true);
+
   qApp->installEventFilter(new StwEventFilter(this));
 }
 
@@ -60,77 +71,80 @@ QSnpTreeWidget::~QSnpTreeWidget(void)
 {
 }
 
-QSnpNode* QSnpTreeWidget::getQSnpNode(QTreeWidgetItem * item, int column )
+void QSnpTreeWidget::setTreeModel(QSnpTreeModel* pModel)
 {
-  QVariant vData = item->data(column, TID_QNODE_REF);
-  QSnpNode* pNode = (QSnpNode*)(vData.toULongLong());
-  return pNode;
+  pTreeModel = pModel;
+  setModel(pModel);
 }
 
-QSnpNode* QSnpTreeWidget::getCurrentQSnpNode()
+QSnpNode* QSnpTreeWidget::getQSnpNode(const QModelIndex& index)
 {
-  QTreeWidgetItem * item = currentItem();
-
-  if(!item)
-    return NULL;
-
-  QVariant vData = item->data(0, TID_QNODE_REF);
-  QSnpNode* pNode = (QSnpNode*)(vData.toULongLong());
-  return pNode;
+  return pTreeModel ? pTreeModel->node(index) : NULL;
 }
 
-void QSnpTreeWidget::setQSnpNode(QSnpNode* pNode, QTreeWidgetItem * item, int column )
+QSnpNode* QSnpTreeWidget::getCurrentQSnpNode()
 {
-  QVariant qData((QHandle)pNode);
-  item->setData(column, TID_QNODE_REF, qData);
+  return getQSnpNode(currentIndex());
 }
 
-void QSnpTreeWidget::onItemDoubleClicked(QTreeWidgetItem * item, int column )
+void QSnpTreeWidget::onDoubleClicked(const QModelIndex& index)
 {
-  QVariant vData = item->data(0, TID_QNODE_REF);
-  QSnpNode* pNode = (QSnpNode*)(vData.toULongLong());
+  QSnpNode* pNode = getQSnpNode(index);
+  if(!pNode)
+    return;
   bool bSelected = pNode->isSelected();
   bSelected = !bSelected;
   bool bChildren = kbdModifiers & Qt::ControlModifier;
-  selectItem(item, bSelected, bChildren);
+  selectNode(pNode, bSelected, bChildren);
+}
+
+void QSnpTreeWidget::onExpanded(const QModelIndex& index)
+{
+  QSnpNode* pNode = getQSnpNode(index);
+  if(pNode)
+    pNode->setExpandedFlag(true);
 }
 
-void QSnpTreeWidget::selectItem(QTreeWidgetItem * item, bool bSelect, bool bChildren)
+void QSnpTreeWidget::onCollapsed(const QModelIndex& index)
+{
+  QSnpNode* pNode = getQSnpNode(index);
+  if(pNode)
+    pNode->setExpandedFlag(false);
+}
+
+void QSnpTreeWidget::selectNode(QSnpNode* pNode, bool bSelect, bool bChildren)
 {
-  QVariant vData = item->data(0, TID_QNODE_REF);
-  QSnpNode* pNode = (QSnpNode*)(vData.toULongLong());
   pNode->setSelected(bSelect);
 
-  QFont font = item->font(0);
-  font.setBold(bSelect);
-  item->setFont(0,font);
+  // шрифт строки берется моделью из состояния вершины
+  if(pTreeModel)
+    pTreeModel->nodeChanged(pNode);
 
   // селекция дочерних вершин
   if(bChildren)
   {
-    for(int nChild=0; nChild<item->childCount(); nChild++)
-    {
-      QTreeWidgetItem * pChildItem = item->child(nChild);
-      selectItem(pChildItem, bSelect, bChildren);
-    }
+    for(int nChild=0; nChild<pNode->childCount(); nChild++)
+      selectNode(pNode->childNode(nChild), bSelect, bChildren);
   }
 }
 
-void QSnpTreeWidget::expandItem(QTreeWidgetItem * item, bool bExpand, bool bChildren)
+void QSnpTreeWidget::expandNode(QSnpNode* pNode, bool bExpand, bool bChildren)
 {
-  QVariant vData = item->data(0, TID_QNODE_REF);
-  QSnpNode* pNode = (QSnpNode*)(vData.toULongLong());
   pNode->setExpanded(bExpand);
 
-  item->setExpanded(bExpand);
-
-  // селекция дочерних вершин
+  // раскрытие дочерних вершин
   if(bChildren)
   {
-    for(int nChild=0; nChild<item->childCount(); nChild++)
-    {
-      QTreeWidgetItem * pChildItem = item->child(nChild);
-      expandItem(pChildItem, bExpand, bChildren);
-    }
+    for(int nChild=0; nChild<pNode->childCount(); nChild++)
+      expandNode(pNode->childNode(nChild), bExpand, bChildren);
   }
 }
+
+void QSnpTreeWidget::applyExpanded(QSnpNode* pNode)
+{
+  if(!pTreeModel)
+    return;
+  QModelIndex index = pTreeModel->indexOf(pNode);
+  if(index.isValid() && isExpanded(index) != pNode->isExpanded())
+    setExpanded(index, pNode->isExpanded());
+}
@@ -8,26 +8,40 @@
 #pragma once
 
 #include "QSnpNode.h"
+#include "QSnpTreeModel.h"
 
-class QSnpTreeWidget : public QTreeWidget
+#include <QTreeView>
+
+class QSnpTreeWidget : public QTreeView
 {
   Q_OBJECT
 public:
   QSnpTreeWidget(void);
   ~QSnpTreeWidget(void);
 
-  QSnpNode* getQSnpNode(QTreeWidgetItem * item, int column=0);
+  // установка модели дерева снепа
+  void setTreeModel(QSnpTreeModel* pModel);
+  QSnpTreeModel* getTreeModel() { return pTreeModel; }
+
+  QSnpNode* getQSnpNode(const QModelIndex& index);
   QSnpNode* getCurrentQSnpNode();
 
-  void setQSnpNode(QSnpNode* pNode, QTreeWidgetItem * item, int column=0);
-  void selectItem(QTreeWidgetItem * item, bool bSelect, bool bChildren = false);
-  void expandItem(QTreeWidgetItem * item, bool bSelect, bool bChildren = false);
+  void selectNode(QSnpNode* pNode, bool bSelect, bool bChildren = false);
+  void expandNode(QSnpNode* pNode, bool bExpand, bool bChildren = false);
+
+  // раскрытие вершины в окне по ее состоянию
+  void applyExpanded(QSnpNode* pNode);
 
 public slots:
-  void onItemDoubleClicked(QTreeWidgetItem * item, int column );
+  void onDoubleClicked(const QModelIndex& index);
+  void onExpanded(const QModelIndex& index);
+  void onCollapsed(const QModelIndex& index);
   
 protected: // events
 
 public:
   Qt::KeyboardModifiers kbdModifiers; // последние модификаторы нажатия клавиши
+
+protected:
+  QSnpTreeModel* pTreeModel;          // модель дерева снепа
 };
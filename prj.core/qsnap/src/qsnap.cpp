@@ -19,6 +19,8 @@
 #include <QTimer>
 #include <QToolBar>
 #include <QAction>
+#include <QHash>
+#include <QPair>
 
 #include <atomic>
 #include <fstream>
@@ -32,6 +34,7 @@
 #include "QSnpToolbarView.h"
 #include "QSnpToolbar.h"
 #include "QSnpListView.h"
+#include "QSnpLogQueue.h"
 
 #include "eventfilters.h"
 #include "thread_safe_queue.h"
@@ -47,6 +50,9 @@ static XThreads::XThread_pool* pThreadPool = nullptr;
 static std::atomic_bool threadMode;
 const int ONE_THREAD = 1;
 
+// Буферы вывода в текстовые окна, создаются в потоке QApplication
+static QSnpLogQueue* pLogQueue = nullptr;
+
 namespace QSnp {
 
 // Выполнение лямбда-функции cmd в потоке QApplication (при threadMode=true).
@@ -55,9 +61,17 @@ namespace QSnp {
 template <typename FunctionType>
 void executeCommand(FunctionType cmd)
 {
+  // накопленный вывод в лог выводится перед командой, чтобы сохранить порядок
+  auto cmdOrdered = [&]()
+  {
+    if (pLogQueue != nullptr && pLogQueue->scheduled())
+      pLogQueue->flush();
+    cmd();
+  };
+
   if (threadMode == true && pThreadPool != nullptr)
   {  
-    pThreadPool->submit(cmd);
+    pThreadPool->submit(cmdOrdered);
     int cntTries = 0;
     while (pThreadPool->empty != true)
     {
@@ -66,7 +80,24 @@ void executeCommand(FunctionType cmd)
     }
   }
   else
-    cmd();
+    cmdOrdered();
+}
+
+// Планирование сброса буферов лога без ожидания: в потоке пула
+// или следующим тактом цикла событий QApplication
+void scheduleLogFlush()
+{
+  if (threadMode == true && pThreadPool != nullptr)
+  {
+    auto cmdFlushLog = []()
+    {
+      if (pLogQueue != nullptr)
+        pLogQueue->flush();
+    };
+    pThreadPool->submit(cmdFlushLog);
+  }
+  else
+    pLogQueue->postFlush();
 }
 
 QHandle impl_Initialize()
@@ -81,6 +112,9 @@ QHandle impl_Initialize()
 #endif
 
   }
+  if (pLogQueue == nullptr)
+    pLogQueue = new QSnpLogQueue;
+
   QSnpInstance* pInstance = new QSnpInstance;
   return (QHandle)pInstance;
 }
@@ -110,6 +144,9 @@ QError impl_Terminate(QHandle hInstance)
   QSnpInstance* pInstance = (QSnpInstance*)hInstance;
   delete pInstance;
 
+  delete pLogQueue;
+  pLogQueue = nullptr;
+
   qSnapQTApplication.reset();
 
   return QERR_NO_ERROR;
@@ -249,6 +286,11 @@ QError impl_DestroyView(QHandle hView)
   pView->saveProperties(sConfig.c_str());
 
   pView->getInstance()->removeView(pView);
+
+  // текст, отправленный окну лога, но еще не выведенный, ссылается на окно
+  if(pView->getViewType() == VT_TEXT_VIEW && pLogQueue != nullptr)
+    pLogQueue->purge(hView);
+
   if(pView->getViewType() != VT_UNDEFINED)
     delete pView;
 
@@ -278,17 +320,17 @@ QSNAP_API QError ShowView(QHandle hView, bool bShow)
   return 1;
 }
 
-// перерисовка прямоугольной зоны окна
-QSNAP_API QError UpdateView
-(
-  QHandle hView,                      // [in]  хэндл окна
-  QSnp::SnpRect* pRect                // [in]  зона для перерисовки
-)
+QError impl_UpdateView(QHandle hView)
 {
-  if(hView == QHANDLE_INVALID)
-    return QERR_ERROR;
-
   QSnpView* pView = (QSnpView*)hView;
+
+  // отложенные строки дерева снепа показываются сразу: без потока QApplication
+  // таймер модели сработал бы только в цикле событий WaitUserInput
+  QSnpInstance* pInstance = pView->getInstance();
+  QSnpTreeView* pTreeView = pInstance ? pInstance->getTreeView() : 0;
+  if(pTreeView && pTreeView->getTreeModel())
+    pTreeView->getTreeModel()->flush();
+
   QWidget* pFrame = pView->getFrameWidget();
   QWidget* pWidget = pView->getWidget();
 
@@ -300,6 +342,28 @@ QSNAP_API QError UpdateView
   return QERR_NO_ERROR;
 }
 
+// перерисовка прямоугольной зоны окна
+QSNAP_API QError UpdateView
+(
+  QHandle hView,                      // [in]  хэндл окна
+  QSnp::SnpRect* pRect                // [in]  зона для перерисовки
+)
+{
+  if(hView == QHANDLE_INVALID)
+    return QERR_ERROR;
+
+  // накопленный вывод в лог сбрасывается в окна перед перерисовкой (см. executeCommand):
+  // без потока QApplication отложенный сброс иначе выполнился бы только в WaitUserInput
+  QError qerr = QERR_ERROR;
+  auto cmdUpdateView = [&]()
+  {
+    qerr = impl_UpdateView(hView);
+  };
+  executeCommand(cmdUpdateView);
+
+  return qerr;
+}
+
 // получение общих свойств окна (координаты и проч.)
 QSNAP_API QError GetViewInfo
 (
@@ -442,12 +506,9 @@ QSNAP_API QSnapNode GetSnapTreeRoot(QHandle hInstance)
 QSnapNode impl_AddNode(QSnapNode hParentNode, NodeInfo* nodeInfo)
 {
   QSnpNode* pParentNode = (QSnpNode*)hParentNode;
+  // окно обновляется отложенной вставкой строк (см. QSnpTreeModel), без перерисовки на каждую вершину
   QSnpNode* pNewNode = pParentNode->addChildNode(*nodeInfo);
 
-  QSnpTreeView* pView = pParentNode->getInstance()->getTreeView();
-  if(pView)
-    pView->getWidget()->repaint();
-
   return (QSnapNode)pNewNode;
 }
 
@@ -483,6 +544,13 @@ QSNAP_API QSnapNode FindNode
   return pNode ? pNode->handle() : QHANDLE_NULL;
 }
 
+// состояние вершины для чтения без вызова библиотеки
+QSNAP_API const SnapState* GetNodeState(QSnapNode hNode)
+{
+  QSnpNode* pNode = (QSnpNode*)hNode;
+  return pNode ? pNode->getState() : 0;
+}
+
 QSNAP_API bool NodeChecked(QSnapNode hNode)
 {
   QSnpNode* pNode = (QSnpNode*)hNode;
@@ -500,7 +568,9 @@ QSNAP_API QError impl_CheckNode(QSnapNode hNode, bool bChecked)
 
   QSnpTreeView* pView = pNode->getInstance() ? pNode->getInstance()->getTreeView() : 0;
   if(pView && pView->getTreeWidget())
-    pView->getTreeWidget()->selectItem(pNode->getTreeWidgetItem(), bChecked, false);
+    pView->getTreeWidget()->selectNode(pNode, bChecked, false);
+  else
+    pNode->setSelected(bChecked);
 
   return QERR_NO_ERROR;
 }
@@ -607,7 +677,7 @@ QSNAP_API int GetNodePropertiesCount // [ret] количество свойст
   if(!pNode)
     return QERR_ERROR;
 
-  return pNode->vProperties.size();
+  return pNode->properties.count();
 }
 
 // получение свойства вершины
@@ -622,11 +692,9 @@ QSNAP_API QError GetNodeProperty
   if(!pNode || !pNodeProperty)
     return QERR_ERROR;
 
-  if(nProperty<0 || nProperty>=pNode->vProperties.size())
+  if(!pNode->properties.get(nProperty, pNodeProperty))
     return QERR_ERROR;
 
-  *pNodeProperty = pNode->vProperties[nProperty];
-
   return QERR_NO_ERROR;
 }
 
@@ -639,17 +707,19 @@ QSNAP_API QError SetNodeProperty
 )
 {
   QSnpNode* pNode = (QSnpNode*)hNode;
-  if(!pNode)
+  if(!pNode || !pNodeProperty)
     return QERR_ERROR;
 
-  if(nProperty<0 || nProperty>=pNode->vProperties.size())
+  if(!pNode->properties.set(nProperty, *pNodeProperty))
     return QERR_ERROR;
 
-  pNode->vProperties[nProperty] = *pNodeProperty;
-
   return QERR_NO_ERROR;
 }
 
+// значения, возвращенные GetNodeValue, по вершине и названию свойства в каждом потоке:
+// строка не меняется при изменении свойства в окне до следующего запроса этого свойства
+static thread_local QHash<QPair<QSnpNode*, QByteArray>, QByteArray> nodeValues;
+
 // получение свойства вершины
 QSNAP_API const char* GetNodeValue   // [ret] значение свойства, NULL если свойство не существует
 (
@@ -658,18 +728,17 @@ QSNAP_API const char* GetNodeValue   // [ret] значение свойства,
 )
 {
   QSnpNode* pNode = (QSnpNode*)hNode;
-  if(!pNode)
-    return QERR_ERROR;
+  if(!pNode || !sKey)
+    return nullptr;
 
-  int nPropCount = pNode->vProperties.size();
-  for(int nProp = 0; nProp<nPropCount; nProp++)
-  {
-    NodePropertyInfo& prop = pNode->vProperties[nProp];
-    if(!strcmp(prop.sKey, sKey))
-      return prop.sValue;
-  }
-  
-  return nullptr;
+  QByteArray text;
+  if(!pNode->properties.value(sKey, text))
+    return nullptr;
+
+  QByteArray& textCopy = nodeValues[qMakePair(pNode, QByteArray(sKey))];
+  if(textCopy != text)
+    textCopy = text;
+  return textCopy.constData();
 }
 
 // установка свойства вершины
@@ -681,25 +750,13 @@ QSNAP_API QError SetNodeValue
 )
 {
   QSnpNode* pNode = (QSnpNode*)hNode;
-  if(!pNode)
+  if(!pNode || !sKey)
     return QERR_ERROR;
 
-  int nPropCount = pNode->vProperties.size();
-  for(int nProp = 0; nProp<nPropCount; nProp++)
-  {
-    NodePropertyInfo& prop = pNode->vProperties[nProp];
-    if(!strcmp(prop.sKey, sKey))
-    {
-      strncpy(prop.sValue,sValue, sizeof(prop.sValue)-1);
-      return QERR_NO_ERROR;    
-    }
-  }
-
-  // если свойство не существует, то добавить его
-  NodePropertyInfo propInfo={0};
-  strncpy(propInfo.sKey, sKey, sizeof(propInfo.sKey)-1);
-  strncpy(propInfo.sValue, sValue, sizeof(propInfo.sValue)-1);
-  pNode->vProperties.push_back(propInfo);
+  // значение приводится к типу свойства; если свойство не существует, то оно добавляется,
+  // неподходящее к типу значение не устанавливается
+  if(pNode->properties.setValue(sKey, sValue))
+    return QERR_NO_ERROR;
 
   return QERR_ERROR;
 }
@@ -712,19 +769,10 @@ QSNAP_API QError RemoveNodeProperty
 )
 {
   QSnpNode* pNode = (QSnpNode*)hNode;
-  if(!pNode)
+  if(!pNode || !sKey)
     return QERR_ERROR;
 
-  QVector<QSnp::NodePropertyInfo> vPropertiesNew;
-  int nPropCount = pNode->vProperties.size();
-  for(int nProp = 0; nProp<nPropCount; nProp++)
-  {
-    NodePropertyInfo& prop = pNode->vProperties[nProp];
-    if(strcmp(prop.sKey, sKey))
-      vPropertiesNew.push_back(prop);
-  }
-
-  pNode->vProperties = vPropertiesNew;
+  pNode->properties.remove(sKey);
 
   return QERR_NO_ERROR;
 }
@@ -739,7 +787,7 @@ QSNAP_API QError RemoveAllNodeProperties
   if(!pNode)
     return QERR_ERROR;
 
-  pNode->vProperties.clear();
+  pNode->properties.removeAll(false);
   return QERR_NO_ERROR;
 }
 
@@ -753,8 +801,8 @@ QSNAP_API QError LoadNodeProperties
   if(!pNode)
     return QERR_ERROR;
 
-  pNode->vProperties.clear();
-
+  // свойства с описанным типом остаются, загруженные значения приводятся к их типу
+  pNode->properties.removeAll(true);
 
   QSettings sett("QSnap");
   QString sTreeViewId = pNode->getInstance()->getTreeView()->getId();
@@ -765,12 +813,7 @@ QSNAP_API QError LoadNodeProperties
   foreach(QString k, keys)
   {
     QString v = sett.value(k).toString();
-
-    NodePropertyInfo propInfo={0};
-    strncpy(propInfo.sKey, k.toStdString().c_str(),sizeof(propInfo.sKey)-1);
-    strncpy(propInfo.sValue, v.toStdString().c_str(),sizeof(propInfo.sValue)-1);
-
-    pNode->vProperties.push_back(propInfo);
+    pNode->properties.setValue(k.toStdString().c_str(), v.toStdString().c_str());
   }
   
   sett.endGroup();
@@ -794,11 +837,12 @@ QSNAP_API QError SaveNodeProperties
 
   sett.beginGroup(sGroup);
 
-  int nPropCount = pNode->vProperties.size();
+  NodePropertyInfo prop;
+  int nPropCount = pNode->properties.count();
   for(int nProp = 0; nProp<nPropCount; nProp++)
   {
-    NodePropertyInfo& prop = pNode->vProperties[nProp];
-    sett.setValue(QString(prop.sKey), QString(prop.sValue));
+    if(pNode->properties.get(nProp, &prop))
+      sett.setValue(QString(prop.sKey), QString(prop.sValue));
   }
 
   sett.endGroup();
@@ -848,19 +892,83 @@ QSNAP_API QError SaveNodeProperty
 
   sett.beginGroup(sGroup);
 
-  int nPropCount = pNode->vProperties.size();
-  for(int nProp = 0; nProp<nPropCount; nProp++)
-  {
-    NodePropertyInfo& prop = pNode->vProperties[nProp];
-    if(!strcmp(pNode->vProperties[nProp].sKey, sKey))
-      sett.setValue(QString(prop.sKey), QString(prop.sValue));
-  }
+  QByteArray text;
+  if(pNode->properties.value(sKey, text))
+    sett.setValue(QString(sKey), QString(text));
 
   sett.endGroup();
 
   return QERR_NO_ERROR;
 }
 
+// описание типизированного свойства вершины
+QSNAP_API QError DefineNodeProperty
+(
+  QSnapNode hNode,                   // [in]  хэндл вершины
+  const PropertyDef* pDef            // [in]  описание свойства
+)
+{
+  QSnpNode* pNode = (QSnpNode*)hNode;
+  if(!pNode || !pDef || !pDef->sKey)
+    return QERR_ERROR;
+
+  pNode->properties.define(*pDef);
+  return QERR_NO_ERROR;
+}
+
+// типизированное значение свойства для чтения без вызова библиотеки
+// (создается при первом запросе, в том числе для еще не добавленного свойства)
+QSNAP_API const PropValue* GetNodePropertyValue
+(
+  QSnapNode hNode,                   // [in]  хэндл вершины
+  const char* sKey                   // [in]  название свойства
+)
+{
+  QSnpNode* pNode = (QSnpNode*)hNode;
+  if(!pNode || !sKey)
+    return nullptr;
+
+  return pNode->properties.typedValue(sKey);
+}
+
+// счетчик изменений свойств вершины
+QSNAP_API const std::atomic<unsigned>* GetNodePropertiesVersion
+(
+  QSnapNode hNode                    // [in]  хэндл вершины
+)
+{
+  QSnpNode* pNode = (QSnpNode*)hNode;
+  if(!pNode)
+    return nullptr;
+
+  return pNode->properties.version();
+}
+
+// связывание свойства вершины с переменной приложения
+QSNAP_API QError BindNodeProperty
+(
+  QSnapNode hNode,                   // [in]  хэндл вершины
+  const char* sKey,                  // [in]  название свойства
+  SnpBindType type,                  // [in]  тип переменной
+  void* pVar                         // [in]  адрес переменной (NULL - отмена связи)
+)
+{
+  QSnpNode* pNode = (QSnpNode*)hNode;
+  if(!pNode || !sKey)
+    return QERR_ERROR;
+
+  pNode->properties.bind(sKey, type, pVar);
+  return QERR_NO_ERROR;
+}
+
+// запись измененных значений свойств в связанные переменные
+QSNAP_API int ApplyNodeBindings     // [ret] количество записанных значений
+(
+)
+{
+  return QSnpBindingQueue::instance().apply();
+}
+
 // вывод текстового сообщения в виде отдельной строки
 QSNAP_API QError impl_LogView(QHandle hView, const char* strbuf)
 {
@@ -870,42 +978,119 @@ QSNAP_API QError impl_LogView(QHandle hView, const char* strbuf)
   return QERR_NO_ERROR;
 }
 
+// вывод текста в буфер потока; в окно текст попадает одним блоком за такт
+// после добавления в буфер потока: планирование сброса или ожидание при переполнении
+void afterLogQueued(size_t nBytes)
+{
+  if(nBytes > QSNP_LOG_QUEUE_MAX_BYTES)
+  {
+    // производитель опережает вывод: ожидание сброса
+    auto cmdFlushLog = [&]()
+    {
+      pLogQueue->flush();
+    };
+    executeCommand(cmdFlushLog);
+  }
+  else if(pLogQueue->schedule())
+    scheduleLogFlush();
+}
+
+// форматирование сообщения: короткие - в буфер на стеке, длинные - в буфер нужного размера
+QError queueLogV(QHandle hView, const char* sText, va_list list, bool bNewLine, unsigned int attr = 0)
+{
+  if(pLogQueue == nullptr)
+    return QERR_ERROR;
+
+  char strbuf[4096];
+  va_list listCopy;
+  va_copy(listCopy, list);
+  int len = vsnprintf(strbuf, sizeof(strbuf) - 1, sText, listCopy);
+  va_end(listCopy);
+  if(len < 0)
+    return QERR_ERROR;
+
+  std::vector<char> strLong;
+  char* pText = strbuf;
+  if(len >= (int)sizeof(strbuf) - 1)
+  {
+    strLong.resize(len + 2);
+    vsnprintf(&strLong[0], len + 1, sText, list);
+    pText = &strLong[0];
+  }
+  if(bNewLine)
+    pText[len++] = '\n';
+  pText[len] = 0;
+
+  afterLogQueued(pLogQueue->append(hView, pText, attr));
+  return QERR_NO_ERROR;
+}
+
 QSNAP_API QError Log(QHandle hView, const char* sText, ...)
 {
-  char strbuf[4096]; strbuf[0]=0;
   va_list list;
   va_start(list, sText );
-  vsprintf( strbuf, sText, list );
+  QError qerr = queueLogV(hView, sText, list, false);
   va_end( list );
-
-  QError qerr = QERR_NO_ERROR;
-  auto cmdLogView = [&]()
-  { 
-    qerr = impl_LogView(hView, strbuf); 
-  };
-  executeCommand(cmdLogView);
-  return QERR_NO_ERROR;
+  return qerr;
 }
 
 // вывод текстового сообщения в виде отдельной строки
 QSNAP_API QError LogLn(QHandle hView, const char* sText, ...)
 {
-  char strbuf[4096]; strbuf[0]=0;
   va_list list;
   va_start(list, sText );
-  vsprintf( strbuf, sText, list );
-  strcat(strbuf,"\n");
+  QError qerr = queueLogV(hView, sText, list, true);
   va_end( list );
+  return qerr;
+}
 
-  QError qerr = QERR_NO_ERROR;
-  auto cmdLogViewLn = [&]()
-  {
-    qerr = impl_LogView(hView, strbuf); 
-  };
-  executeCommand(cmdLogViewLn);
+// вывод текстового сообщения уровня level в виде отдельной строки (строка оформляется по уровню)
+QSNAP_API QError LogLnAt(QHandle hView, LogLevel level, const char* sText, ...)
+{
+  va_list list;
+  va_start(list, sText );
+  QError qerr = queueLogV(hView, sText, list, true, QSnpLogModel::makeAttr(false, 0, 0, level));
+  va_end( list );
   return qerr;
 }
 
+// отложенный вывод: строка формата и аргументы записываются в буфер потока,
+// форматирование выполняется в потоке QApplication при выводе в окно
+QSNAP_API QError LogArgs
+(
+  QHandle       hView,               // [in]  хэндл окна
+  const char*   sFormat,             // [in]  строка формата printf (должна существовать до вывода, обычно литерал)
+  const LogArg* args,                // [in]  аргументы
+  int           nArgs,               // [in]  количество аргументов
+  bool          bNewLine             // [in]  завершить сообщение переводом строки
+)
+{
+  if(pLogQueue == nullptr || !sFormat || (nArgs > 0 && !args))
+    return QERR_ERROR;
+
+  afterLogQueued(pLogQueue->appendFormat(hView, sFormat, args, nArgs, bNewLine));
+  return QERR_NO_ERROR;
+}
+
+// отложенный вывод сообщения уровня level (строка оформляется по уровню)
+QSNAP_API QError LogArgsAt
+(
+  QHandle       hView,               // [in]  хэндл окна
+  LogLevel      level,               // [in]  уровень сообщения LL_*
+  const char*   sFormat,             // [in]  строка формата printf (должна существовать до вывода, обычно литерал)
+  const LogArg* args,                // [in]  аргументы
+  int           nArgs,               // [in]  количество аргументов
+  bool          bNewLine             // [in]  завершить сообщение переводом строки
+)
+{
+  if(pLogQueue == nullptr || !sFormat || (nArgs > 0 && !args))
+    return QERR_ERROR;
+
+  unsigned int attr = QSnpLogModel::makeAttr(false, 0, 0, level);
+  afterLogQueued(pLogQueue->appendFormat(hView, sFormat, args, nArgs, bNewLine, attr));
+  return QERR_NO_ERROR;
+}
+
 QSNAP_API QError LogEx
 (
   QHandle     hView,                 // [in]  хэндл окна
@@ -914,7 +1099,12 @@ QSNAP_API QError LogEx
   FontFlags   flags                  // [in]  параметры шрифта
 )
 {
-  return Log(hView, sText);
+  if(pLogQueue == nullptr || !sText)
+    return QERR_ERROR;
+
+  // цвет и шрифт передаются атрибутами строк вместе с текстом, без разметки
+  afterLogQueued(pLogQueue->append(hView, sText, QSnpLogModel::makeAttr(true, color, flags, -1)));
+  return QERR_NO_ERROR;
 }
 
 QSNAP_API QError impl_ClearTextView
@@ -943,120 +1133,310 @@ QSNAP_API QError ClearTextView
   return qerr;
 }
 
-// установка изображения
-QSNAP_API QError impl_SetImage
+QSNAP_API QError impl_SetLogLimits
   (
   QHandle     hView,                 // [in]  хэндл окна
-  const char* sFileName,             // [in]  файл изображения
-  ImageFlags  flagsShow              // [in]  флаги показа изображения
+  int         maxLines,              // [in]  максимальное количество строк (0 - по умолчанию)
+  long long   maxBytes               // [in]  максимальный объем текста в байтах (0 - по умолчанию)
   )
 {
   if(hView==QHANDLE_INVALID)
     return QERR_ERROR;
-  QSnpImageView* pView = (QSnpImageView*)hView;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_TEXT_VIEW)
+    return QERR_ERROR;
 
-  bool bRepaint = !(flagsShow & IF_DONT_REPAINT);
-  pView->setImage(sFileName, bRepaint);
+  QSnpTextView* pText = (QSnpTextView*)pView;
+  pText->SetLimits(maxLines, maxBytes);
 
   return QERR_NO_ERROR;
 }
 
-// установка изображения
-QSNAP_API QError SetImage
+// ограничение объема текстового окна: при превышении вытесняются старые строки
+QSNAP_API QError SetLogLimits
 (
   QHandle     hView,                 // [in]  хэндл окна
-  const char* sFileName,             // [in]  файл изображения
-  ImageFlags  flagsShow              // [in]  флаги показа изображения
+  int         maxLines,              // [in]  максимальное количество строк (0 - по умолчанию)
+  long long   maxBytes               // [in]  максимальный объем текста в байтах (0 - по умолчанию)
 )
 {
   QError qerr = QERR_NO_ERROR;
-  auto cmdSetImage = [&]()
+  auto cmdSetLogLimits = [&]()
   {
-    qerr = impl_SetImage(hView, sFileName, flagsShow); 
+    qerr = impl_SetLogLimits(hView, maxLines, maxBytes);
   };
-  executeCommand(cmdSetImage);
+  executeCommand(cmdSetLogLimits);
   return qerr;
 }
 
-// установка изображения
-QSNAP_API QError impl_SetSubImage
+QSNAP_API QError impl_SetLogSpill
   (
   QHandle     hView,                 // [in]  хэндл окна
-  const char* sFileName,             // [in]  файл изображения
-  int         nSubView,              // [in]  номер внутреннего окна (для SynqImageView и проч.)
-  ImageFlags  flagsShow              // [in]  флаги показа изображения
+  const char* sDir,                  // [in]  каталог файлов выгрузки (NULL или "" - выключить)
+  long long   segmentBytes,          // [in]  размер файла-сегмента (0 - по умолчанию)
+  int         maxSegments            // [in]  максимальное количество сегментов (0 - без ограничения)
   )
 {
   if(hView==QHANDLE_INVALID)
     return QERR_ERROR;
   QSnpView* pView = (QSnpView*)hView;
-  if(pView->getViewType()!=VT_SYNC_IMAGE_VIEW)
+  if(pView->getViewType()!=VT_TEXT_VIEW)
     return QERR_ERROR;
 
-  QSnpSyncImageView* pSyncView = (QSnpSyncImageView*)pView;
-  pSyncView->setSubImage(sFileName, nSubView);
+  QSnpTextView* pText = (QSnpTextView*)pView;
+  pText->SetSpill(sDir, segmentBytes, maxSegments);
+
   return QERR_NO_ERROR;
 }
 
-// установка изображения
-QSNAP_API QError SetSubImage
+// выгрузка вытесненных строк текстового окна в отображаемые в память файлы-сегменты
+// с ротацией по размеру; запись выполняет фоновый поток, окно читает строки при прокрутке
+QSNAP_API QError SetLogSpill
 (
   QHandle     hView,                 // [in]  хэндл окна
-  const char* sFileName,             // [in]  файл изображения
-  int         nSubView,              // [in]  номер внутреннего окна (для SynqImageView и проч.)
-  ImageFlags  flagsShow              // [in]  флаги показа изображения
+  const char* sDir,                  // [in]  каталог файлов выгрузки (NULL или "" - выключить)
+  long long   segmentBytes,          // [in]  размер файла-сегмента (0 - по умолчанию)
+  int         maxSegments            // [in]  максимальное количество сегментов (0 - без ограничения)
 )
 {
   QError qerr = QERR_NO_ERROR;
-  auto cmdSetSubImage = [&]()
+  auto cmdSetLogSpill = [&]()
   {
-    qerr = impl_SetSubImage(hView, sFileName, nSubView, flagsShow); 
+    qerr = impl_SetLogSpill(hView, sDir, segmentBytes, maxSegments);
   };
-  executeCommand(cmdSetSubImage);
+  executeCommand(cmdSetLogSpill);
   return qerr;
 }
 
-// установка изображения
-QSNAP_API QError impl_SetMatImage
+// фильтр уровня и каналов текстового окна
+QSNAP_API const LogFilter* GetLogFilter
+(
+  QHandle     hView                  // [in]  хэндл окна
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return NULL;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_TEXT_VIEW)
+    return NULL;
+
+  // фильтр состоит из атомарных полей и не требует перехода в поток QApplication
+  return ((QSnpTextView*)pView)->getFilter();
+}
+
+QSNAP_API int impl_RegisterLogChannel
   (
-  QHandle         hView,              // [in]  хэндл окна
-  const cv::Mat*  pImage,             // [in]  изображение cv::Mat
-  ImageFlags      flagsShow           // [in]  флаги показа изображения
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sName,                 // [in]  имя канала
+  bool        bEnabled               // [in]  начальное состояние канала
   )
 {
-  if(hView==QHANDLE_INVALID || !pImage)
-    return QERR_ERROR;
-  QSnpImageView* pView = (QSnpImageView*)hView;
-
-  bool bRepaint = !(flagsShow & IF_DONT_REPAINT);
-  pView->setImage(*pImage, bRepaint);
+  if(hView==QHANDLE_INVALID || !sName)
+    return -1;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_TEXT_VIEW)
+    return -1;
 
-  return QERR_NO_ERROR;
+  return ((QSnpTextView*)pView)->RegisterChannel(sName, bEnabled);
 }
 
-// установка изображения
-QSNAP_API QError SetMatImage
+// регистрация именованного канала лога
+QSNAP_API int RegisterLogChannel
 (
-  QHandle         hView,              // [in]  хэндл окна
-  const cv::Mat*  pImage,             // [in]  изображение cv::Mat
-  ImageFlags      flagsShow           // [in]  флаги показа изображения
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sName,                 // [in]  имя канала
+  bool        bEnabled               // [in]  начальное состояние канала
 )
 {
-  QError qerr = QERR_NO_ERROR;
-  auto cmdSetMatImage = [&]()
+  int channel = -1;
+  auto cmdRegisterLogChannel = [&]()
   {
-    qerr = impl_SetMatImage(hView, pImage, flagsShow); 
+    channel = impl_RegisterLogChannel(hView, sName, bEnabled);
   };
-  executeCommand(cmdSetMatImage);
-  return qerr;
+  executeCommand(cmdRegisterLogChannel);
+  return channel;
 }
 
-QSNAP_API QError impl_SetSubMatImage
+QSNAP_API QError impl_EnableLogChannel
   (
-  QHandle       hView,               // [in]  хэндл окна
-  const cv::Mat*  pImage,            // [in]  изображение cv::Mat
-  int           nSubView,            // [in]  номер внутреннего окна (для SynqImageView и проч.)
-  ImageFlags    flagsShow            // [in]  флаги показа изображения
+  QHandle     hView,                 // [in]  хэндл окна
+  int         channel,               // [in]  номер канала
+  bool        bEnable                // [in]  включить канал
+  )
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_TEXT_VIEW || channel < 0 || channel >= LOG_MAX_CHANNELS)
+    return QERR_ERROR;
+
+  ((QSnpTextView*)pView)->EnableChannel(channel, bEnable);
+  return QERR_NO_ERROR;
+}
+
+// включение/отключение канала лога
+QSNAP_API QError EnableLogChannel
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  int         channel,               // [in]  номер канала
+  bool        bEnable                // [in]  включить канал
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdEnableLogChannel = [&]()
+  {
+    qerr = impl_EnableLogChannel(hView, channel, bEnable);
+  };
+  executeCommand(cmdEnableLogChannel);
+  return qerr;
+}
+
+QSNAP_API QError impl_SetLogLevel
+  (
+  QHandle     hView,                 // [in]  хэндл окна
+  LogLevel    level                  // [in]  уровень LL_*
+  )
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_TEXT_VIEW)
+    return QERR_ERROR;
+
+  ((QSnpTextView*)pView)->SetLevel(level);
+  return QERR_NO_ERROR;
+}
+
+// установка минимального уровня выводимых сообщений
+QSNAP_API QError SetLogLevel
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  LogLevel    level                  // [in]  уровень LL_*
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdSetLogLevel = [&]()
+  {
+    qerr = impl_SetLogLevel(hView, level);
+  };
+  executeCommand(cmdSetLogLevel);
+  return qerr;
+}
+
+// установка изображения
+QSNAP_API QError impl_SetImage
+  (
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sFileName,             // [in]  файл изображения
+  ImageFlags  flagsShow              // [in]  флаги показа изображения
+  )
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+  QSnpImageView* pView = (QSnpImageView*)hView;
+
+  bool bRepaint = !(flagsShow & IF_DONT_REPAINT);
+  pView->setImage(sFileName, bRepaint);
+
+  return QERR_NO_ERROR;
+}
+
+// установка изображения
+QSNAP_API QError SetImage
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sFileName,             // [in]  файл изображения
+  ImageFlags  flagsShow              // [in]  флаги показа изображения
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdSetImage = [&]()
+  {
+    qerr = impl_SetImage(hView, sFileName, flagsShow); 
+  };
+  executeCommand(cmdSetImage);
+  return qerr;
+}
+
+// установка изображения
+QSNAP_API QError impl_SetSubImage
+  (
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sFileName,             // [in]  файл изображения
+  int         nSubView,              // [in]  номер внутреннего окна (для SynqImageView и проч.)
+  ImageFlags  flagsShow              // [in]  флаги показа изображения
+  )
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_SYNC_IMAGE_VIEW)
+    return QERR_ERROR;
+
+  QSnpSyncImageView* pSyncView = (QSnpSyncImageView*)pView;
+  pSyncView->setSubImage(sFileName, nSubView);
+  return QERR_NO_ERROR;
+}
+
+// установка изображения
+QSNAP_API QError SetSubImage
+(
+  QHandle     hView,                 // [in]  хэндл окна
+  const char* sFileName,             // [in]  файл изображения
+  int         nSubView,              // [in]  номер внутреннего окна (для SynqImageView и проч.)
+  ImageFlags  flagsShow              // [in]  флаги показа изображения
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdSetSubImage = [&]()
+  {
+    qerr = impl_SetSubImage(hView, sFileName, nSubView, flagsShow); 
+  };
+  executeCommand(cmdSetSubImage);
+  return qerr;
+}
+
+// установка изображения
+QSNAP_API QError impl_SetMatImage
+  (
+  QHandle         hView,              // [in]  хэндл окна
+  const cv::Mat*  pImage,             // [in]  изображение cv::Mat
+  ImageFlags      flagsShow           // [in]  флаги показа изображения
+  )
+{
+  if(hView==QHANDLE_INVALID || !pImage)
+    return QERR_ERROR;
+  QSnpImageView* pView = (QSnpImageView*)hView;
+
+  bool bRepaint = !(flagsShow & IF_DONT_REPAINT);
+  pView->setImage(*pImage, bRepaint);
+
+  return QERR_NO_ERROR;
+}
+
+// установка изображения
+QSNAP_API QError SetMatImage
+(
+  QHandle         hView,              // [in]  хэндл окна
+  const cv::Mat*  pImage,             // [in]  изображение cv::Mat
+  ImageFlags      flagsShow           // [in]  флаги показа изображения
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdSetMatImage = [&]()
+  {
+    qerr = impl_SetMatImage(hView, pImage, flagsShow); 
+  };
+  executeCommand(cmdSetMatImage);
+  return qerr;
+}
+
+QSNAP_API QError impl_SetSubMatImage
+  (
+  QHandle       hView,               // [in]  хэндл окна
+  const cv::Mat*  pImage,            // [in]  изображение cv::Mat
+  int           nSubView,            // [in]  номер внутреннего окна (для SynqImageView и проч.)
+  ImageFlags    flagsShow            // [in]  флаги показа изображения
   )
 {
   if(hView==QHANDLE_INVALID)
@@ -1088,6 +1468,82 @@ QSNAP_API QError SetSubMatImage
   return qerr;
 }
 
+QSNAP_API QError impl_SetMatches
+  (
+  QHandle       hView,               // [in]  хэндл окна
+  const SnpPoint* ptsFrom,           // [in]  точки первого окна
+  const SnpPoint* ptsTo,             // [in]  точки второго окна
+  const float*  scores,              // [in]  оценки соответствий (NULL - без оценок)
+  const SnpColor* colors,            // [in]  цвета соответствий (NULL - цвет color)
+  int           nMatches,            // [in]  количество соответствий
+  int           lineWidth,           // [in]  толщина линий
+  SnpColor      color                // [in]  цвет по умолчанию
+  )
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_SYNC_IMAGE_VIEW)
+    return QERR_ERROR;
+
+  QSnpSyncImageView* pSyncView = (QSnpSyncImageView*)pView;
+  return pSyncView->setMatches(ptsFrom, ptsTo, scores, colors, nMatches, lineWidth, color);
+}
+
+// установка соответствий точек двух окон SyncImageView
+QSNAP_API QError SetMatches
+(
+  QHandle       hView,               // [in]  хэндл окна
+  const SnpPoint* ptsFrom,           // [in]  точки первого окна
+  const SnpPoint* ptsTo,             // [in]  точки второго окна
+  const float*  scores,              // [in]  оценки соответствий (NULL - без оценок)
+  const SnpColor* colors,            // [in]  цвета соответствий (NULL - цвет color)
+  int           nMatches,            // [in]  количество соответствий
+  int           lineWidth,           // [in]  толщина линий
+  SnpColor      color                // [in]  цвет по умолчанию
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdSetMatches = [&]()
+  {
+    qerr = impl_SetMatches(hView, ptsFrom, ptsTo, scores, colors, nMatches, lineWidth, color);
+  };
+  executeCommand(cmdSetMatches);
+  return qerr;
+}
+
+QSNAP_API QError impl_SetMatchThreshold
+  (
+  QHandle       hView,               // [in]  хэндл окна
+  float         threshold            // [in]  показываются соответствия с оценкой >= threshold
+  )
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+  QSnpView* pView = (QSnpView*)hView;
+  if(pView->getViewType()!=VT_SYNC_IMAGE_VIEW)
+    return QERR_ERROR;
+
+  QSnpSyncImageView* pSyncView = (QSnpSyncImageView*)pView;
+  return pSyncView->setMatchThreshold(threshold);
+}
+
+// установка порога оценки показываемых соответствий
+QSNAP_API QError SetMatchThreshold
+(
+  QHandle       hView,               // [in]  хэндл окна
+  float         threshold            // [in]  показываются соответствия с оценкой >= threshold
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdSetMatchThreshold = [&]()
+  {
+    qerr = impl_SetMatchThreshold(hView, threshold);
+  };
+  executeCommand(cmdSetMatchThreshold);
+  return qerr;
+}
+
 #ifdef __MINIMG__
 
 // установка изображения хранимого в MinImg
@@ -1277,246 +1733,689 @@ QSNAP_API void ClearListView
   pView->Clear();
 }
 
-// номер элемента с данным текстом
-QSNAP_API int GetListViewRow
+// номер элемента с данным текстом
+QSNAP_API int GetListViewRow
+(
+  QHandle       hView,               // [in]  хэндл окна
+  const char*   text,                // [in]  текст элемента
+  int           rowStart             // [in]  начальный элемент поиска
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpListView* pView = (QSnpListView*)hView;
+  return pView->Row(text, rowStart);
+}
+
+// номер селектированного элемента
+QSNAP_API int GetListViewCurrentRow
+(
+  QHandle       hView                // [in]  хэндл окна
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return -1;
+
+  QSnpListView* pView = (QSnpListView*)hView;
+  return pView->GetCurrentRow();
+}
+
+// установить селекцию на элемент с номером raw
+QSNAP_API void SetListViewCurrentRow
+(
+  QHandle       hView,               // [in]  хэндл окна
+  int           row                  // [in]  номер элемента
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return;
+
+  QSnpListView* pView = (QSnpListView*)hView;
+  pView->SetCurrentRow(row);
+}
+
+// установить селекцию на элемент с номером raw
+QSNAP_API void SetListViewSortingEnabled
+(
+  QHandle       hView,               // [in]  хэндл окна
+  bool          enable               // [in]  разрешить сортировку
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return;
+
+  QSnpListView* pView = (QSnpListView*)hView;
+  pView->SetSortingEnabled(enable);
+}
+
+// номер элемента с данным текстом
+QSNAP_API void SortListViewItems
+(
+  QHandle       hView,               // [in]  хэндл окна
+  bool          orderAcsending       // [in]  сортировка по возростанию / по убыванию 
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return;
+
+  QSnpListView* pView = (QSnpListView*)hView;
+  pView->SortItems(orderAcsending);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+////  Отрисовка фигур 
+
+// установка коэффициента масштабирования фигур в координатах изображения
+QSNAP_API QHandle SetScaleFactor
+(
+  QHandle       hView,              // [in] хэндл окна
+  double        scale,              // [in] коэффициент масштабирования
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->setScaleFactor(scale, idGroup);
+}
+
+// установка преобразования группы фигур
+QSNAP_API QError SetGroupTransform
+(
+  QHandle       hView,              // [in] хэндл окна
+  double        scale,              // [in] коэффициент масштабирования
+  double        dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+  double        dy,                 // [in] сдвиг по вертикали (в координатах изображения)
+  double        rotation,           // [in] поворот, градусы (по часовой стрелке на экране)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->setGroupTransform(scale, dx, dy, rotation, idGroup);
+}
+
+// отрисовка точки
+QSNAP_API QHandle DrawPoint         // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  int           x,                  // [in] координата по горизонтали
+  int           y,                  // [in] координата по вертикали
+  int           ptWidth,            // [in] толщина точки (диаметр)
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup             // [in] идентификатор группы фигур (для совместной работы)
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addPoint(x, y, ptWidth, color, idGroup);
+}
+
+// отрисовка линии
+QSNAP_API QHandle DrawLine          // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  int           xFrom,              // [in] координата начала по горизонтали
+  int           yFrom,              // [in] координата начала по вертикали
+  int           xTo,                // [in] координата конца по горизонтали
+  int           yTo,                // [in] координата конца по вертикали
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, стрелка, пунктир и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addLine(xFrom, yFrom, xTo, yTo, lineWidth, color, type, idGroup);
+}
+
+// отрисовка прямоугольника
+QSNAP_API QHandle DrawRect          // [ret] хэндл фигуры
+(
+  QHandle         hView,            // [in] хэндл окна
+  QSnp::SnpRect*  pRect,            // [in] координаты прямоугольника
+  int             lineWidth,        // [in] толщина линии
+  SnpColor        color,            // [in] цвет
+  LineType        type,             // [in] тип линии (линия, пунктир и т.д.)
+  const char*     idGroup           // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addRect(pRect, lineWidth, color, type, idGroup);
+}
+
+// отрисовка прямоугольника
+QSNAP_API QHandle DrawEllipse       // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  QSnp::SnpRect* pRect,             // [in] координаты прямоугольника
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addEllipse(pRect, lineWidth, color, type, idGroup);
+}
+
+// отрисовка многоугольника, ломанной
+QSNAP_API QHandle DrawPolygon       // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  SnpPoint*     points,             // [in] массив точек многоугольника 
+  int*          szPoints,           // [in,out] размер массива точек
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  PolygonType   type,               // [in] тип многоугольника (ломаная, замкнутый и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID || !szPoints)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addPolygon(points, *szPoints, lineWidth, color, type, idGroup);
+}
+
+// отрисовка дуги эллипса
+QSNAP_API QHandle DrawArc           // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  SnpRect*      pRect,              // [in] координаты охватывающего прямоугольника эллипса
+  double        startAngle,         // [in] начальный угол дуги
+  double        spanAngle,          // [in] угловой размер дуги
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addArc(pRect, startAngle, spanAngle, lineWidth, color, type, idGroup);
+}
+
+// отрисовка текста
+QSNAP_API QHandle DrawText          // [ret] хэндл текста
+(
+  QHandle       hView,              // [in] хэндл окна
+  SnpRect*      pRect,              // [in] координаты охватывающего прямоугольника
+  const char*   textValue,          // [in] текстовое значение
+  double        fontSize,           // [in] кегль шрифта
+  SnpColor      fontColor,          // [in] цвет шрифта
+  const char*   fontType,           // [in] тип шрифта
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addText(pRect, textValue, fontSize, fontColor, fontType, idGroup);
+}
+
+// отрисовка массива точек одной фигурой
+QSNAP_API QHandle DrawPoints        // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] массив точек
+  int           nPoints,            // [in] количество точек
+  int           ptWidth,            // [in] толщина точки (диаметр)
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addPoints(points, nPoints, ptWidth, color, idGroup);
+}
+
+// отрисовка массива линий одной фигурой
+QSNAP_API QHandle DrawLines         // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] пары точек (начало, конец), 2*nLines элементов
+  int           nLines,             // [in] количество линий
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addLines(points, nLines, lineWidth, color, type, idGroup);
+}
+
+// отрисовка массива прямоугольников одной фигурой
+QSNAP_API QHandle DrawRects         // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpRect* rects,             // [in] массив прямоугольников
+  int           nRects,             // [in] количество прямоугольников
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addRects(rects, nRects, lineWidth, color, type, idGroup);
+}
+
+// отрисовка набора ломаных (контуров) одной фигурой
+QSNAP_API QHandle DrawPolylines     // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] точки всех ломаных подряд
+  const int*    szPolylines,        // [in] количество точек в каждой ломаной
+  int           nPolylines,         // [in] количество ломаных
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  PolygonType   type,               // [in] тип (замкнутый многоугольник, ломаная)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addPolylines(points, szPolylines, nPolylines, lineWidth, color, type, idGroup);
+}
+
+// отрисовка облака точек одной фигурой
+QSNAP_API QHandle DrawPointCloud    // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] массив точек
+  int           nPoints,            // [in] количество точек
+  int           ptWidth,            // [in] размер пятна точки (для PC_SPLAT)
+  SnpColor      color,              // [in] цвет
+  PointCloudType type,              // [in] режим отрисовки (плотность, пятна)
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addPointCloud(points, nPoints, ptWidth, color, type, idGroup);
+}
+
+// отрисовка траектории
+QSNAP_API QHandle DrawTrajectory    // [ret] хэндл фигуры
+(
+  QHandle       hView,              // [in] хэндл окна
+  const SnpPoint* points,           // [in] начальные точки (может быть NULL)
+  int           nPoints,            // [in] количество точек
+  int           maxLength,          // [in] максимальное количество точек (0 - без ограничения)
+  int           lineWidth,          // [in] толщина линии
+  SnpColor      color,              // [in] цвет
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  if(hView==QHANDLE_INVALID)
+    return QHANDLE_INVALID;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->addTrajectory(points, nPoints, maxLength, lineWidth, color, idGroup);
+}
+
+QError impl_AppendPoint(QHandle hFigure, int x, int y)
+{
+  QSnpFigure* pFigure = QSnpFigureTable::find(hFigure);
+  if(!pFigure || pFigure->getType()!=SFT_TRAJECTORY)
+    return QERR_ERROR;
+
+  ((QSnpTrajectory*)pFigure)->appendPoint(QPoint(x, y));
+  return QERR_NO_ERROR;
+}
+
+// добавление точки в конец траектории
+QSNAP_API QError AppendPoint
+(
+  QHandle       hFigure,            // [in] хэндл траектории (DrawTrajectory)
+  int           x,                  // [in] координата по горизонтали
+  int           y                   // [in] координата по вертикали
+)
+{
+  QError qerr = QERR_ERROR;
+  auto cmdAppendPoint = [&]()
+  {
+    qerr = impl_AppendPoint(hFigure, x, y);
+  };
+  executeCommand(cmdAppendPoint);
+  return qerr;
+}
+
+// установка полупрозрачного оверлея изображения
+QSNAP_API QError impl_SetOverlayMat
+  (
+  QHandle       hView,              // [in] хэндл окна
+  const cv::Mat* pMat,              // [in] матрица оверлея (размер изображения)
+  OverlayColormap colormap,         // [in] палитра
+  const SnpColor* pLut,             // [in] собственная палитра из 256 цветов (NULL - палитра colormap)
+  double        alpha,              // [in] непрозрачность 0..1
+  const char*   idGroup             // [in] идентификатор группы фигур
+  )
+{
+  if(hView==QHANDLE_INVALID)
+    return QERR_ERROR;
+
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->setOverlayMat(pMat ? *pMat : cv::Mat(), colormap, pLut, alpha, idGroup);
+}
+
+// установка полупрозрачного оверлея изображения
+QSNAP_API QError SetOverlayMat
+(
+  QHandle       hView,              // [in] хэндл окна
+  const cv::Mat* pMat,              // [in] матрица оверлея (размер изображения)
+  OverlayColormap colormap,         // [in] палитра
+  const SnpColor* pLut,             // [in] собственная палитра из 256 цветов (NULL - палитра colormap)
+  double        alpha,              // [in] непрозрачность 0..1
+  const char*   idGroup             // [in] идентификатор группы фигур
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdSetOverlayMat = [&]()
+  {
+    qerr = impl_SetOverlayMat(hView, pMat, colormap, pLut, alpha, idGroup);
+  };
+  executeCommand(cmdSetOverlayMat);
+  return qerr;
+}
+
+// показ/скрытие класса (значения) оверлея изображения
+QSNAP_API QError SetOverlayClassVisible
 (
-  QHandle       hView,               // [in]  хэндл окна
-  const char*   text,                // [in]  текст элемента
-  int           rowStart             // [in]  начальный элемент поиска
+  QHandle       hView,              // [in] хэндл окна
+  int           label,              // [in] значение (индекс палитры)
+  bool          bShow,              // [in] показать/скрыть
+  const char*   idGroup             // [in] идентификатор группы фигур
 )
 {
   if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
+    return QERR_ERROR;
 
-  QSnpListView* pView = (QSnpListView*)hView;
-  return pView->Row(text, rowStart);
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->setOverlayClassVisible(label, bShow, idGroup);
 }
 
-// номер селектированного элемента
-QSNAP_API int GetListViewCurrentRow
-(
-  QHandle       hView                // [in]  хэндл окна
-)
+QError impl_ShowFigure(QHandle hFigure, bool bShow)
 {
-  if(hView==QHANDLE_INVALID)
-    return -1;
+  QSnpFigure* pFigure = QSnpFigureTable::find(hFigure);
+  if(!pFigure)
+    return QERR_ERROR;
 
-  QSnpListView* pView = (QSnpListView*)hView;
-  return pView->GetCurrentRow();
+  pFigure->setVisible(bShow);
+
+  return QERR_NO_ERROR;
 }
 
-// установить селекцию на элемент с номером raw
-QSNAP_API void SetListViewCurrentRow
+// функция показа/скрытия фигуры
+QSNAP_API QError ShowFigure
 (
-  QHandle       hView,               // [in]  хэндл окна
-  int           row                  // [in]  номер элемента
+  QHandle       hFigure,            // [in] хэндл фигуры
+  bool          bShow               // [in] показать/скрыть
 )
 {
-  if(hView==QHANDLE_INVALID)
-    return;
+  QError qerr = QERR_ERROR;
+  auto cmdShowFigure = [&]()
+  {
+    qerr = impl_ShowFigure(hFigure, bShow);
+  };
+  executeCommand(cmdShowFigure);
+  return qerr;
+}
 
-  QSnpListView* pView = (QSnpListView*)hView;
-  pView->SetCurrentRow(row);
+// фигура ищется и изменяется в потоке окна: там же ее рисуют и удаляют
+QError impl_RemoveFigure(QHandle hFigure)
+{
+  QSnpFigure* pFigure = QSnpFigureTable::find(hFigure);
+  if(!pFigure)
+    return QERR_ERROR;
+
+  QSnpView* pView = pFigure->getView();
+  QSnpFigureGroup* pGroup = pFigure->getGroup();
+  if(pGroup)
+    pGroup->removeFigure(pFigure);
+  else
+    delete pFigure;
+
+  QWidget* pWidget = pView ? pView->getWidget() : 0;
+  if(pWidget)
+    pWidget->update();
+  return QERR_NO_ERROR;
 }
 
-// установить селекцию на элемент с номером raw
-QSNAP_API void SetListViewSortingEnabled
+// функция удаления одной фигуры
+QSNAP_API QError RemoveFigure
 (
-  QHandle       hView,               // [in]  хэндл окна
-  bool          enable               // [in]  разрешить сортировку
+  QHandle       hFigure             // [in] хэндл фигуры
 )
 {
-  if(hView==QHANDLE_INVALID)
-    return;
+  QError qerr = QERR_ERROR;
+  auto cmdRemoveFigure = [&]()
+  {
+    qerr = impl_RemoveFigure(hFigure);
+  };
+  executeCommand(cmdRemoveFigure);
+  return qerr;
+}
 
-  QSnpListView* pView = (QSnpListView*)hView;
-  pView->SetSortingEnabled(enable);
+QError impl_MoveFigure(QHandle hFigure, int dx, int dy)
+{
+  QSnpFigure* pFigure = QSnpFigureTable::find(hFigure);
+  if(!pFigure)
+    return QERR_ERROR;
+
+  pFigure->move(dx, dy);
+  return QERR_NO_ERROR;
 }
 
-// номер элемента с данным текстом
-QSNAP_API void SortListViewItems
+// функция сдвига фигуры
+QSNAP_API QError MoveFigure
 (
-  QHandle       hView,               // [in]  хэндл окна
-  bool          orderAcsending       // [in]  сортировка по возростанию / по убыванию 
+  QHandle       hFigure,            // [in] хэндл фигуры
+  int           dx,                 // [in] сдвиг по горизонтали (в координатах изображения)
+  int           dy                  // [in] сдвиг по вертикали (в координатах изображения)
 )
 {
-  if(hView==QHANDLE_INVALID)
-    return;
-
-  QSnpListView* pView = (QSnpListView*)hView;
-  pView->SortItems(orderAcsending);
+  QError qerr = QERR_ERROR;
+  auto cmdMoveFigure = [&]()
+  {
+    qerr = impl_MoveFigure(hFigure, dx, dy);
+  };
+  executeCommand(cmdMoveFigure);
+  return qerr;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-////  Отрисовка фигур 
+QError impl_SetFigureColor(QHandle hFigure, SnpColor color)
+{
+  QSnpFigure* pFigure = QSnpFigureTable::find(hFigure);
+  if(!pFigure)
+    return QERR_ERROR;
 
-// установка коэффициента масштабирования фигур в координатах изображения
-QSNAP_API QHandle SetScaleFactor
+  pFigure->setColor(QColor_cast(color));
+  return QERR_NO_ERROR;
+}
+
+// функция изменения цвета фигуры
+QSNAP_API QError SetFigureColor
 (
-  QHandle       hView,              // [in] хэндл окна
-  double        scale,              // [in] коэффициент масштабирования
-  const char*   idGroup             // [in] идентификатор группы фигур (not implemented)
+  QHandle       hFigure,            // [in] хэндл фигуры
+  SnpColor      color               // [in] цвет
 )
 {
-  if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
-
-  QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->setScaleFactor(scale, idGroup);
+  QError qerr = QERR_ERROR;
+  auto cmdSetFigureColor = [&]()
+  {
+    qerr = impl_SetFigureColor(hFigure, color);
+  };
+  executeCommand(cmdSetFigureColor);
+  return qerr;
 }
 
-// отрисовка точки
-QSNAP_API QHandle DrawPoint         // [ret] хэндл фигуры
+// функция удаления всех фигур в данном окне
+QSNAP_API QError ClearFigures
 (
-  QHandle       hView,              // [in] хэндл окна
-  int           x,                  // [in] координата по горизонтали
-  int           y,                  // [in] координата по вертикали
-  int           ptWidth,            // [in] толщина точки (диаметр)
-  SnpColor      color,              // [in] цвет
-  const char*   idGroup             // [in] идентификатор группы фигур (для совместной работы)
+  QHandle       hView               // [in] хэндл окна
 )
 {
   if(hView==QHANDLE_INVALID)
     return QHANDLE_INVALID;
 
   QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->addPoint(x, y, ptWidth, color, idGroup);
+  return pView->clearFigures();
 }
 
-// отрисовка линии
-QSNAP_API QHandle DrawLine          // [ret] хэндл фигуры
+// функция показа/скрытия группы фигур
+QSNAP_API QError ShowGroup
 (
   QHandle       hView,              // [in] хэндл окна
-  int           xFrom,              // [in] координата начала по горизонтали
-  int           yFrom,              // [in] координата начала по вертикали
-  int           xTo,                // [in] координата конца по горизонтали
-  int           yTo,                // [in] координата конца по вертикали
-  int           lineWidth,          // [in] толщина линии
-  SnpColor      color,              // [in] цвет
-  LineType      type,               // [in] тип линии (линия, стрелка, пунктир и т.д.)
-  const char*   idGroup             // [in] идентификатор группы фигур
+  const char*   idGroup,            // [in] id группы фигур
+  bool          bShow               // [in] показать/скрыть
 )
 {
   if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
+    return QERR_ERROR;
 
   QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->addLine(xFrom, yFrom, xTo, yTo, lineWidth, color, type, idGroup);
+  return pView->showGroup(idGroup, bShow);
 }
 
-// отрисовка прямоугольника
-QSNAP_API QHandle DrawRect          // [ret] хэндл фигуры
+// функция удаления всех фигур группы
+QSNAP_API QError ClearGroup
 (
-  QHandle         hView,            // [in] хэндл окна
-  QSnp::SnpRect*  pRect,            // [in] координаты прямоугольника
-  int             lineWidth,        // [in] толщина линии
-  SnpColor        color,            // [in] цвет
-  LineType        type,             // [in] тип линии (линия, пунктир и т.д.)
-  const char*     idGroup           // [in] идентификатор группы фигур
+  QHandle       hView,              // [in] хэндл окна
+  const char*   idGroup             // [in] id группы фигур
 )
 {
   if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
+    return QERR_ERROR;
 
   QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->addRect(pRect, lineWidth, color, type, idGroup);
+  return pView->clearGroup(idGroup);
 }
 
-// отрисовка прямоугольника
-QSNAP_API QHandle DrawEllipse       // [ret] хэндл фигуры
+// начало построения кадра оверлея
+QSNAP_API QError BeginOverlay
 (
   QHandle       hView,              // [in] хэндл окна
-  QSnp::SnpRect* pRect,             // [in] координаты прямоугольника
-  int           lineWidth,          // [in] толщина линии
-  SnpColor      color,              // [in] цвет
-  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
-  const char*   idGroup             // [in] идентификатор группы фигур
+  const char*   idGroup             // [in] id группы фигур
 )
 {
   if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
+    return QERR_ERROR;
 
   QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->addEllipse(pRect, lineWidth, color, type, idGroup);
+  return pView->beginOverlay(idGroup);
 }
 
-// отрисовка прямоугольника
-QSNAP_API QHandle DrawArc           // [ret] хэндл фигуры
+// показ построенных кадров оверлеев
+QSNAP_API QError impl_CommitOverlay
 (
-  QHandle       hView,              // [in] хэндл окна
-//  ...                             // [in] параметры дуги
-  int           lineWidth,          // [in] толщина линии
-  SnpColor      color,              // [in] цвет
-  LineType      type,               // [in] тип линии (линия, пунктир и т.д.)
-  const char*   idGroup             // [in] идентификатор группы фигур
+  QHandle       hView               // [in] хэндл окна
 )
 {
   if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
+    return QERR_ERROR;
 
-  return QERR_NOTIMPLEMENTED;
+  QSnpImageView* pView = (QSnpImageView*)hView;
+  return pView->commitOverlays();
 }
 
-// отрисовка текста
-QSNAP_API QHandle DrawText          // [ret] хэндл текста
+// показ построенных кадров оверлеев (подмена выполняется в потоке окна)
+QSNAP_API QError CommitOverlay
 (
-  QHandle       hView,              // [in] хэндл окна
-  SnpRect*      pRect,              // [in] координаты охватывающего прямоугольника
-  const char*   textValue,          // [in] текстовое значение
-  double        fontSize,           // [in] кегль шрифта
-  SnpColor      fontColor,          // [in] цвет шрифта
-  const char*   fontType,           // [in] тип шрифта
-  const char*   idGroup             // [in] идентификатор группы фигур
+  QHandle       hView               // [in] хэндл окна
 )
 {
-  if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
-
-  QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->addText(pRect, textValue, fontSize, fontColor, fontType, idGroup);
+  QError qerr = QERR_NO_ERROR;
+  auto cmdCommitOverlay = [&]()
+  {
+    qerr = impl_CommitOverlay(hView);
+  };
+  executeCommand(cmdCommitOverlay);
+  return qerr;
 }
 
-// функция показа/скрытия фигуры
-QSNAP_API QError ShowFigure
+// получение координат пользовательской точки
+QSNAP_API QError GetUserPoint
 (
-  QHandle       hFigure,            // [in] хэндл фигуры
-  bool          bShow               // [in] показать/скрыть
+  QHandle       hView,              // [in]  хэндл окна
+  QSnp::SnpPoint*  point            // [out] координаты точки
 )
 {
-  if(hFigure==QHANDLE_INVALID)
-    return QERR_ERROR;
-
-  QSnpFigure* pFigure = (QSnpFigure*)hFigure;
-  pFigure->setVisible(bShow);
-
-  return QERR_NO_ERROR;
+  return GetUserPointInGroup(hView, point, 0);
 }
 
-// функция удаления всех фигур в данном окне
-QSNAP_API QError ClearFigures
+// получение координат пользовательской точки в системе фигур группы
+QSNAP_API QError GetUserPointInGroup
 (
-  QHandle       hView               // [in] хэндл окна
+  QHandle       hView,              // [in]  хэндл окна
+  QSnp::SnpPoint*  point,           // [out] координаты точки
+  const char*   idGroup             // [in]  идентификатор группы фигур
 )
 {
   if(hView==QHANDLE_INVALID)
     return QHANDLE_INVALID;
 
   QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->clearFigures();
+  return pView->getUserPoint(point, idGroup);
 }
 
-// получение координат пользовательской точки
-QSNAP_API QError GetUserPoint
+// получение координат пользовательского многоугольника
+QSNAP_API QError GetUserPolygon
 (
   QHandle       hView,              // [in]  хэндл окна
-  QSnp::SnpPoint*  point            // [out] координаты точки
+  SnpPoint*     points,             // [in,out] массив точек многоугольника
+  int*          szPoints            // [in,out] размер массива
+)
+{
+  return GetUserPolygonInGroup(hView, points, szPoints, 0);
+}
+
+// получение координат пользовательского многоугольника в системе фигур группы
+QSNAP_API QError GetUserPolygonInGroup
+(
+  QHandle       hView,              // [in]  хэндл окна
+  SnpPoint*     points,             // [in,out] массив точек многоугольника
+  int*          szPoints,           // [in,out] размер массива
+  const char*   idGroup             // [in]  идентификатор группы фигур
 )
 {
   if(hView==QHANDLE_INVALID)
-    return QHANDLE_INVALID;
+    return QERR_ERROR;
 
   QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->getUserPoint(point);
+  return pView->getUserPolygon(points, szPoints, idGroup);
 }
 
 // получение координат пользовательского прямоугольника
@@ -1525,12 +2424,23 @@ QSNAP_API QError GetUserRect
   QHandle         hView,            // [in]  хэндл окна
   QSnp::SnpRect*  rect              // [out] координаты прямоугольника
 )
+{
+  return GetUserRectInGroup(hView, rect, 0);
+}
+
+// получение координат пользовательского прямоугольника в системе фигур группы
+QSNAP_API QError GetUserRectInGroup
+(
+  QHandle         hView,            // [in]  хэндл окна
+  QSnp::SnpRect*  rect,             // [out] координаты прямоугольника
+  const char*     idGroup           // [in]  идентификатор группы фигур
+)
 {
   if(hView==QHANDLE_INVALID)
     return QHANDLE_INVALID;
 
   QSnpImageView* pView = (QSnpImageView*)hView;
-  return pView->getUserRect(rect);
+  return pView->getUserRect(rect, idGroup);
 }
 
 // корректнный выход из функции WaitUserInput
@@ -1787,6 +2697,9 @@ QSNAP_API QError WaitUserInput
     qerr = impl_WaitUserInput(hView, waitFlags, pWaitOptions, pWaitResults); 
   };
   executeCommand(waitUserInpRun);
+
+  // изменения, сделанные пользователем во время ожидания, записываются в связанные переменные
+  QSnpBindingQueue::instance().apply();
   return qerr;
 }
 
@@ -1816,6 +2729,12 @@ QSNAP_API QHandle impl_AddControl         // [ret] хэндл элемента 
   QAction* pAction = pToolbar->addAction(pControlInfo->szCaption);
   pAction->setToolTip(pControlInfo->szDescription);
   pAction->connect(pAction, SIGNAL(triggered()), pToolbar, SLOT(onAction()) );
+  if(pControlInfo->type == CTRL_CHKBUTTON)
+  {
+    pAction->setCheckable(true);
+    pAction->setChecked(pControlInfo->bChecked);
+  }
+  pToolbar->addState(pAction);
 
   // установка хэндла события в pAction
   QVariant data = pEvent->handle();
@@ -1866,6 +2785,78 @@ QSNAP_API QError RemoveControl
   return hControl;
 }
 
+// панель управления, которой принадлежит элемент (0 - элемент не с панели снепа)
+static QSnpToolBar* controlToolbar(QHandle hControl)
+{
+  if(hControl==QHANDLE_NULL)
+    return 0;
+  QSnpToolBar* pToolbar = qobject_cast<QSnpToolBar*>(((QAction*)hControl)->parentWidget());
+  return pToolbar && pToolbar->getState((QAction*)hControl) ? pToolbar : 0;
+}
+
+// состояние элемента управления для чтения без вызова библиотеки
+QSNAP_API const SnapState* GetControlState
+(
+  QHandle         hControl          // [in]  хэндл элемента управления
+)
+{
+  QSnpToolBar* pToolbar = controlToolbar(hControl);
+  return pToolbar ? pToolbar->getState((QAction*)hControl) : 0;
+}
+
+QSNAP_API QError impl_SetControlState
+(
+  QHandle         hControl,         // [in]  хэндл элемента управления
+  StateFlags      flag,             // [in]  флаг SF_CHECKED или SF_ENABLED
+  bool            bSet              // [in]  установить/сбросить
+)
+{
+  if(!controlToolbar(hControl))
+    return QERR_ERROR;
+
+  // опубликованное состояние обновляется панелью по сигналу действия
+  QAction* pAction = (QAction*)hControl;
+  if(flag == SF_CHECKED)
+    pAction->setChecked(bSet);
+  else if(flag == SF_ENABLED)
+    pAction->setEnabled(bSet);
+  else
+    return QERR_ERROR;
+  return QERR_NO_ERROR;
+}
+
+// нажатие/отпускание кнопки с фиксацией
+QSNAP_API QError CheckControl
+(
+  QHandle         hControl,         // [in]  хэндл элемента управления
+  bool            bCheck            // [in]  нажать/отпустить
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdCheckControl = [&]()
+  {
+    qerr = impl_SetControlState(hControl, SF_CHECKED, bCheck);
+  };
+  executeCommand(cmdCheckControl);
+  return qerr;
+}
+
+// включение/отключение элемента управления
+QSNAP_API QError EnableControl
+(
+  QHandle         hControl,         // [in]  хэндл элемента управления
+  bool            bEnable           // [in]  включить/отключить
+)
+{
+  QError qerr = QERR_NO_ERROR;
+  auto cmdEnableControl = [&]()
+  {
+    qerr = impl_SetControlState(hControl, SF_ENABLED, bEnable);
+  };
+  executeCommand(cmdEnableControl);
+  return qerr;
+}
+
 QSNAP_API QHandle LoadExternalWidgetDll(const char* dllname)
 {
   QHandle hDLib = QSpxLoadSpecialLibrary(dllname);
@@ -1939,4 +2930,4 @@ QSNAP_API QError CloseWidget(QHandle hDll, QHandle pWidget)
 
   return qerr;
 }
-}; // namespace QSnp
\ No newline at end of file
+}; // namespace QSnp
@@ -0,0 +1,144 @@
+// Замер цикла "очистка - 10000 фигур - перерисовка" в ImageView.
+// Сравниваются: отдельные вызовы Draw* после ClearFigures, те же вызовы
+// через оверлей (BeginOverlay/CommitOverlay) и один вызов DrawRects.
+
+#include <opencv2/core/core.hpp>
+
+#include <qsnap/qsnapx.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+using namespace QSnp;
+
+static const int nFigures = 10000;    // фигур в кадре
+static const int nFrames  = 50;       // кадров в замере
+static const int nWidth   = 1280;
+static const int nHeight  = 720;
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point t0)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// координаты прямоугольников кадра (сдвигаются от кадра к кадру)
+static void makeRects(int nFrame, std::vector<SnpRect>& rects)
+{
+  rects.resize(nFigures);
+  for(int i = 0; i < nFigures; i++)
+  {
+    SnpRect rc = { (i*37 + nFrame*5) % (nWidth-20), (i*91 + nFrame*3) % (nHeight-20), 12, 8 };
+    rects[i] = rc;
+  }
+}
+
+// кадр отдельными вызовами Draw* (как в существующем коде приложений)
+static void drawFigures(QSpxImageView* pImageView, const std::vector<SnpRect>& rects, const char* idGroup)
+{
+  for(int i = 0; i < nFigures; i++)
+  {
+    const SnpRect& rc = rects[i];
+    switch(i % 3)
+    {
+    case 0:
+      pImageView->drawRect(rc, 1, RGB(255, 0, 0), LT_LINE, idGroup);
+      break;
+    case 1:
+      pImageView->drawLine(rc.x, rc.y, rc.x+rc.width, rc.y+rc.height, 1, RGB(0, 255, 0), LT_LINE, idGroup);
+      break;
+    default:
+      pImageView->drawPoint(rc.x, rc.y, 3, RGB(0, 0, 255), idGroup);
+      break;
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  static QSpxInstance snpInstance;
+  snpInstance.initialize(false);
+
+  QSpxTextView* pTextView = static_cast<QSpxTextView*>(snpInstance.createView(QSnp::VT_TEXT_VIEW,  "BenchLog"));
+  QSpxImageView* pImageView = static_cast<QSpxImageView*>(snpInstance.createView(QSnp::VT_IMAGE_VIEW,  "BenchView"));
+  if(!pImageView)
+    return 0;
+
+  cv::Mat image(nHeight, nWidth, CV_8UC3, cv::Scalar(40, 40, 40));
+  pImageView->setImage(image);
+
+  std::vector<SnpRect> rects;
+  double msDraw = 0, msUpdate = 0;
+
+  // 1. ClearFigures + отдельные Draw* + перерисовка
+  for(int nFrame = 0; nFrame < nFrames; nFrame++)
+  {
+    makeRects(nFrame, rects);
+    Clock::time_point t0 = Clock::now();
+    pImageView->clearFigures();
+    drawFigures(pImageView, rects, NULL);
+    msDraw += msSince(t0);
+
+    t0 = Clock::now();
+    pImageView->update();
+    msUpdate += msSince(t0);
+  }
+  printf("clear + %d Draw* : build %.2f ms, repaint %.2f ms per frame\n",
+    nFigures, msDraw/nFrames, msUpdate/nFrames);
+  QW_SAFECALL(pTextView)->logLn("clear + %d Draw* : build %.2f ms, repaint %.2f ms per frame",
+    nFigures, msDraw/nFrames, msUpdate/nFrames);
+  pImageView->clearFigures();
+
+  // 2. те же фигуры через оверлей: очистка прошлого кадра в BeginOverlay, подмена в CommitOverlay
+  msDraw = msUpdate = 0;
+  double msCommit = 0;
+  for(int nFrame = 0; nFrame < nFrames; nFrame++)
+  {
+    makeRects(nFrame, rects);
+    Clock::time_point t0 = Clock::now();
+    pImageView->beginOverlay("bench");
+    drawFigures(pImageView, rects, "bench");
+    msDraw += msSince(t0);
+
+    t0 = Clock::now();
+    pImageView->commitOverlay();
+    msCommit += msSince(t0);
+
+    t0 = Clock::now();
+    pImageView->update();
+    msUpdate += msSince(t0);
+  }
+  printf("overlay %d Draw* : build %.2f ms, commit %.3f ms, repaint %.2f ms per frame\n",
+    nFigures, msDraw/nFrames, msCommit/nFrames, msUpdate/nFrames);
+  QW_SAFECALL(pTextView)->logLn("overlay %d Draw* : build %.2f ms, commit %.3f ms, repaint %.2f ms per frame",
+    nFigures, msDraw/nFrames, msCommit/nFrames, msUpdate/nFrames);
+  pImageView->clearGroup("bench");
+
+  // 3. один вызов DrawRects на кадр
+  msDraw = msUpdate = 0;
+  for(int nFrame = 0; nFrame < nFrames; nFrame++)
+  {
+    makeRects(nFrame, rects);
+    Clock::time_point t0 = Clock::now();
+    pImageView->clearFigures();
+    pImageView->drawRects(&rects[0], nFigures, 1, RGB(255, 0, 0), LT_LINE, NULL);
+    msDraw += msSince(t0);
+
+    t0 = Clock::now();
+    pImageView->update();
+    msUpdate += msSince(t0);
+  }
+  printf("clear + DrawRects(%d) : build %.2f ms, repaint %.2f ms per frame\n",
+    nFigures, msDraw/nFrames, msUpdate/nFrames);
+  QW_SAFECALL(pTextView)->logLn("clear + DrawRects(%d) : build %.2f ms, repaint %.2f ms per frame",
+    nFigures, msDraw/nFrames, msUpdate/nFrames);
+
+  delete pImageView;
+  delete pTextView;
+
+  snpInstance.terminate();
+  return 0;
+}